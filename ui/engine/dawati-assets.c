@@ -0,0 +1,154 @@
+/*
+ * dawati-gtk-engine - A GTK+ theme engine for Dawati
+ *
+ * Copyright (c) 2011, Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "dawati-assets.h"
+#include "dawati-atlas.h"
+
+/* full filename to surface, or NULL if it could not be loaded; the
+ * surfaces are kept until exit, a theme only has a few dozen */
+static GHashTable *assets = NULL;
+static gsize assets_bytes = 0;
+
+/* directory to its atlas, or NULL if it has none */
+static GHashTable *atlases = NULL;
+static gsize atlases_bytes = 0;
+static guint atlas_hits = 0;
+
+G_LOCK_DEFINE_STATIC (assets);
+
+static DawatiAtlas *
+dawati_assets_get_atlas (const gchar *dirname)
+{
+  DawatiAtlas *atlas;
+  gpointer value;
+  gchar *path;
+
+  if (!atlases)
+    atlases = g_hash_table_new (g_str_hash, g_str_equal);
+
+  if (g_hash_table_lookup_extended (atlases, dirname, NULL, &value))
+    return value;
+
+  path = g_strconcat (dirname, ".atlas", NULL);
+  atlas = dawati_atlas_open (path);
+  g_free (path);
+
+  g_hash_table_insert (atlases, g_strdup (dirname), atlas);
+  if (atlas)
+    atlases_bytes += dawati_atlas_get_size (atlas);
+
+  return atlas;
+}
+
+/* from the atlas of the file's directory if it is packed there, which
+ * costs no decoding and no private memory */
+static cairo_surface_t *
+dawati_assets_load_from_atlas (const gchar *filename)
+{
+  cairo_surface_t *surface = NULL;
+  DawatiAtlas *atlas;
+  gchar *dirname;
+  gchar *basename;
+
+  dirname = g_path_get_dirname (filename);
+  atlas = dawati_assets_get_atlas (dirname);
+  g_free (dirname);
+
+  if (!atlas)
+    return NULL;
+
+  basename = g_path_get_basename (filename);
+  surface = dawati_atlas_get_surface (atlas, basename);
+  g_free (basename);
+
+  if (surface && cairo_surface_status (surface) != CAIRO_STATUS_SUCCESS)
+    {
+      cairo_surface_destroy (surface);
+      surface = NULL;
+    }
+
+  return surface;
+}
+
+static cairo_surface_t *
+dawati_assets_load (const gchar *filename)
+{
+  cairo_surface_t *surface;
+
+  surface = dawati_assets_load_from_atlas (filename);
+  if (surface)
+    {
+      atlas_hits++;
+      return surface;
+    }
+
+  surface = cairo_image_surface_create_from_png (filename);
+  if (cairo_surface_status (surface) != CAIRO_STATUS_SUCCESS)
+    {
+      g_warning ("Unable to load %s: %s", filename,
+                 cairo_status_to_string (cairo_surface_status (surface)));
+      cairo_surface_destroy (surface);
+      return NULL;
+    }
+
+  assets_bytes += (gsize) cairo_image_surface_get_stride (surface)
+    * cairo_image_surface_get_height (surface);
+
+  return surface;
+}
+
+/* Returns the surface for filename, not a reference, or NULL if it could
+ * not be loaded. */
+cairo_surface_t *
+dawati_assets_get (const gchar *filename)
+{
+  cairo_surface_t *surface;
+  gpointer value;
+
+  G_LOCK (assets);
+
+  if (!assets)
+    assets = g_hash_table_new (g_str_hash, g_str_equal);
+
+  if (g_hash_table_lookup_extended (assets, filename, NULL, &value))
+    {
+      G_UNLOCK (assets);
+      return value;
+    }
+
+  surface = dawati_assets_load (filename);
+  g_hash_table_insert (assets, g_strdup (filename), surface);
+
+  G_UNLOCK (assets);
+
+  return surface;
+}
+
+void
+dawati_assets_print_stats (void)
+{
+  if (!assets)
+    return;
+
+  g_printerr ("assets: files = %u; from atlas = %u; bytes = %lu; "
+              "mapped = %lu;\n",
+              g_hash_table_size (assets), atlas_hits, (gulong) assets_bytes,
+              (gulong) atlases_bytes);
+}
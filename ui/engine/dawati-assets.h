@@ -0,0 +1,39 @@
+/*
+ * dawati-gtk-engine - A GTK+ theme engine for Dawati
+ *
+ * Copyright (c) 2011, Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef _DAWATI_ASSETS_H
+#define _DAWATI_ASSETS_H
+
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+/* The images named in image blocks, as premultiplied cairo image surfaces
+ * shared by every style. They are mapped from the atlas of their directory
+ * when there is one (see dawati-atlas.h), and otherwise decoded once for
+ * the whole process. */
+
+cairo_surface_t *dawati_assets_get         (const gchar *filename);
+
+void             dawati_assets_print_stats (void);
+
+G_END_DECLS
+
+#endif /* _DAWATI_ASSETS_H */
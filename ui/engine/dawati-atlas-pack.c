@@ -0,0 +1,226 @@
+/*
+ * dawati-gtk-engine - A GTK+ theme engine for Dawati
+ *
+ * Copyright (c) 2011, Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+
+/* Packs PNG files into an atlas the engine maps instead of decoding them,
+ * see dawati-atlas.h:
+ *
+ *   ./dawati-atlas-pack Assets.atlas Assets/button.png Assets/entry.png ...
+ *
+ * The images are placed on shelves, tallest first, without padding as the
+ * engine only ever reads inside the rectangle of an image. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <string.h>
+
+#include "dawati-atlas.h"
+
+/* wide enough for a few of the largest assets side by side */
+#define ATLAS_MIN_WIDTH 512
+
+typedef struct
+{
+  gchar           *name;
+  cairo_surface_t *surface;
+  gint             x;
+  gint             y;
+  gint             width;
+  gint             height;
+} Image;
+
+static gint
+image_compare_height (gconstpointer a,
+                      gconstpointer b)
+{
+  const Image *ia = *(const Image **) a;
+  const Image *ib = *(const Image **) b;
+
+  if (ia->height != ib->height)
+    return ib->height - ia->height;
+
+  return strcmp (ia->name, ib->name);
+}
+
+static gint
+image_compare_name (gconstpointer a,
+                    gconstpointer b)
+{
+  return strcmp ((*(const Image **) a)->name, (*(const Image **) b)->name);
+}
+
+/* Places the images on shelves of the given width, returns the height. */
+static gint
+pack (GPtrArray *images,
+      gint       width)
+{
+  gint x = 0, y = 0, shelf = 0;
+  guint i;
+
+  g_ptr_array_sort (images, image_compare_height);
+
+  for (i = 0; i < images->len; i++)
+    {
+      Image *image = g_ptr_array_index (images, i);
+
+      if (x + image->width > width)
+        {
+          x = 0;
+          y += shelf;
+          shelf = 0;
+        }
+
+      image->x = x;
+      image->y = y;
+      x += image->width;
+      shelf = MAX (shelf, image->height);
+    }
+
+  return y + shelf;
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  DawatiAtlasHeader header = { 0, };
+  DawatiAtlasEntry *entries;
+  GPtrArray *images;
+  cairo_surface_t *atlas;
+  cairo_t *cr;
+  GError *error = NULL;
+  gchar *contents;
+  gsize size;
+  gint width = ATLAS_MIN_WIDTH, height;
+  guint i;
+
+  if (argc < 2)
+    {
+      g_printerr ("Usage: %s ATLAS PNG...\n", argv[0]);
+      return 1;
+    }
+
+  images = g_ptr_array_new ();
+
+  for (i = 2; i < (guint) argc; i++)
+    {
+      Image *image = g_new0 (Image, 1);
+
+      image->name = g_path_get_basename (argv[i]);
+      if (strlen (image->name) >= sizeof (entries->name))
+        {
+          g_printerr ("%s: the name is too long for an atlas\n", argv[i]);
+          return 1;
+        }
+
+      image->surface = cairo_image_surface_create_from_png (argv[i]);
+      if (cairo_surface_status (image->surface) != CAIRO_STATUS_SUCCESS)
+        {
+          g_printerr ("%s: %s\n", argv[i], cairo_status_to_string
+                      (cairo_surface_status (image->surface)));
+          return 1;
+        }
+
+      image->width = cairo_image_surface_get_width (image->surface);
+      image->height = cairo_image_surface_get_height (image->surface);
+      width = MAX (width, image->width);
+
+      g_ptr_array_add (images, image);
+    }
+
+  height = pack (images, width);
+
+  /* ARGB32 whatever the format of each file, RGB24 ones become opaque */
+  atlas = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, width,
+                                      MAX (height, 1));
+  cr = cairo_create (atlas);
+  cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
+
+  for (i = 0; i < images->len; i++)
+    {
+      Image *image = g_ptr_array_index (images, i);
+
+      cairo_set_source_surface (cr, image->surface, image->x, image->y);
+      cairo_rectangle (cr, image->x, image->y, image->width, image->height);
+      cairo_fill (cr);
+    }
+
+  cairo_destroy (cr);
+  cairo_surface_flush (atlas);
+
+  if (cairo_surface_status (atlas) != CAIRO_STATUS_SUCCESS)
+    {
+      g_printerr ("%s: %s\n", argv[1],
+                  cairo_status_to_string (cairo_surface_status (atlas)));
+      return 1;
+    }
+
+  header.magic = DAWATI_ATLAS_MAGIC;
+  header.n_entries = images->len;
+  header.width = width;
+  header.height = height;
+  header.stride = cairo_image_surface_get_stride (atlas);
+  header.data_offset = sizeof (header) + images->len * sizeof (*entries);
+  header.data_offset = (header.data_offset + DAWATI_ATLAS_ALIGN - 1)
+    / DAWATI_ATLAS_ALIGN * DAWATI_ATLAS_ALIGN;
+
+  size = header.data_offset + (gsize) header.stride * height;
+  contents = g_malloc0 (size);
+  memcpy (contents, &header, sizeof (header));
+
+  /* the engine looks names up with bsearch */
+  g_ptr_array_sort (images, image_compare_name);
+
+  entries = (DawatiAtlasEntry *) (contents + sizeof (header));
+  for (i = 0; i < images->len; i++)
+    {
+      Image *image = g_ptr_array_index (images, i);
+
+      if (i > 0 && !strcmp (image->name, entries[i - 1].name))
+        {
+          g_printerr ("%s: more than one file is named %s\n", argv[1],
+                      image->name);
+          return 1;
+        }
+
+      strcpy (entries[i].name, image->name);
+      entries[i].x = image->x;
+      entries[i].y = image->y;
+      entries[i].width = image->width;
+      entries[i].height = image->height;
+    }
+
+  memcpy (contents + header.data_offset, cairo_image_surface_get_data (atlas),
+          (gsize) header.stride * height);
+
+  if (!g_file_set_contents (argv[1], contents, size, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      return 1;
+    }
+
+  printf ("%s: %u images in %dx%d, %lu bytes\n", argv[1], images->len,
+          width, height, (gulong) size);
+
+  return 0;
+}
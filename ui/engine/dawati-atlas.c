@@ -0,0 +1,154 @@
+/*
+ * dawati-gtk-engine - A GTK+ theme engine for Dawati
+ *
+ * Copyright (c) 2011, Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+
+#include "dawati-atlas.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+struct _DawatiAtlas
+{
+  const guint8            *map;
+  gsize                    size;
+  const DawatiAtlasHeader *header;
+  const DawatiAtlasEntry  *entries;
+};
+
+static gboolean
+dawati_atlas_check (const guint8 *map,
+                    gsize         size)
+{
+  const DawatiAtlasHeader *header = (const DawatiAtlasHeader *) map;
+  const DawatiAtlasEntry *entries;
+  guint i;
+
+  if (size < sizeof (DawatiAtlasHeader)
+      || header->magic != DAWATI_ATLAS_MAGIC)
+    return FALSE;
+
+  /* the entries, then the pixels, both inside the file; the divisions
+   * can't overflow where data_offset + stride * height could */
+  if (header->data_offset < sizeof (DawatiAtlasHeader)
+      || header->data_offset % DAWATI_ATLAS_ALIGN
+      || header->data_offset > size
+      || header->n_entries > (header->data_offset - sizeof (DawatiAtlasHeader))
+         / sizeof (DawatiAtlasEntry)
+      || header->stride == 0
+      || header->stride != (guint32)
+         cairo_format_stride_for_width (CAIRO_FORMAT_ARGB32, header->width)
+      || header->height > (size - header->data_offset) / header->stride)
+    return FALSE;
+
+  entries = (const DawatiAtlasEntry *) (header + 1);
+  for (i = 0; i < header->n_entries; i++)
+    {
+      if (!memchr (entries[i].name, '\0', sizeof (entries[i].name))
+          || entries[i].x > header->width
+          || entries[i].width > header->width - entries[i].x
+          || entries[i].y > header->height
+          || entries[i].height > header->height - entries[i].y)
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* Maps filename, or returns NULL if there is none or it isn't an atlas
+ * this engine can use. The mapping is kept until exit. */
+DawatiAtlas *
+dawati_atlas_open (const gchar *filename)
+{
+  DawatiAtlas *atlas;
+  struct stat st;
+  void *map;
+  int fd;
+
+  fd = open (filename, O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return NULL;
+
+  if (fstat (fd, &st) < 0 || st.st_size <= 0)
+    {
+      close (fd);
+      return NULL;
+    }
+
+  map = mmap (NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close (fd);
+  if (map == MAP_FAILED)
+    return NULL;
+
+  if (!dawati_atlas_check (map, st.st_size))
+    {
+      g_warning ("Ignoring %s, it is not a usable atlas", filename);
+      munmap (map, st.st_size);
+      return NULL;
+    }
+
+  atlas = g_slice_new (DawatiAtlas);
+  atlas->map = map;
+  atlas->size = st.st_size;
+  atlas->header = map;
+  atlas->entries = (const DawatiAtlasEntry *) (atlas->header + 1);
+
+  return atlas;
+}
+
+static int
+dawati_atlas_entry_compare (const void *name,
+                            const void *entry)
+{
+  return strcmp (name, ((const DawatiAtlasEntry *) entry)->name);
+}
+
+/* Returns a new surface on the pixels of name, which must not be drawn to,
+ * or NULL if the atlas has no such image. */
+cairo_surface_t *
+dawati_atlas_get_surface (DawatiAtlas *atlas,
+                          const gchar *name)
+{
+  const DawatiAtlasEntry *entry;
+  const guint8 *data;
+
+  entry = bsearch (name, atlas->entries, atlas->header->n_entries,
+                   sizeof (DawatiAtlasEntry), dawati_atlas_entry_compare);
+  if (!entry)
+    return NULL;
+
+  data = atlas->map + atlas->header->data_offset
+    + entry->y * atlas->header->stride + entry->x * 4;
+
+  /* cairo only reads from a surface that is a source */
+  return cairo_image_surface_create_for_data ((guint8 *) data,
+                                              CAIRO_FORMAT_ARGB32,
+                                              entry->width, entry->height,
+                                              atlas->header->stride);
+}
+
+gsize
+dawati_atlas_get_size (DawatiAtlas *atlas)
+{
+  return atlas->size;
+}
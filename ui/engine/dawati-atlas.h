@@ -0,0 +1,74 @@
+/*
+ * dawati-gtk-engine - A GTK+ theme engine for Dawati
+ *
+ * Copyright (c) 2011, Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+
+#ifndef _DAWATI_ATLAS_H
+#define _DAWATI_ATLAS_H
+
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+/* An atlas packs the PNG files of a directory into a single image, decoded
+ * at build time by dawati-atlas-pack and mapped read-only by the engine, so
+ * that no process inflates them at start up and all of them share the
+ * pages. The atlas of "Assets/" is the file "Assets.atlas" next to it.
+ *
+ * The file is a header, the entries sorted by name, then from data_offset
+ * the pixels as premultiplied ARGB32 rows of cairo's stride for the width.
+ * Integers are in the byte order of the machine that packed it, and an
+ * atlas with the magic the wrong way round is ignored. */
+
+#define DAWATI_ATLAS_MAGIC 0x31415744   /* "DWA1" on little endian */
+
+/* data_offset is a multiple of this, for the pixels to be page aligned */
+#define DAWATI_ATLAS_ALIGN 4096
+
+typedef struct
+{
+  guint32 magic;
+  guint32 n_entries;
+  guint32 width;
+  guint32 height;
+  guint32 stride;
+  guint32 data_offset;
+} DawatiAtlasHeader;
+
+typedef struct
+{
+  gchar   name[56];     /* the basename, nul terminated */
+  guint32 x;
+  guint32 y;
+  guint32 width;
+  guint32 height;
+} DawatiAtlasEntry;
+
+typedef struct _DawatiAtlas DawatiAtlas;
+
+DawatiAtlas     *dawati_atlas_open        (const gchar *filename);
+
+cairo_surface_t *dawati_atlas_get_surface (DawatiAtlas *atlas,
+                                           const gchar *name);
+
+gsize            dawati_atlas_get_size    (DawatiAtlas *atlas);
+
+G_END_DECLS
+
+#endif /* _DAWATI_ATLAS_H */
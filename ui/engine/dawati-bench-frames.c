@@ -0,0 +1,484 @@
+/*
+ * dawati-gtk-engine - A GTK+ theme engine for Dawati
+ *
+ * Copyright (c) 2011, Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/* Measures wall-clock frame times for realistic workloads: scrolling a
+ * large tree view, switching notebook tabs, hovering toolbar buttons and
+ * changing the widgets of a dialog. Each frame applies one change, then
+ * waits until the window has been redrawn and the X server has processed
+ * every request. One JSON object is printed per scenario.
+ *
+ * Run it once with the dawati theme and once with --stock to compare with
+ * the stock GTK+ style, for example:
+ *
+ *   xvfb-run -a ./dawati-bench-frames
+ *   xvfb-run -a ./dawati-bench-frames --stock
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <string.h>
+
+#include "dawati-bench-utils.h"
+
+#define WINDOW_WIDTH 800
+#define WINDOW_HEIGHT 600
+
+#define TREE_VIEW_ROWS 10000
+#define NOTEBOOK_PAGES 40
+#define TOOLBAR_BUTTONS 20
+#define DIALOG_ROWS 8
+
+typedef struct _Scenario Scenario;
+
+struct _Scenario
+{
+  const gchar *name;
+  GtkWidget *(*create) (Scenario *scenario);
+  void       (*step)   (Scenario *scenario,
+                        guint     frame);
+
+  GtkWidget *window;
+  GPtrArray *widgets;
+  gpointer   data;
+};
+
+static gint n_frames = 300;
+static gint n_warmup = 20;
+static gboolean stock = FALSE;
+static gchar *only = NULL;
+
+static GOptionEntry options[] = {
+  { "frames", 'n', 0, G_OPTION_ARG_INT, &n_frames,
+    "Frames to time per scenario", "N" },
+  { "warmup", 'w', 0, G_OPTION_ARG_INT, &n_warmup,
+    "Untimed frames before timing starts", "N" },
+  { "stock", 's', 0, G_OPTION_ARG_NONE, &stock,
+    "Use the stock GTK+ style instead of the dawati theme", NULL },
+  { "scenario", 'S', 0, G_OPTION_ARG_STRING, &only,
+    "Only run the named scenario", "NAME" },
+  { NULL }
+};
+
+static void
+flush_frame (void)
+{
+  /* handle whatever the change caused, paint, and wait for the server */
+  while (gtk_events_pending ())
+    gtk_main_iteration_do (FALSE);
+
+  gdk_window_process_all_updates ();
+  gdk_flush ();
+}
+
+/* tree view */
+
+static GtkWidget *
+tree_view_create (Scenario *scenario)
+{
+  GtkListStore *store;
+  GtkWidget *scrolled, *view;
+  GtkTreeIter iter;
+  gint i;
+
+  store = gtk_list_store_new (4, G_TYPE_BOOLEAN, G_TYPE_STRING,
+                              G_TYPE_STRING, G_TYPE_INT);
+
+  for (i = 0; i < TREE_VIEW_ROWS; i++)
+    {
+      gchar *name = g_strdup_printf ("Row %d", i);
+
+      gtk_list_store_append (store, &iter);
+      gtk_list_store_set (store, &iter,
+                          0, i % 3 == 0,
+                          1, name,
+                          2, "Lorem ipsum dolor sit amet",
+                          3, i * 7,
+                          -1);
+      g_free (name);
+    }
+
+  view = gtk_tree_view_new_with_model (GTK_TREE_MODEL (store));
+  g_object_unref (store);
+
+  gtk_tree_view_set_headers_visible (GTK_TREE_VIEW (view), TRUE);
+  gtk_tree_view_set_rules_hint (GTK_TREE_VIEW (view), TRUE);
+  gtk_tree_view_insert_column_with_attributes (GTK_TREE_VIEW (view), -1,
+                                               "Done",
+                                               gtk_cell_renderer_toggle_new (),
+                                               "active", 0, NULL);
+  gtk_tree_view_insert_column_with_attributes (GTK_TREE_VIEW (view), -1,
+                                               "Name",
+                                               gtk_cell_renderer_text_new (),
+                                               "text", 1, NULL);
+  gtk_tree_view_insert_column_with_attributes (GTK_TREE_VIEW (view), -1,
+                                               "Description",
+                                               gtk_cell_renderer_text_new (),
+                                               "text", 2, NULL);
+  gtk_tree_view_insert_column_with_attributes (GTK_TREE_VIEW (view), -1,
+                                               "Size",
+                                               gtk_cell_renderer_text_new (),
+                                               "text", 3, NULL);
+
+  scrolled = gtk_scrolled_window_new (NULL, NULL);
+  gtk_scrolled_window_set_policy (GTK_SCROLLED_WINDOW (scrolled),
+                                  GTK_POLICY_AUTOMATIC, GTK_POLICY_ALWAYS);
+  gtk_container_add (GTK_CONTAINER (scrolled), view);
+
+  scenario->data = gtk_scrolled_window_get_vadjustment
+    (GTK_SCROLLED_WINDOW (scrolled));
+
+  return scrolled;
+}
+
+static void
+tree_view_step (Scenario *scenario,
+                guint     frame)
+{
+  GtkAdjustment *adjustment = scenario->data;
+  gdouble value;
+
+  /* scroll a few rows at a time, starting over at the end */
+  value = adjustment->value + adjustment->step_increment * 3;
+  if (value > adjustment->upper - adjustment->page_size)
+    value = adjustment->lower;
+
+  gtk_adjustment_set_value (adjustment, value);
+}
+
+/* notebook */
+
+static GtkWidget *
+notebook_create (Scenario *scenario)
+{
+  GtkWidget *notebook;
+  gint i;
+
+  notebook = gtk_notebook_new ();
+  gtk_notebook_set_scrollable (GTK_NOTEBOOK (notebook), TRUE);
+
+  for (i = 0; i < NOTEBOOK_PAGES; i++)
+    {
+      GtkWidget *page, *label;
+      gchar *text;
+
+      page = gtk_vbox_new (FALSE, 6);
+      gtk_container_set_border_width (GTK_CONTAINER (page), 12);
+
+      text = g_strdup_printf ("Contents of page %d", i);
+      gtk_box_pack_start (GTK_BOX (page), gtk_label_new (text),
+                          FALSE, FALSE, 0);
+      g_free (text);
+
+      gtk_box_pack_start (GTK_BOX (page), gtk_entry_new (), FALSE, FALSE, 0);
+      gtk_box_pack_start (GTK_BOX (page),
+                          gtk_check_button_new_with_label ("Option"),
+                          FALSE, FALSE, 0);
+      gtk_box_pack_start (GTK_BOX (page),
+                          gtk_button_new_from_stock (GTK_STOCK_APPLY),
+                          FALSE, FALSE, 0);
+
+      text = g_strdup_printf ("Tab %d", i);
+      label = gtk_label_new (text);
+      g_free (text);
+
+      gtk_notebook_append_page (GTK_NOTEBOOK (notebook), page, label);
+    }
+
+  scenario->data = notebook;
+
+  return notebook;
+}
+
+static void
+notebook_step (Scenario *scenario,
+               guint     frame)
+{
+  gtk_notebook_set_current_page (GTK_NOTEBOOK (scenario->data),
+                                 (frame + 1) % NOTEBOOK_PAGES);
+}
+
+/* toolbar */
+
+static const gchar *toolbar_stock[] = {
+  GTK_STOCK_NEW, GTK_STOCK_OPEN, GTK_STOCK_SAVE, GTK_STOCK_PRINT,
+  GTK_STOCK_CUT, GTK_STOCK_COPY, GTK_STOCK_PASTE, GTK_STOCK_UNDO,
+  GTK_STOCK_REDO, GTK_STOCK_FIND
+};
+
+static GtkWidget *
+toolbar_create (Scenario *scenario)
+{
+  GtkWidget *vbox, *toolbar;
+  gint i;
+
+  vbox = gtk_vbox_new (FALSE, 0);
+  toolbar = gtk_toolbar_new ();
+  gtk_toolbar_set_style (GTK_TOOLBAR (toolbar), GTK_TOOLBAR_BOTH);
+
+  for (i = 0; i < TOOLBAR_BUTTONS; i++)
+    {
+      GtkToolItem *item;
+
+      item = gtk_tool_button_new_from_stock
+        (toolbar_stock[i % G_N_ELEMENTS (toolbar_stock)]);
+      gtk_toolbar_insert (GTK_TOOLBAR (toolbar), item, -1);
+
+      /* the button inside the tool item is what reacts to the pointer */
+      g_ptr_array_add (scenario->widgets, gtk_bin_get_child (GTK_BIN (item)));
+    }
+
+  gtk_box_pack_start (GTK_BOX (vbox), toolbar, FALSE, FALSE, 0);
+  gtk_box_pack_start (GTK_BOX (vbox), gtk_text_view_new (), TRUE, TRUE, 0);
+
+  return vbox;
+}
+
+static void
+send_crossing (GtkWidget    *button,
+               GdkEventType  type)
+{
+  GdkEvent *event;
+
+  event = gdk_event_new (type);
+  event->crossing.window = g_object_ref (GTK_BUTTON (button)->event_window);
+  event->crossing.send_event = TRUE;
+  event->crossing.time = GDK_CURRENT_TIME;
+  event->crossing.mode = GDK_CROSSING_NORMAL;
+  event->crossing.detail = GDK_NOTIFY_NONLINEAR;
+
+  gtk_widget_event (button, event);
+  gdk_event_free (event);
+}
+
+static void
+toolbar_step (Scenario *scenario,
+              guint     frame)
+{
+  GPtrArray *buttons = scenario->widgets;
+
+  /* move the pointer from one button to the next */
+  if (frame > 0)
+    send_crossing (g_ptr_array_index (buttons, (frame - 1) % buttons->len),
+                   GDK_LEAVE_NOTIFY);
+  send_crossing (g_ptr_array_index (buttons, frame % buttons->len),
+                 GDK_ENTER_NOTIFY);
+}
+
+/* dialog */
+
+static GtkWidget *
+dialog_create (Scenario *scenario)
+{
+  GtkWidget *table;
+  GSList *group = NULL;
+  gint i;
+
+  table = gtk_table_new (DIALOG_ROWS, 4, FALSE);
+  gtk_container_set_border_width (GTK_CONTAINER (table), 12);
+  gtk_table_set_row_spacings (GTK_TABLE (table), 6);
+  gtk_table_set_col_spacings (GTK_TABLE (table), 12);
+
+  for (i = 0; i < DIALOG_ROWS; i++)
+    {
+      GtkWidget *check, *radio, *spin, *combo;
+      gchar *text;
+
+      text = g_strdup_printf ("Check %d", i);
+      check = gtk_check_button_new_with_label (text);
+      g_free (text);
+
+      text = g_strdup_printf ("Radio %d", i);
+      radio = gtk_radio_button_new_with_label (group, text);
+      group = gtk_radio_button_get_group (GTK_RADIO_BUTTON (radio));
+      g_free (text);
+
+      spin = gtk_spin_button_new_with_range (0, 100, 1);
+
+      combo = gtk_combo_box_entry_new_text ();
+      gtk_combo_box_append_text (GTK_COMBO_BOX (combo), "First");
+      gtk_combo_box_append_text (GTK_COMBO_BOX (combo), "Second");
+      gtk_combo_box_set_active (GTK_COMBO_BOX (combo), 0);
+
+      gtk_table_attach_defaults (GTK_TABLE (table), check, 0, 1, i, i + 1);
+      gtk_table_attach_defaults (GTK_TABLE (table), radio, 1, 2, i, i + 1);
+      gtk_table_attach_defaults (GTK_TABLE (table), spin, 2, 3, i, i + 1);
+      gtk_table_attach_defaults (GTK_TABLE (table), combo, 3, 4, i, i + 1);
+
+      g_ptr_array_add (scenario->widgets, check);
+      g_ptr_array_add (scenario->widgets, radio);
+      g_ptr_array_add (scenario->widgets, spin);
+      g_ptr_array_add (scenario->widgets, gtk_bin_get_child (GTK_BIN (combo)));
+    }
+
+  return table;
+}
+
+static void
+dialog_step (Scenario *scenario,
+             guint     frame)
+{
+  GtkWidget *widget;
+
+  widget = g_ptr_array_index (scenario->widgets,
+                              frame % scenario->widgets->len);
+
+  /* toggle the buttons, and move the focus through everything */
+  if (GTK_IS_TOGGLE_BUTTON (widget))
+    gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (widget),
+                                  !gtk_toggle_button_get_active
+                                  (GTK_TOGGLE_BUTTON (widget)));
+  else if (GTK_IS_SPIN_BUTTON (widget))
+    gtk_spin_button_spin (GTK_SPIN_BUTTON (widget), GTK_SPIN_STEP_FORWARD, 1);
+
+  gtk_widget_grab_focus (widget);
+}
+
+static Scenario scenarios[] = {
+  { "tree-view-scroll", tree_view_create, tree_view_step },
+  { "notebook-switch", notebook_create, notebook_step },
+  { "toolbar-hover", toolbar_create, toolbar_step },
+  { "dialog-widgets", dialog_create, dialog_step },
+};
+
+static void
+scenario_run (Scenario *scenario,
+              gdouble  *samples)
+{
+  DawatiBenchStats stats;
+  GString *out;
+  gint i;
+
+  scenario->widgets = g_ptr_array_new ();
+
+  scenario->window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+  gtk_window_set_default_size (GTK_WINDOW (scenario->window),
+                               WINDOW_WIDTH, WINDOW_HEIGHT);
+  gtk_container_add (GTK_CONTAINER (scenario->window),
+                     scenario->create (scenario));
+  gtk_widget_show_all (scenario->window);
+
+  /* wait for the window to be mapped and painted for the first time */
+  while (!GTK_WIDGET_MAPPED (scenario->window))
+    gtk_main_iteration ();
+  flush_frame ();
+
+  for (i = 0; i < n_warmup; i++)
+    {
+      scenario->step (scenario, i);
+      flush_frame ();
+    }
+
+  for (i = 0; i < n_frames; i++)
+    {
+      guint64 start;
+
+      start = dawati_bench_now_ns ();
+
+      scenario->step (scenario, n_warmup + i);
+      flush_frame ();
+
+      samples[i] = (dawati_bench_now_ns () - start) / 1e6;
+    }
+
+  dawati_bench_stats_compute (samples, n_frames, &stats);
+
+  out = g_string_new ("{\"scenario\":");
+  dawati_bench_json_string (out, scenario->name);
+  g_string_append (out, ",\"theme\":");
+  dawati_bench_json_string (out, stock ? "stock" : "dawati");
+  g_string_append_printf (out,
+                          ",\"frames\":%d,\"mean_ms\":%.3f"
+                          ",\"p50_ms\":%.3f,\"p90_ms\":%.3f"
+                          ",\"p99_ms\":%.3f,\"max_ms\":%.3f}",
+                          n_frames, stats.mean,
+                          dawati_bench_percentile (samples, n_frames, 50),
+                          dawati_bench_percentile (samples, n_frames, 90),
+                          dawati_bench_percentile (samples, n_frames, 99),
+                          stats.max);
+
+  puts (out->str);
+  fflush (stdout);
+
+  g_string_free (out, TRUE);
+
+  gtk_widget_destroy (scenario->window);
+  g_ptr_array_free (scenario->widgets, TRUE);
+  flush_frame ();
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  GOptionContext *context;
+  GError *error = NULL;
+  gdouble *samples;
+  guint i;
+
+  /* the theme has to be chosen before GTK+ is initialised, so the options
+   * are parsed first and GTK+ is left to handle its own */
+  context = g_option_context_new ("- time redraws of common workloads");
+  g_option_context_add_main_entries (context, options, NULL);
+  g_option_context_set_ignore_unknown_options (context, TRUE);
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      return 1;
+    }
+  g_option_context_free (context);
+
+  if (n_frames < 1 || n_warmup < 0)
+    {
+      g_printerr ("frames must be positive\n");
+      return 1;
+    }
+
+  dawati_bench_init (&argc, &argv, stock);
+
+  if (!stock)
+    {
+      GtkStyle *style;
+
+      style = gtk_rc_get_style_by_paths (gtk_settings_get_default (),
+                                         NULL, NULL, GTK_TYPE_WINDOW);
+      if (!style || !dawati_bench_is_dawati (style))
+        {
+          g_printerr ("The dawati engine was not loaded\n");
+          return 1;
+        }
+    }
+
+  samples = g_new (gdouble, n_frames);
+
+  for (i = 0; i < G_N_ELEMENTS (scenarios); i++)
+    {
+      if (only && strcmp (only, scenarios[i].name) != 0)
+        continue;
+
+      scenario_run (&scenarios[i], samples);
+    }
+
+  g_free (samples);
+
+  return 0;
+}
@@ -0,0 +1,261 @@
+/*
+ * dawati-gtk-engine - A GTK+ theme engine for Dawati
+ *
+ * Copyright (c) 2011, Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <glib/gstdio.h>
+
+#include "dawati-bench-utils.h"
+
+/* Count every allocation made by the process, including the ones made by
+ * cairo, pixman and Xlib, by interposing the malloc family. */
+#ifdef __GLIBC__
+extern void *__libc_malloc (size_t size);
+extern void *__libc_calloc (size_t n_members, size_t size);
+extern void *__libc_realloc (void *ptr, size_t size);
+
+static volatile guint64 n_allocs = 0;
+
+void *
+malloc (size_t size)
+{
+  n_allocs++;
+  return __libc_malloc (size);
+}
+
+void *
+calloc (size_t n_members,
+        size_t size)
+{
+  n_allocs++;
+  return __libc_calloc (n_members, size);
+}
+
+void *
+realloc (void   *ptr,
+         size_t  size)
+{
+  if (!ptr)
+    n_allocs++;
+  return __libc_realloc (ptr, size);
+}
+
+guint64
+dawati_bench_get_n_allocs (void)
+{
+  return n_allocs;
+}
+#else
+guint64
+dawati_bench_get_n_allocs (void)
+{
+  return 0;
+}
+#endif
+
+static gchar *module_dir = NULL;
+static gchar *module_link = NULL;
+static gchar *engines_dir = NULL;
+
+static void
+dawati_bench_cleanup (void)
+{
+  if (module_link)
+    g_unlink (module_link);
+  if (engines_dir)
+    g_rmdir (engines_dir);
+  if (module_dir)
+    g_rmdir (module_dir);
+}
+
+/* GTK+ only loads engines from $GTK_PATH/engines, so point a temporary
+ * directory at the engine in the build tree */
+static void
+dawati_bench_setup_engine (void)
+{
+  const gchar *engine;
+  gchar *engine_path;
+
+  engine = g_getenv ("DAWATI_BENCH_ENGINE");
+  if (engine)
+    engine_path = g_strdup (engine);
+  else
+    engine_path = g_build_filename (ENGINE_BUILDDIR, ".libs", "libdawati.so",
+                                    NULL);
+
+  if (!g_file_test (engine_path, G_FILE_TEST_EXISTS))
+    g_error ("Could not find the engine at %s", engine_path);
+
+  module_dir = g_build_filename (g_get_tmp_dir (), "dawati-bench-XXXXXX",
+                                 NULL);
+  if (!mkdtemp (module_dir))
+    g_error ("Could not create %s", module_dir);
+
+  engines_dir = g_build_filename (module_dir, "engines", NULL);
+  g_mkdir (engines_dir, 0700);
+
+  module_link = g_build_filename (engines_dir, "libdawati.so", NULL);
+  if (symlink (engine_path, module_link) != 0)
+    g_error ("Could not link %s to %s", module_link, engine_path);
+
+  atexit (dawati_bench_cleanup);
+
+  g_setenv ("GTK_PATH", module_dir, TRUE);
+
+  g_free (engine_path);
+}
+
+/* Set up GTK+ to use the theme under test, or the stock GTK+ style with no
+ * engine at all if stock is TRUE. */
+void
+dawati_bench_init (int       *argc,
+                   char    ***argv,
+                   gboolean   stock)
+{
+  const gchar *gtkrc;
+
+  /* make GSlice allocations visible to the allocation counter */
+  g_setenv ("G_SLICE", "always-malloc", TRUE);
+
+  if (stock)
+    {
+      gtkrc = "/dev/null";
+    }
+  else
+    {
+      dawati_bench_setup_engine ();
+
+      gtkrc = g_getenv ("DAWATI_BENCH_GTKRC");
+      if (!gtkrc)
+        gtkrc = THEME_GTKRC;
+    }
+
+  /* only the theme under test, not the user's or the system's settings */
+  g_setenv ("GTK2_RC_FILES", gtkrc, TRUE);
+
+  gtk_init (argc, argv);
+}
+
+gboolean
+dawati_bench_is_dawati (GtkStyle *style)
+{
+  return strcmp (G_OBJECT_TYPE_NAME (style), "DawatiStyle") == 0;
+}
+
+guint64
+dawati_bench_now_ns (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+
+  return (guint64) ts.tv_sec * G_GUINT64_CONSTANT (1000000000) + ts.tv_nsec;
+}
+
+static gint
+compare_doubles (gconstpointer a,
+                 gconstpointer b)
+{
+  gdouble da = *(const gdouble *) a;
+  gdouble db = *(const gdouble *) b;
+
+  return (da > db) - (da < db);
+}
+
+/* sorts samples in place */
+void
+dawati_bench_stats_compute (gdouble          *samples,
+                            guint             n,
+                            DawatiBenchStats *stats)
+{
+  gdouble sum = 0, sum_sq = 0;
+  guint i;
+
+  memset (stats, 0, sizeof (DawatiBenchStats));
+  stats->n = n;
+
+  if (n == 0)
+    return;
+
+  qsort (samples, n, sizeof (gdouble), compare_doubles);
+
+  for (i = 0; i < n; i++)
+    sum += samples[i];
+  stats->mean = sum / n;
+
+  for (i = 0; i < n; i++)
+    sum_sq += (samples[i] - stats->mean) * (samples[i] - stats->mean);
+  stats->variance = n > 1 ? sum_sq / (n - 1) : 0;
+
+  stats->min = samples[0];
+  stats->max = samples[n - 1];
+  stats->median = (n % 2) ? samples[n / 2]
+                          : (samples[n / 2 - 1] + samples[n / 2]) / 2;
+}
+
+/* nearest rank percentile of sorted samples */
+gdouble
+dawati_bench_percentile (const gdouble *sorted,
+                         guint          n,
+                         gdouble        percent)
+{
+  guint rank;
+
+  if (n == 0)
+    return 0;
+
+  rank = (guint) ceil (percent / 100.0 * n);
+  rank = CLAMP (rank, 1, n);
+
+  return sorted[rank - 1];
+}
+
+void
+dawati_bench_json_string (GString     *out,
+                          const gchar *str)
+{
+  const gchar *p;
+
+  if (!str)
+    {
+      g_string_append (out, "null");
+      return;
+    }
+
+  g_string_append_c (out, '"');
+  for (p = str; *p; p++)
+    {
+      if (*p == '"' || *p == '\\')
+        g_string_append_c (out, '\\');
+
+      if ((guchar) *p < 0x20)
+        g_string_append_printf (out, "\\u%04x", *p);
+      else
+        g_string_append_c (out, *p);
+    }
+  g_string_append_c (out, '"');
+}
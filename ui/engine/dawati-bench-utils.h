@@ -0,0 +1,61 @@
+/*
+ * dawati-gtk-engine - A GTK+ theme engine for Dawati
+ *
+ * Copyright (c) 2011, Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef _DAWATI_BENCH_UTILS_H
+#define _DAWATI_BENCH_UTILS_H
+
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+/* Helpers shared by the benchmark programs. They are not part of the
+ * engine. */
+
+typedef struct
+{
+  guint   n;
+  gdouble mean;
+  gdouble variance;
+  gdouble min;
+  gdouble median;
+  gdouble max;
+} DawatiBenchStats;
+
+void     dawati_bench_init          (int               *argc,
+                                     char            ***argv,
+                                     gboolean           stock);
+gboolean dawati_bench_is_dawati     (GtkStyle          *style);
+
+guint64  dawati_bench_now_ns        (void);
+guint64  dawati_bench_get_n_allocs  (void);
+
+void     dawati_bench_stats_compute (gdouble           *samples,
+                                     guint              n,
+                                     DawatiBenchStats  *stats);
+gdouble  dawati_bench_percentile    (const gdouble     *sorted,
+                                     guint              n,
+                                     gdouble            percent);
+
+void     dawati_bench_json_string   (GString           *out,
+                                     const gchar       *str);
+
+G_END_DECLS
+
+#endif /* _DAWATI_BENCH_UTILS_H */
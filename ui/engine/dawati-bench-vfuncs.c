@@ -0,0 +1,398 @@
+/*
+ * dawati-gtk-engine - A GTK+ theme engine for Dawati
+ *
+ * Copyright (c) 2011, Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/* Times each GtkStyleClass vfunc the engine overrides over a matrix of
+ * details, states, shadow types and sizes, drawing into an offscreen
+ * pixmap, and prints one JSON object per case on stdout.
+ *
+ * Needs an X server, for example:
+ *
+ *   xvfb-run -a ./dawati-bench-vfuncs -n 200 -r 7
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <string.h>
+
+#include "dawati-bench-utils.h"
+
+typedef enum
+{
+  BENCH_BOX,
+  BENCH_SHADOW,
+  BENCH_CHECK,
+  BENCH_OPTION,
+  BENCH_BOX_GAP,
+  BENCH_EXTENSION,
+  BENCH_ARROW,
+  BENCH_HANDLE,
+  BENCH_RESIZE_GRIP,
+  BENCH_LAYOUT,
+  BENCH_ICON,
+  BENCH_EXPANDER
+} BenchVfunc;
+
+typedef struct
+{
+  BenchVfunc          vfunc;
+  const gchar        *name;
+  gboolean            has_shadow;
+  const gchar *const *details;
+} BenchEntry;
+
+typedef struct
+{
+  const BenchEntry *entry;
+  const gchar      *detail;
+  GtkStateType      state;
+  GtkShadowType     shadow;
+  gint              width;
+  gint              height;
+  GtkIconSize       icon_size;
+} BenchCase;
+
+static const gchar *const box_details[] = {
+  "button", "buttondefault", "trough", "trough-fill-level",
+  "hscrollbar", "vscrollbar", "slider", "hscale", "vscale",
+  "light-switch-handle", "light-switch-trough", "menuitem", NULL
+};
+static const gchar *const shadow_details[] = {
+  "entry", "frame", "scrolled_window", NULL
+};
+static const gchar *const check_details[] = {
+  "checkbutton", "cellcheck", NULL
+};
+static const gchar *const option_details[] = {
+  "radiobutton", "cellradio", NULL
+};
+static const gchar *const gap_details[] = { "notebook", NULL };
+static const gchar *const extension_details[] = { "tab", NULL };
+static const gchar *const arrow_details[] = {
+  "hscrollbar", "vscrollbar", "spinbutton", "menuitem", NULL
+};
+static const gchar *const handle_details[] = { "paned", "handlebox", NULL };
+static const gchar *const resize_grip_details[] = { "statusbar", NULL };
+static const gchar *const layout_details[] = {
+  "label", "accellabel", NULL
+};
+static const gchar *const icon_details[] = { "button", NULL };
+static const gchar *const expander_details[] = { "treeview", "expander", NULL };
+
+/* the details lists are NULL terminated, and the NULL detail is measured
+ * as well */
+static const BenchEntry entries[] = {
+  { BENCH_BOX,         "draw_box",         TRUE,  box_details },
+  { BENCH_SHADOW,      "draw_shadow",      TRUE,  shadow_details },
+  { BENCH_CHECK,       "draw_check",       TRUE,  check_details },
+  { BENCH_OPTION,      "draw_option",      TRUE,  option_details },
+  { BENCH_BOX_GAP,     "draw_box_gap",     TRUE,  gap_details },
+  { BENCH_EXTENSION,   "draw_extension",   TRUE,  extension_details },
+  { BENCH_ARROW,       "draw_arrow",       TRUE,  arrow_details },
+  { BENCH_HANDLE,      "draw_handle",      TRUE,  handle_details },
+  { BENCH_RESIZE_GRIP, "draw_resize_grip", FALSE, resize_grip_details },
+  { BENCH_LAYOUT,      "draw_layout",      FALSE, layout_details },
+  { BENCH_ICON,        "render_icon",      FALSE, icon_details },
+  { BENCH_EXPANDER,    "draw_expander",    FALSE, expander_details },
+};
+
+static const GtkStateType states[] = {
+  GTK_STATE_NORMAL,
+  GTK_STATE_ACTIVE,
+  GTK_STATE_PRELIGHT,
+  GTK_STATE_SELECTED,
+  GTK_STATE_INSENSITIVE
+};
+
+static const GtkShadowType shadows[] = {
+  GTK_SHADOW_IN,
+  GTK_SHADOW_OUT,
+  GTK_SHADOW_ETCHED_IN
+};
+
+static const struct { gint width, height; GtkIconSize icon_size; } sizes[] = {
+  {  16,  16, GTK_ICON_SIZE_MENU },
+  {  80,  28, GTK_ICON_SIZE_LARGE_TOOLBAR },
+  { 300, 200, GTK_ICON_SIZE_DIALOG }
+};
+
+#define PIXMAP_WIDTH 320
+#define PIXMAP_HEIGHT 220
+
+static gint n_iterations = 100;
+static gint n_repeats = 5;
+static gchar *filter = NULL;
+
+static GOptionEntry options[] = {
+  { "iterations", 'n', 0, G_OPTION_ARG_INT, &n_iterations,
+    "Calls per timed repeat", "N" },
+  { "repeats", 'r', 0, G_OPTION_ARG_INT, &n_repeats,
+    "Timed repeats per case", "N" },
+  { "filter", 'f', 0, G_OPTION_ARG_STRING, &filter,
+    "Only run vfuncs whose name contains STRING", "STRING" },
+  { NULL }
+};
+
+static GtkStyle *style;
+static GdkPixmap *pixmap;
+static PangoLayout *layout;
+static GtkIconSource *icon_source;
+
+static const gchar *
+enum_nick (GType type,
+           gint  value)
+{
+  GEnumClass *klass;
+  GEnumValue *enum_value;
+
+  klass = g_type_class_ref (type);
+  enum_value = g_enum_get_value (klass, value);
+  g_type_class_unref (klass);
+
+  return enum_value ? enum_value->value_nick : NULL;
+}
+
+static void
+bench_call (const BenchCase *c)
+{
+  const gchar *detail = c->detail;
+  GtkStateType state = c->state;
+  GtkShadowType shadow = c->shadow;
+  gint w = c->width;
+  gint h = c->height;
+
+  switch (c->entry->vfunc)
+    {
+    case BENCH_BOX:
+      gtk_paint_box (style, pixmap, state, shadow, NULL, NULL, detail,
+                     0, 0, w, h);
+      break;
+    case BENCH_SHADOW:
+      gtk_paint_shadow (style, pixmap, state, shadow, NULL, NULL, detail,
+                        0, 0, w, h);
+      break;
+    case BENCH_CHECK:
+      gtk_paint_check (style, pixmap, state, shadow, NULL, NULL, detail,
+                       0, 0, w, h);
+      break;
+    case BENCH_OPTION:
+      gtk_paint_option (style, pixmap, state, shadow, NULL, NULL, detail,
+                        0, 0, w, h);
+      break;
+    case BENCH_BOX_GAP:
+      gtk_paint_box_gap (style, pixmap, state, shadow, NULL, NULL, detail,
+                         0, 0, w, h, GTK_POS_TOP, w / 4, w / 2);
+      break;
+    case BENCH_EXTENSION:
+      gtk_paint_extension (style, pixmap, state, shadow, NULL, NULL, detail,
+                           0, 0, w, h, GTK_POS_BOTTOM);
+      break;
+    case BENCH_ARROW:
+      gtk_paint_arrow (style, pixmap, state, shadow, NULL, NULL, detail,
+                       GTK_ARROW_DOWN, TRUE, 0, 0, w, h);
+      break;
+    case BENCH_HANDLE:
+      gtk_paint_handle (style, pixmap, state, shadow, NULL, NULL, detail,
+                        0, 0, w, h, GTK_ORIENTATION_HORIZONTAL);
+      break;
+    case BENCH_RESIZE_GRIP:
+      gtk_paint_resize_grip (style, pixmap, state, NULL, NULL, detail,
+                             GDK_WINDOW_EDGE_SOUTH_EAST, 0, 0, w, h);
+      break;
+    case BENCH_LAYOUT:
+      gtk_paint_layout (style, pixmap, state, TRUE, NULL, NULL, detail,
+                        0, 0, layout);
+      break;
+    case BENCH_ICON:
+      g_object_unref (gtk_style_render_icon (style, icon_source,
+                                             GTK_TEXT_DIR_LTR, state,
+                                             c->icon_size, NULL, detail));
+      break;
+    case BENCH_EXPANDER:
+      gtk_paint_expander (style, pixmap, state, NULL, NULL, detail,
+                          w / 2, h / 2, GTK_EXPANDER_COLLAPSED);
+      break;
+    }
+}
+
+static void
+bench_run_case (const BenchCase *c,
+                gdouble         *samples)
+{
+  GString *out;
+  DawatiBenchStats stats;
+  guint64 allocs_before, n_allocs = 0;
+  gint r, i;
+
+  /* warm up, so that one-off cache fills are not part of the numbers */
+  bench_call (c);
+  gdk_flush ();
+
+  for (r = 0; r < n_repeats; r++)
+    {
+      guint64 start;
+
+      allocs_before = dawati_bench_get_n_allocs ();
+      start = dawati_bench_now_ns ();
+
+      for (i = 0; i < n_iterations; i++)
+        bench_call (c);
+
+      /* include the time the X server takes to render the requests */
+      gdk_flush ();
+
+      samples[r] = (gdouble) (dawati_bench_now_ns () - start) / n_iterations;
+      n_allocs += dawati_bench_get_n_allocs () - allocs_before;
+    }
+
+  dawati_bench_stats_compute (samples, n_repeats, &stats);
+
+  out = g_string_new ("{\"vfunc\":");
+  dawati_bench_json_string (out, c->entry->name);
+  g_string_append (out, ",\"detail\":");
+  dawati_bench_json_string (out, c->detail);
+  g_string_append (out, ",\"state\":");
+  dawati_bench_json_string (out, enum_nick (GTK_TYPE_STATE_TYPE, c->state));
+  g_string_append (out, ",\"shadow\":");
+  dawati_bench_json_string (out, c->entry->has_shadow
+                            ? enum_nick (GTK_TYPE_SHADOW_TYPE, c->shadow)
+                            : NULL);
+  g_string_append_printf (out,
+                          ",\"width\":%d,\"height\":%d"
+                          ",\"iterations\":%d,\"repeats\":%d"
+                          ",\"ns_per_call\":%.1f,\"ns_median\":%.1f"
+                          ",\"ns_min\":%.1f,\"ns_max\":%.1f"
+                          ",\"variance\":%.1f,\"allocs_per_call\":%.2f}",
+                          c->width, c->height, n_iterations, n_repeats,
+                          stats.mean, stats.median, stats.min, stats.max,
+                          stats.variance,
+                          (gdouble) n_allocs / (n_iterations * n_repeats));
+
+  puts (out->str);
+  fflush (stdout);
+
+  g_string_free (out, TRUE);
+}
+
+static void
+bench_run_entry (const BenchEntry *entry,
+                 gdouble          *samples)
+{
+  BenchCase c = { entry, };
+  const gchar *const *detail;
+  guint s, st, sz;
+
+  /* iterate up to and including the NULL detail */
+  for (detail = entry->details; ; detail++)
+    {
+      c.detail = *detail;
+
+      for (sz = 0; sz < G_N_ELEMENTS (sizes); sz++)
+        for (st = 0; st < G_N_ELEMENTS (states); st++)
+          for (s = 0; s < (entry->has_shadow ? G_N_ELEMENTS (shadows) : 1); s++)
+            {
+              c.state = states[st];
+              c.shadow = entry->has_shadow ? shadows[s] : GTK_SHADOW_NONE;
+              c.width = sizes[sz].width;
+              c.height = sizes[sz].height;
+              c.icon_size = sizes[sz].icon_size;
+
+              if (entry->vfunc == BENCH_ICON)
+                gtk_icon_size_lookup (c.icon_size, &c.width, &c.height);
+
+              bench_run_case (&c, samples);
+            }
+
+      if (!*detail)
+        break;
+    }
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  GOptionContext *context;
+  GError *error = NULL;
+  GtkWidget *window;
+  GdkPixbuf *pixbuf;
+  gdouble *samples;
+  guint i;
+
+  dawati_bench_init (&argc, &argv, FALSE);
+
+  context = g_option_context_new ("- time the dawati style vfuncs");
+  g_option_context_add_main_entries (context, options, NULL);
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      return 1;
+    }
+  g_option_context_free (context);
+
+  if (n_iterations < 1 || n_repeats < 1)
+    {
+      g_printerr ("iterations and repeats must be positive\n");
+      return 1;
+    }
+
+  /* the window is never shown, it only provides the style and a drawable
+   * to create the pixmap for */
+  window = gtk_window_new (GTK_WINDOW_POPUP);
+  gtk_widget_realize (window);
+
+  style = gtk_widget_get_style (window);
+  if (!dawati_bench_is_dawati (style))
+    {
+      g_printerr ("The dawati engine was not loaded (got %s)\n",
+                  G_OBJECT_TYPE_NAME (style));
+      return 1;
+    }
+
+  pixmap = gdk_pixmap_new (window->window, PIXMAP_WIDTH, PIXMAP_HEIGHT, -1);
+
+  layout = gtk_widget_create_pango_layout (window, "Dawati _benchmark");
+
+  pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, TRUE, 8, 48, 48);
+  gdk_pixbuf_fill (pixbuf, 0x8d8d8dff);
+  icon_source = gtk_icon_source_new ();
+  gtk_icon_source_set_pixbuf (icon_source, pixbuf);
+  g_object_unref (pixbuf);
+
+  samples = g_new (gdouble, n_repeats);
+
+  for (i = 0; i < G_N_ELEMENTS (entries); i++)
+    {
+      if (filter && !strstr (entries[i].name, filter))
+        continue;
+
+      bench_run_entry (&entries[i], samples);
+    }
+
+  g_free (samples);
+  gtk_icon_source_free (icon_source);
+  g_object_unref (layout);
+  g_object_unref (pixmap);
+  gtk_widget_destroy (window);
+
+  return 0;
+}
@@ -0,0 +1,552 @@
+/*
+ * dawati-gtk-engine - A GTK+ theme engine for Dawati
+ *
+ * Copyright (c) 2011, Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/* Simulates caching the renderings of a recording made with
+ * DAWATI_ENGINE_RECORD, to choose what the engine's caches are keyed on and
+ * how big they are from real sessions rather than by guessing:
+ *
+ *   ./dawati-cache-sim --key detail,state,size,colours \
+ *                      --capacity 256,1024,4096 session.rec
+ *
+ * Every draw is looked up in an LRU cache like the engine's, where each
+ * rendering costs the bytes of an ARGB32 surface of its size. For each
+ * capacity one line of JSON gives the hit rate, the working set (the bytes
+ * needed to hold every distinct rendering) and the element and detail
+ * pairs that miss the most.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dawati-cache.h"
+#include "dawati-record.h"
+
+/* the parts of a draw that can make up the key */
+enum
+{
+  KEY_ELEMENT  = 1 << 0,
+  KEY_DETAIL   = 1 << 1,
+  KEY_STATE    = 1 << 2,
+  KEY_SHADOW   = 1 << 3,
+  KEY_SIZE     = 1 << 4,
+  KEY_COLOURS  = 1 << 5,
+  KEY_ROLE     = 1 << 6,
+  KEY_GAP      = 1 << 7
+};
+
+static const struct
+{
+  const gchar *name;
+  guint        field;
+} key_fields[] = {
+  { "element", KEY_ELEMENT },
+  { "detail", KEY_DETAIL },
+  { "state", KEY_STATE },
+  { "shadow", KEY_SHADOW },
+  { "size", KEY_SIZE },
+  { "colours", KEY_COLOURS },
+  { "role", KEY_ROLE },
+  { "gap", KEY_GAP }
+};
+
+static const gchar *element_names[] = {
+  "box",
+  "shadow",
+  "check",
+  "option",
+  "box_gap",
+  "extension",
+  "hline",
+  "vline",
+  "focus",
+  "arrow",
+  "handle",
+  "resize_grip",
+  "expander"
+};
+
+/* A draw reduced to the fields of the key; the others stay zero, so keys
+ * can be hashed and compared as plain memory. */
+typedef struct
+{
+  guint32 element;
+  guint32 detail;
+  guint32 state;
+  guint32 shadow;
+  guint32 role;
+  gint32  width;
+  gint32  height;
+  gint32  gap_side;
+  gint32  gap_x;
+  gint32  gap_width;
+  guint32 colours;
+} SimKey;
+
+/* the draws of one element with one detail */
+typedef struct
+{
+  guint32 element;
+  guint32 detail;
+  guint   draws;
+  guint   misses;
+} SimCaller;
+
+static gchar *key_option = "element,detail,state,shadow,size,colours";
+static gchar *capacity_option = "64,256,1024,4096";
+static gchar *elements_option = NULL;
+static gint n_top = 10;
+
+static GOptionEntry options[] = {
+  { "key", 'k', 0, G_OPTION_ARG_STRING, &key_option,
+    "What renderings are cached by, from element, detail, state, shadow, "
+    "size, colours, role and gap", "FIELD,..." },
+  { "capacity", 'c', 0, G_OPTION_ARG_STRING, &capacity_option,
+    "Cache sizes to simulate, in KiB", "KIB,..." },
+  { "elements", 'e', 0, G_OPTION_ARG_STRING, &elements_option,
+    "Only cache these elements, e.g. box,shadow", "ELEMENT,..." },
+  { "top", 't', 0, G_OPTION_ARG_INT, &n_top,
+    "Number of cache hostile callers to list", "N" },
+  { NULL }
+};
+
+static guint
+sim_key_hash (gconstpointer key)
+{
+  const guchar *p = key;
+  guint hash = 2166136261u;
+  gsize i;
+
+  for (i = 0; i < sizeof (SimKey); i++)
+    hash = (hash ^ p[i]) * 16777619u;
+
+  return hash;
+}
+
+static gboolean
+sim_key_equal (gconstpointer a,
+               gconstpointer b)
+{
+  return memcmp (a, b, sizeof (SimKey)) == 0;
+}
+
+static void
+sim_key_free (gpointer key)
+{
+  g_slice_free (SimKey, key);
+}
+
+static gboolean
+parse_names (const gchar *option,
+             const gchar *what,
+             guint       *mask,
+             gboolean     (*lookup) (const gchar *name, guint *bit))
+{
+  gchar **names;
+  guint i, bit;
+
+  *mask = 0;
+  names = g_strsplit (option, ",", -1);
+
+  for (i = 0; names[i]; i++)
+    {
+      g_strstrip (names[i]);
+
+      if (!lookup (names[i], &bit))
+        {
+          g_printerr ("Unknown %s '%s'\n", what, names[i]);
+          g_strfreev (names);
+          return FALSE;
+        }
+
+      *mask |= bit;
+    }
+
+  g_strfreev (names);
+
+  return TRUE;
+}
+
+static gboolean
+lookup_key_field (const gchar *name,
+                  guint       *bit)
+{
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (key_fields); i++)
+    if (strcmp (name, key_fields[i].name) == 0)
+      {
+        *bit = key_fields[i].field;
+        return TRUE;
+      }
+
+  return FALSE;
+}
+
+static gboolean
+lookup_element (const gchar *name,
+                guint       *bit)
+{
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (element_names); i++)
+    if (strcmp (name, element_names[i]) == 0)
+      {
+        *bit = 1 << i;
+        return TRUE;
+      }
+
+  return FALSE;
+}
+
+/* Numbers the parameters of the recording by their contents, so that
+ * styles that resolved to the same colours share renderings. */
+static guint
+get_colours_id (GHashTable               *ids,
+                GHashTable               *contents,
+                const DawatiRenderParams *params)
+{
+  DawatiRenderParams *copy;
+  gpointer id;
+
+  id = g_hash_table_lookup (ids, params);
+  if (id)
+    return GPOINTER_TO_UINT (id);
+
+  copy = g_malloc (sizeof (DawatiRenderParams));
+  memcpy (copy, params, sizeof (DawatiRenderParams));
+  copy->serial = 0;
+
+  id = g_hash_table_lookup (contents, copy);
+  if (id)
+    {
+      g_free (copy);
+    }
+  else
+    {
+      id = GUINT_TO_POINTER (g_hash_table_size (contents) + 1);
+      g_hash_table_insert (contents, copy, id);
+    }
+
+  g_hash_table_insert (ids, (gpointer) params, id);
+
+  return GPOINTER_TO_UINT (id);
+}
+
+static guint
+params_hash (gconstpointer key)
+{
+  const guchar *p = key;
+  guint hash = 2166136261u;
+  gsize i;
+
+  for (i = 0; i < sizeof (DawatiRenderParams); i++)
+    hash = (hash ^ p[i]) * 16777619u;
+
+  return hash;
+}
+
+static gboolean
+params_equal (gconstpointer a,
+              gconstpointer b)
+{
+  return memcmp (a, b, sizeof (DawatiRenderParams)) == 0;
+}
+
+static void
+make_key (SimKey                   *key,
+          const DawatiRecordedDraw *draw,
+          guint                     fields,
+          guint                     colours)
+{
+  const DawatiRenderOp *op = &draw->op;
+
+  memset (key, 0, sizeof (SimKey));
+
+  if (fields & KEY_ELEMENT)
+    key->element = op->element;
+  if (fields & KEY_DETAIL)
+    key->detail = op->detail;
+  if (fields & KEY_STATE)
+    key->state = op->state;
+  if (fields & KEY_SHADOW)
+    key->shadow = op->shadow;
+  if (fields & KEY_ROLE)
+    key->role = op->role;
+  if (fields & KEY_SIZE)
+    {
+      key->width = op->width;
+      key->height = op->height;
+    }
+  if (fields & KEY_GAP)
+    {
+      key->gap_side = op->gap_side;
+      key->gap_x = op->gap_x;
+      key->gap_width = op->gap_width;
+    }
+  if (fields & KEY_COLOURS)
+    key->colours = colours;
+}
+
+/* bytes of an ARGB32 surface of the draw's size */
+static gsize
+draw_cost (const DawatiRecordedDraw *draw)
+{
+  return (gsize) MAX (draw->op.width, 1) * MAX (draw->op.height, 1) * 4;
+}
+
+/* most misses first */
+static gint
+sim_caller_compare (gconstpointer a,
+                    gconstpointer b)
+{
+  const SimCaller *ca = *(SimCaller **) a;
+  const SimCaller *cb = *(SimCaller **) b;
+
+  if (ca->misses != cb->misses)
+    return ca->misses < cb->misses ? 1 : -1;
+
+  return 0;
+}
+
+static void
+json_append_string (GString     *out,
+                    const gchar *str)
+{
+  const gchar *p;
+
+  if (!str)
+    {
+      g_string_append (out, "null");
+      return;
+    }
+
+  g_string_append_c (out, '"');
+  for (p = str; *p; p++)
+    {
+      if (*p == '"' || *p == '\\')
+        g_string_append_c (out, '\\');
+      g_string_append_c (out, *p);
+    }
+  g_string_append_c (out, '"');
+}
+
+static void
+simulate (const gchar *filename,
+          GArray      *draws,
+          guint       *colours,
+          guint        fields,
+          guint        elements,
+          gsize        capacity)
+{
+  DawatiCache *cache;
+  DawatiCacheStats stats;
+  GHashTable *distinct, *callers;
+  GPtrArray *sorted;
+  GHashTableIter iter;
+  SimCaller *caller;
+  GString *out;
+  gsize working_set = 0;
+  guint n_draws = 0;
+  guint i;
+
+  cache = dawati_cache_new (sim_key_hash, sim_key_equal, sim_key_free, NULL,
+                            capacity);
+  distinct = g_hash_table_new_full (sim_key_hash, sim_key_equal,
+                                    sim_key_free, NULL);
+  callers = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                   NULL, g_free);
+
+  for (i = 0; i < draws->len; i++)
+    {
+      const DawatiRecordedDraw *draw;
+      SimKey key;
+      gpointer caller_key;
+      gboolean hit;
+
+      draw = &g_array_index (draws, DawatiRecordedDraw, i);
+
+      if (elements && !(elements & (1 << draw->op.element)))
+        continue;
+
+      n_draws++;
+      make_key (&key, draw, fields, colours[i]);
+
+      hit = dawati_cache_lookup (cache, &key) != NULL;
+      if (!hit)
+        dawati_cache_insert (cache, g_slice_dup (SimKey, &key),
+                             GUINT_TO_POINTER (TRUE), draw_cost (draw));
+
+      if (!g_hash_table_lookup (distinct, &key))
+        {
+          g_hash_table_insert (distinct, g_slice_dup (SimKey, &key),
+                               GUINT_TO_POINTER (TRUE));
+          working_set += draw_cost (draw);
+        }
+
+      caller_key = GUINT_TO_POINTER (draw->op.element << 16 | draw->op.detail);
+      caller = g_hash_table_lookup (callers, caller_key);
+      if (!caller)
+        {
+          caller = g_new0 (SimCaller, 1);
+          caller->element = draw->op.element;
+          caller->detail = draw->op.detail;
+          g_hash_table_insert (callers, caller_key, caller);
+        }
+
+      caller->draws++;
+      if (!hit)
+        caller->misses++;
+    }
+
+  dawati_cache_get_stats (cache, &stats);
+
+  sorted = g_ptr_array_new ();
+  g_hash_table_iter_init (&iter, callers);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &caller))
+    g_ptr_array_add (sorted, caller);
+  g_ptr_array_sort (sorted, sim_caller_compare);
+
+  out = g_string_new ("{\"recording\":");
+  json_append_string (out, filename);
+  g_string_append (out, ",\"key\":");
+  json_append_string (out, key_option);
+  g_string_append_printf (out,
+                          ",\"capacity_kb\":%lu,\"draws\":%u,\"hits\":%u"
+                          ",\"hit_rate\":%.4f,\"evictions\":%u"
+                          ",\"distinct\":%u,\"working_set_bytes\":%lu"
+                          ",\"hostile\":[",
+                          (gulong) capacity / 1024, n_draws, stats.hits,
+                          n_draws ? (gdouble) stats.hits / n_draws : 0.0,
+                          stats.evictions, g_hash_table_size (distinct),
+                          (gulong) working_set);
+
+  for (i = 0; i < MIN (sorted->len, (guint) n_top); i++)
+    {
+      caller = g_ptr_array_index (sorted, i);
+
+      if (!caller->misses)
+        break;
+
+      g_string_append_printf (out, "%s{\"element\":\"%s\",\"detail\":",
+                              i ? "," : "", element_names[caller->element]);
+      json_append_string (out, dawati_detail_name (caller->detail));
+      g_string_append_printf (out,
+                              ",\"draws\":%u,\"misses\":%u"
+                              ",\"miss_rate\":%.4f}",
+                              caller->draws, caller->misses,
+                              (gdouble) caller->misses / caller->draws);
+    }
+
+  g_string_append (out, "]}");
+  puts (out->str);
+
+  g_string_free (out, TRUE);
+  g_ptr_array_free (sorted, TRUE);
+  g_hash_table_destroy (callers);
+  g_hash_table_destroy (distinct);
+  dawati_cache_free (cache);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  DawatiRecordReader *reader;
+  GOptionContext *context;
+  GHashTable *ids, *contents;
+  GError *error = NULL;
+  GArray *draws = NULL;
+  gchar **capacities;
+  guint *colours;
+  guint fields, elements = 0;
+  guint i;
+
+  context = g_option_context_new ("RECORDING - simulate caching the "
+                                  "renderings of a recording");
+  g_option_context_add_main_entries (context, options, NULL);
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      return 1;
+    }
+  g_option_context_free (context);
+
+  if (argc != 2)
+    {
+      g_printerr ("Usage: %s [OPTION...] RECORDING\n", argv[0]);
+      return 1;
+    }
+
+  if (!parse_names (key_option, "key field", &fields, lookup_key_field))
+    return 1;
+  if (elements_option
+      && !parse_names (elements_option, "element", &elements, lookup_element))
+    return 1;
+
+  reader = dawati_record_reader_new (argv[1], &error);
+  if (reader)
+    draws = dawati_record_reader_read_all (reader, &error);
+  if (!reader || !draws)
+    {
+      g_printerr ("%s\n", error->message);
+      return 1;
+    }
+
+  /* the colours are worked out once for every capacity */
+  ids = g_hash_table_new (g_direct_hash, g_direct_equal);
+  contents = g_hash_table_new_full (params_hash, params_equal, g_free, NULL);
+  colours = g_new (guint, draws->len);
+
+  for (i = 0; i < draws->len; i++)
+    colours[i] = get_colours_id (ids, contents,
+                                 g_array_index (draws, DawatiRecordedDraw,
+                                                i).params);
+
+  capacities = g_strsplit (capacity_option, ",", -1);
+
+  for (i = 0; capacities[i]; i++)
+    {
+      gchar *end;
+      gulong kib;
+
+      kib = strtoul (capacities[i], &end, 10);
+      if (end == capacities[i] || *end != '\0')
+        {
+          g_printerr ("Invalid capacity '%s'\n", capacities[i]);
+          return 1;
+        }
+
+      simulate (argv[1], draws, colours, fields, elements, kib * 1024);
+    }
+
+  g_strfreev (capacities);
+  g_free (colours);
+  g_hash_table_destroy (contents);
+  g_hash_table_destroy (ids);
+  g_array_free (draws, TRUE);
+  dawati_record_reader_free (reader);
+
+  return 0;
+}
@@ -0,0 +1,218 @@
+/*
+ * dawati-gtk-engine - A GTK+ theme engine for Dawati
+ *
+ * Copyright (c) 2011, Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "dawati-cache.h"
+
+typedef struct
+{
+  gpointer key;
+  gpointer value;
+  gsize    cost;
+
+  /* position in the LRU queue, most recently used at the head */
+  GList    link;
+} DawatiCacheEntry;
+
+struct _DawatiCache
+{
+  GHashTable     *table;
+  GQueue          lru;
+
+  GDestroyNotify  key_destroy;
+  GDestroyNotify  value_destroy;
+
+  gsize           cost;
+  gsize           max_cost;
+
+  guint           hits;
+  guint           misses;
+  guint           evictions;
+};
+
+static void
+dawati_cache_entry_free (DawatiCache      *cache,
+                         DawatiCacheEntry *entry)
+{
+  if (cache->key_destroy)
+    cache->key_destroy (entry->key);
+  if (cache->value_destroy)
+    cache->value_destroy (entry->value);
+
+  g_slice_free (DawatiCacheEntry, entry);
+}
+
+static void
+dawati_cache_remove_entry (DawatiCache      *cache,
+                           DawatiCacheEntry *entry)
+{
+  g_queue_unlink (&cache->lru, &entry->link);
+  g_hash_table_steal (cache->table, entry->key);
+  cache->cost -= entry->cost;
+
+  dawati_cache_entry_free (cache, entry);
+}
+
+DawatiCache *
+dawati_cache_new (GHashFunc      key_hash,
+                  GEqualFunc     key_equal,
+                  GDestroyNotify key_destroy,
+                  GDestroyNotify value_destroy,
+                  gsize          max_cost)
+{
+  DawatiCache *cache;
+
+  cache = g_slice_new0 (DawatiCache);
+
+  /* entries are freed by hand so that the key is still valid while the
+   * entry is being removed from the table */
+  cache->table = g_hash_table_new (key_hash, key_equal);
+  g_queue_init (&cache->lru);
+
+  cache->key_destroy = key_destroy;
+  cache->value_destroy = value_destroy;
+  cache->max_cost = max_cost;
+
+  return cache;
+}
+
+void
+dawati_cache_free (DawatiCache *cache)
+{
+  if (!cache)
+    return;
+
+  dawati_cache_clear (cache);
+  g_hash_table_destroy (cache->table);
+
+  g_slice_free (DawatiCache, cache);
+}
+
+gpointer
+dawati_cache_lookup (DawatiCache   *cache,
+                     gconstpointer  key)
+{
+  DawatiCacheEntry *entry;
+
+  entry = g_hash_table_lookup (cache->table, key);
+
+  if (!entry)
+    {
+      cache->misses++;
+      return NULL;
+    }
+
+  cache->hits++;
+
+  /* move to the front of the queue */
+  if (cache->lru.head != &entry->link)
+    {
+      g_queue_unlink (&cache->lru, &entry->link);
+      g_queue_push_head_link (&cache->lru, &entry->link);
+    }
+
+  return entry->value;
+}
+
+/* Takes ownership of key and value. Returns FALSE if the value was too
+ * expensive to be stored, in which case both have already been freed. */
+gboolean
+dawati_cache_insert (DawatiCache *cache,
+                     gpointer     key,
+                     gpointer     value,
+                     gsize        cost)
+{
+  DawatiCacheEntry *entry;
+
+  entry = g_slice_new0 (DawatiCacheEntry);
+  entry->key = key;
+  entry->value = value;
+  entry->cost = cost;
+  entry->link.data = entry;
+
+  if (cost > cache->max_cost)
+    {
+      dawati_cache_entry_free (cache, entry);
+      return FALSE;
+    }
+
+  /* replace any existing entry for this key */
+  {
+    DawatiCacheEntry *old;
+
+    old = g_hash_table_lookup (cache->table, key);
+    if (old)
+      dawati_cache_remove_entry (cache, old);
+  }
+
+  while (cache->cost + cost > cache->max_cost && cache->lru.tail)
+    {
+      dawati_cache_remove_entry (cache, cache->lru.tail->data);
+      cache->evictions++;
+    }
+
+  g_hash_table_insert (cache->table, entry->key, entry);
+  g_queue_push_head_link (&cache->lru, &entry->link);
+  cache->cost += cost;
+
+  return TRUE;
+}
+
+void
+dawati_cache_remove_matching (DawatiCache *cache,
+                              GHRFunc      func,
+                              gpointer     user_data)
+{
+  GList *l, *next;
+
+  for (l = cache->lru.head; l; l = next)
+    {
+      DawatiCacheEntry *entry = l->data;
+
+      next = l->next;
+
+      if (func (entry->key, entry->value, user_data))
+        dawati_cache_remove_entry (cache, entry);
+    }
+}
+
+void
+dawati_cache_clear (DawatiCache *cache)
+{
+  while (cache->lru.head)
+    dawati_cache_remove_entry (cache, cache->lru.head->data);
+}
+
+gsize
+dawati_cache_get_max_cost (DawatiCache *cache)
+{
+  return cache->max_cost;
+}
+
+void
+dawati_cache_get_stats (DawatiCache      *cache,
+                        DawatiCacheStats *stats)
+{
+  stats->hits = cache->hits;
+  stats->misses = cache->misses;
+  stats->evictions = cache->evictions;
+  stats->n_entries = g_hash_table_size (cache->table);
+  stats->cost = cache->cost;
+  stats->max_cost = cache->max_cost;
+}
@@ -0,0 +1,68 @@
+/*
+ * dawati-gtk-engine - A GTK+ theme engine for Dawati
+ *
+ * Copyright (c) 2011, Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef _DAWATI_CACHE_H
+#define _DAWATI_CACHE_H
+
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+/* A size bounded least-recently-used cache. Each entry carries a cost (for
+ * example the number of bytes of a surface) and the least recently used
+ * entries are evicted when the total cost goes over the maximum. */
+
+typedef struct _DawatiCache DawatiCache;
+
+typedef struct
+{
+  guint  hits;
+  guint  misses;
+  guint  evictions;
+  guint  n_entries;
+  gsize  cost;
+  gsize  max_cost;
+} DawatiCacheStats;
+
+DawatiCache *dawati_cache_new            (GHashFunc       key_hash,
+                                          GEqualFunc      key_equal,
+                                          GDestroyNotify  key_destroy,
+                                          GDestroyNotify  value_destroy,
+                                          gsize           max_cost);
+void         dawati_cache_free           (DawatiCache    *cache);
+
+gpointer     dawati_cache_lookup         (DawatiCache    *cache,
+                                          gconstpointer   key);
+gboolean     dawati_cache_insert         (DawatiCache    *cache,
+                                          gpointer        key,
+                                          gpointer        value,
+                                          gsize           cost);
+void         dawati_cache_remove_matching (DawatiCache   *cache,
+                                          GHRFunc         func,
+                                          gpointer        user_data);
+void         dawati_cache_clear          (DawatiCache    *cache);
+
+gsize        dawati_cache_get_max_cost   (DawatiCache    *cache);
+void         dawati_cache_get_stats      (DawatiCache    *cache,
+                                          DawatiCacheStats *stats);
+
+G_END_DECLS
+
+#endif /* _DAWATI_CACHE_H */
@@ -0,0 +1,1335 @@
+/*
+ * dawati-gtk-engine - A GTK+ theme engine for Dawati
+ *
+ * Copyright (c) 2011, Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "config.h"
+
+#include "dawati-debug.h"
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#ifdef GDK_WINDOWING_X11
+#include <gdk/gdkx.h>
+#endif
+
+/* Durations are kept in power of two buckets of nanoseconds; bucket i
+ * counts the calls that took less than 2^i ns, and the last one everything
+ * slower. */
+#define N_BUCKETS 32
+
+typedef enum
+{
+  DAWATI_VFUNC_SHADOW,
+  DAWATI_VFUNC_BOX,
+  DAWATI_VFUNC_CHECK,
+  DAWATI_VFUNC_OPTION,
+  DAWATI_VFUNC_BOX_GAP,
+  DAWATI_VFUNC_SHADOW_GAP,
+  DAWATI_VFUNC_EXTENSION,
+  DAWATI_VFUNC_HLINE,
+  DAWATI_VFUNC_VLINE,
+  DAWATI_VFUNC_FOCUS,
+  DAWATI_VFUNC_ARROW,
+  DAWATI_VFUNC_HANDLE,
+  DAWATI_VFUNC_RESIZE_GRIP,
+  DAWATI_VFUNC_LAYOUT,
+  DAWATI_VFUNC_RENDER_ICON,
+  DAWATI_VFUNC_EXPANDER,
+  DAWATI_VFUNC_FLAT_BOX,
+  DAWATI_VFUNC_SLIDER
+} DawatiVfunc;
+
+static const gchar *vfunc_names[] = {
+  "draw_shadow",
+  "draw_box",
+  "draw_check",
+  "draw_option",
+  "draw_box_gap",
+  "draw_shadow_gap",
+  "draw_extension",
+  "draw_hline",
+  "draw_vline",
+  "draw_focus",
+  "draw_arrow",
+  "draw_handle",
+  "draw_resize_grip",
+  "draw_layout",
+  "render_icon",
+  "draw_expander",
+  "draw_flat_box",
+  "draw_slider"
+};
+
+static const gchar *state_names[] = {
+  "normal",
+  "active",
+  "prelight",
+  "selected",
+  "insensitive"
+};
+
+/* one call of a draw function */
+typedef struct
+{
+  DawatiVfunc   vfunc;
+  const gchar  *detail;
+  GtkStateType  state;
+  GtkWidget    *widget;
+  gint          x;
+  gint          y;
+  gint          width;
+  gint          height;
+  gboolean      has_area;
+  GdkRectangle  area;
+  guint64       start;
+  guint64       duration;
+
+  /* X requests made by the call, and whether it waited for a reply */
+  gulong        x_requests;
+  gboolean      x_round_trip;
+#ifdef GDK_WINDOWING_X11
+  Display      *xdisplay;
+  gulong        x_next_request;
+#endif
+} DawatiDrawCall;
+
+/* the calls of one draw function with one detail in one state */
+typedef struct
+{
+  DawatiVfunc   vfunc;
+  const gchar  *detail; /* interned */
+  GtkStateType  state;
+
+  guint64       calls;
+  guint64       total_ns;
+  guint64       max_ns;
+  guint64       pixels;
+  guint64       x_requests;
+  guint64       x_round_trips;
+  guint64       histogram[N_BUCKETS];
+} DawatiDrawStats;
+
+/* the draw functions set by DawatiStyle's class_init */
+static GtkStyleClass real_class;
+
+static GHashTable *stats = NULL;
+static gchar *stats_file = NULL;
+static volatile sig_atomic_t dump_requested = 0;
+
+G_LOCK_DEFINE_STATIC (stats);
+
+/* a finished call, waiting to be written to the trace */
+typedef struct
+{
+  guint64       start;
+  guint64       duration;
+  gulong        tid;
+  DawatiVfunc   vfunc;
+  const gchar  *detail;    /* interned */
+  const gchar  *type_name; /* of the widget, static */
+  GtkStateType  state;
+  gint          width;
+  gint          height;
+  gboolean      has_area;
+  GdkRectangle  area;
+} DawatiTraceEvent;
+
+/* number of events buffered before they are written out */
+#define TRACE_BUFFER_SIZE 4096
+
+#if GLIB_CHECK_VERSION (2, 30, 0)
+#define trace_fetch_and_add(atomic, val) g_atomic_int_add (atomic, val)
+#else
+#define trace_fetch_and_add(atomic, val) \
+  g_atomic_int_exchange_and_add (atomic, val)
+#endif
+
+/* Slots in the buffer are claimed with an atomic increment of trace_head,
+ * and trace_committed counts the events that have been filled in. Whoever
+ * claims the first slot past the end waits for the other writers, writes
+ * the buffer out and resets both counters; everyone else waits for that. */
+static DawatiTraceEvent *trace_events = NULL;
+static volatile gint trace_head = 0;
+static volatile gint trace_committed = 0;
+static FILE *trace_file = NULL;
+static gboolean trace_empty = TRUE;
+
+/* slow calls of one draw function with one detail, for one widget class */
+typedef struct
+{
+  DawatiVfunc   vfunc;
+  const gchar  *detail;     /* interned */
+  gchar        *class_path;
+
+  guint         count;
+  guint64       total_ns;
+
+  /* the slowest of the calls */
+  guint64       max_ns;
+  GtkStateType  state;
+  gint          width;
+  gint          height;
+  gchar        *path;
+} DawatiSlowDraw;
+
+/* slow calls are collected and reported at most this often */
+#define SLOW_REPORT_INTERVAL (G_GUINT64_CONSTANT (5) * 1000000000)
+/* and only the worst few of them */
+#define SLOW_REPORT_MAX 10
+
+static guint64 slow_threshold_ns = 0;
+static GHashTable *slow_draws = NULL;
+static guint64 slow_last_report = 0;
+
+G_LOCK_DEFINE_STATIC (slow_draws);
+
+static guint64
+dawati_debug_now_ns (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+
+  return (guint64) ts.tv_sec * G_GUINT64_CONSTANT (1000000000) + ts.tv_nsec;
+}
+
+static guint
+dawati_draw_stats_hash (gconstpointer key)
+{
+  const DawatiDrawStats *s = key;
+
+  return (s->vfunc << 8 | s->state) ^ g_direct_hash (s->detail);
+}
+
+static gboolean
+dawati_draw_stats_equal (gconstpointer a,
+                         gconstpointer b)
+{
+  const DawatiDrawStats *sa = a;
+  const DawatiDrawStats *sb = b;
+
+  /* the details are interned, so comparing pointers is enough */
+  return sa->vfunc == sb->vfunc
+    && sa->state == sb->state
+    && sa->detail == sb->detail;
+}
+
+static void
+json_append_string (GString     *out,
+                    const gchar *str)
+{
+  if (!str)
+    {
+      g_string_append (out, "null");
+      return;
+    }
+
+  g_string_append_c (out, '"');
+
+  for (; *str; str++)
+    {
+      if (*str == '"' || *str == '\\')
+        g_string_append_printf (out, "\\%c", *str);
+      else if ((guchar) *str < 0x20)
+        g_string_append_printf (out, "\\u%04x", (guchar) *str);
+      else
+        g_string_append_c (out, *str);
+    }
+
+  g_string_append_c (out, '"');
+}
+
+/* most expensive first */
+static gint
+dawati_draw_stats_compare (gconstpointer a,
+                           gconstpointer b)
+{
+  const DawatiDrawStats *sa = *(DawatiDrawStats **) a;
+  const DawatiDrawStats *sb = *(DawatiDrawStats **) b;
+
+  if (sa->total_ns != sb->total_ns)
+    return sa->total_ns < sb->total_ns ? 1 : -1;
+
+  return 0;
+}
+
+static void
+dawati_debug_dump_stats (void)
+{
+  GHashTableIter iter;
+  GPtrArray *sorted;
+  DawatiDrawStats *s;
+  GString *out;
+  guint64 calls = 0, total_ns = 0, x_requests = 0, x_round_trips = 0;
+  FILE *file;
+  guint i;
+
+  G_LOCK (stats);
+
+  if (!stats)
+    {
+      G_UNLOCK (stats);
+      return;
+    }
+
+  sorted = g_ptr_array_new ();
+
+  g_hash_table_iter_init (&iter, stats);
+  while (g_hash_table_iter_next (&iter, (gpointer *) &s, NULL))
+    {
+      g_ptr_array_add (sorted, s);
+      calls += s->calls;
+      total_ns += s->total_ns;
+      x_requests += s->x_requests;
+      x_round_trips += s->x_round_trips;
+    }
+
+  g_ptr_array_sort (sorted, dawati_draw_stats_compare);
+
+  out = g_string_new (NULL);
+  g_string_append_printf (out,
+                          "{\"pid\":%d,\"calls\":%" G_GUINT64_FORMAT
+                          ",\"total_ns\":%" G_GUINT64_FORMAT
+                          ",\"x_requests\":%" G_GUINT64_FORMAT
+                          ",\"x_round_trips\":%" G_GUINT64_FORMAT
+                          ",\"draws\":[",
+                          (int) getpid (), calls, total_ns, x_requests,
+                          x_round_trips);
+
+  for (i = 0; i < sorted->len; i++)
+    {
+      gboolean first = TRUE;
+      gint b;
+
+      s = g_ptr_array_index (sorted, i);
+
+      if (i > 0)
+        g_string_append_c (out, ',');
+
+      g_string_append (out, "{\"vfunc\":");
+      json_append_string (out, vfunc_names[s->vfunc]);
+      g_string_append (out, ",\"detail\":");
+      json_append_string (out, s->detail);
+      g_string_append (out, ",\"state\":");
+      json_append_string (out, (guint) s->state < G_N_ELEMENTS (state_names)
+                          ? state_names[s->state] : NULL);
+      g_string_append_printf (out,
+                              ",\"calls\":%" G_GUINT64_FORMAT
+                              ",\"total_ns\":%" G_GUINT64_FORMAT
+                              ",\"mean_ns\":%" G_GUINT64_FORMAT
+                              ",\"max_ns\":%" G_GUINT64_FORMAT
+                              ",\"pixels\":%" G_GUINT64_FORMAT
+                              ",\"x_requests\":%" G_GUINT64_FORMAT
+                              ",\"x_round_trips\":%" G_GUINT64_FORMAT
+                              ",\"histogram\":[",
+                              s->calls, s->total_ns, s->total_ns / s->calls,
+                              s->max_ns, s->pixels, s->x_requests,
+                              s->x_round_trips);
+
+      /* [upper bound in ns, calls] for the buckets in use */
+      for (b = 0; b < N_BUCKETS; b++)
+        {
+          if (!s->histogram[b])
+            continue;
+
+          if (b < N_BUCKETS - 1)
+            g_string_append_printf (out, "%s[%" G_GUINT64_FORMAT
+                                    ",%" G_GUINT64_FORMAT "]",
+                                    first ? "" : ",",
+                                    G_GUINT64_CONSTANT (1) << b,
+                                    s->histogram[b]);
+          else
+            g_string_append_printf (out, "%s[null,%" G_GUINT64_FORMAT "]",
+                                    first ? "" : ",", s->histogram[b]);
+          first = FALSE;
+        }
+
+      g_string_append (out, "]}");
+    }
+
+  g_string_append (out, "]}\n");
+
+  G_UNLOCK (stats);
+
+  g_ptr_array_free (sorted, TRUE);
+
+  file = stats_file ? fopen (stats_file, "a") : stdout;
+  if (file)
+    {
+      fputs (out->str, file);
+      if (file == stdout)
+        fflush (file);
+      else
+        fclose (file);
+    }
+  else
+    {
+      g_warning ("Could not write the engine statistics to %s: %s",
+                 stats_file, g_strerror (errno));
+    }
+
+  g_string_free (out, TRUE);
+}
+
+static void
+dawati_debug_signal_handler (int signum)
+{
+  /* only set a flag here, the next draw call writes the statistics */
+  dump_requested = 1;
+}
+
+static int
+dawati_debug_parse_signal (const gchar *name)
+{
+  static const struct { const gchar *name; int signum; } signals[] = {
+    { "HUP", SIGHUP },
+    { "USR1", SIGUSR1 },
+    { "USR2", SIGUSR2 }
+  };
+  guint i;
+
+  if (g_ascii_isdigit (*name))
+    return atoi (name);
+
+  if (g_ascii_strncasecmp (name, "SIG", 3) == 0)
+    name += 3;
+
+  for (i = 0; i < G_N_ELEMENTS (signals); i++)
+    if (g_ascii_strcasecmp (name, signals[i].name) == 0)
+      return signals[i].signum;
+
+  return 0;
+}
+
+static void
+dawati_debug_begin (DawatiDrawCall *call,
+                    DawatiVfunc     vfunc,
+                    GdkWindow      *window,
+                    GtkWidget      *widget,
+                    const gchar    *detail,
+                    GtkStateType    state,
+                    GdkRectangle   *area,
+                    gint            x,
+                    gint            y,
+                    gint            width,
+                    gint            height)
+{
+#ifdef GDK_WINDOWING_X11
+  GdkDisplay *display;
+#endif
+
+  call->vfunc = vfunc;
+  call->detail = detail;
+  call->state = state;
+  call->widget = widget;
+
+  /* the real draw function only resolves a size of -1 once it runs, but
+   * the call is recorded with the size it draws */
+  if (window && (width == -1 || height == -1))
+    gdk_drawable_get_size (window, width == -1 ? &width : NULL,
+                           height == -1 ? &height : NULL);
+
+  call->x = x;
+  call->y = y;
+  call->width = width;
+  call->height = height;
+
+  call->has_area = area != NULL;
+  if (area)
+    call->area = *area;
+
+  call->x_requests = 0;
+  call->x_round_trip = FALSE;
+#ifdef GDK_WINDOWING_X11
+  /* the requests that count are those on the display being drawn to */
+  if (window)
+    display = gdk_drawable_get_display (window);
+  else if (widget)
+    display = gtk_widget_get_display (widget);
+  else
+    display = gdk_display_get_default ();
+
+  call->xdisplay = GDK_DISPLAY_XDISPLAY (display);
+  call->x_next_request = NextRequest (call->xdisplay);
+#endif
+
+  call->start = dawati_debug_now_ns ();
+}
+
+static void
+dawati_debug_record_stats (const DawatiDrawCall *call)
+{
+  DawatiDrawStats key, *s;
+  GdkRectangle rect;
+  guint bucket;
+
+  /* lines are one pixel wide */
+  rect.x = call->x;
+  rect.y = call->y;
+  rect.width = MAX (call->width, 1);
+  rect.height = MAX (call->height, 1);
+
+  if (call->has_area && !gdk_rectangle_intersect (&call->area, &rect, &rect))
+    rect.width = rect.height = 0;
+
+  G_LOCK (stats);
+
+  key.vfunc = call->vfunc;
+  key.detail = g_intern_string (call->detail);
+  key.state = call->state;
+
+  s = g_hash_table_lookup (stats, &key);
+  if (!s)
+    {
+      s = g_slice_new0 (DawatiDrawStats);
+      s->vfunc = key.vfunc;
+      s->detail = key.detail;
+      s->state = key.state;
+      g_hash_table_insert (stats, s, s);
+    }
+
+  bucket = MIN (g_bit_storage (call->duration), N_BUCKETS - 1);
+
+  s->calls++;
+  s->total_ns += call->duration;
+  s->max_ns = MAX (s->max_ns, call->duration);
+  s->pixels += (guint64) rect.width * rect.height;
+  s->x_requests += call->x_requests;
+  s->x_round_trips += call->x_round_trip;
+  s->histogram[bucket]++;
+
+  G_UNLOCK (stats);
+
+  if (dump_requested)
+    {
+      dump_requested = 0;
+      dawati_debug_dump_stats ();
+    }
+}
+
+static gulong
+dawati_trace_get_tid (void)
+{
+#ifdef SYS_gettid
+  return syscall (SYS_gettid);
+#else
+  return getpid ();
+#endif
+}
+
+/* Writes out the first n events of the buffer. The writers must all have
+ * finished with them. */
+static void
+dawati_trace_write_events (gint n)
+{
+  GString *out;
+  gint i;
+
+  out = g_string_new (NULL);
+
+  for (i = 0; i < n; i++)
+    {
+      const DawatiTraceEvent *event = &trace_events[i];
+
+      g_string_truncate (out, 0);
+
+      /* timestamps and durations are in microseconds */
+      g_string_append_printf (out,
+                              "%s{\"name\":\"%s\",\"cat\":\"dawati\","
+                              "\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,"
+                              "\"pid\":%d,\"tid\":%lu,\"args\":{"
+                              "\"detail\":",
+                              trace_empty ? "" : ",\n",
+                              vfunc_names[event->vfunc],
+                              event->start / 1000.0,
+                              event->duration / 1000.0,
+                              (int) getpid (), event->tid);
+      json_append_string (out, event->detail);
+      g_string_append (out, ",\"state\":");
+      json_append_string (out,
+                          (guint) event->state < G_N_ELEMENTS (state_names)
+                          ? state_names[event->state] : NULL);
+      g_string_append_printf (out, ",\"width\":%d,\"height\":%d,\"area\":",
+                              event->width, event->height);
+      if (event->has_area)
+        g_string_append_printf (out, "[%d,%d,%d,%d]",
+                                event->area.x, event->area.y,
+                                event->area.width, event->area.height);
+      else
+        g_string_append (out, "null");
+      g_string_append (out, ",\"widget\":");
+      json_append_string (out, event->type_name);
+      g_string_append (out, "}}");
+
+      fputs (out->str, trace_file);
+      trace_empty = FALSE;
+    }
+
+  fflush (trace_file);
+
+  g_string_free (out, TRUE);
+}
+
+static void
+dawati_trace_record (const DawatiDrawCall *call)
+{
+  DawatiTraceEvent *event;
+  gint slot;
+
+  for (;;)
+    {
+      slot = trace_fetch_and_add (&trace_head, 1);
+      if (slot < TRACE_BUFFER_SIZE)
+        break;
+
+      if (slot == TRACE_BUFFER_SIZE)
+        {
+          /* the buffer is full, write it out once every event is there */
+          while (g_atomic_int_get (&trace_committed) < TRACE_BUFFER_SIZE)
+            g_thread_yield ();
+
+          dawati_trace_write_events (TRACE_BUFFER_SIZE);
+
+          g_atomic_int_set (&trace_committed, 0);
+          g_atomic_int_set (&trace_head, 0);
+        }
+      else
+        {
+          while (g_atomic_int_get (&trace_head) > TRACE_BUFFER_SIZE)
+            g_thread_yield ();
+        }
+    }
+
+  event = &trace_events[slot];
+  event->start = call->start;
+  event->duration = call->duration;
+  event->tid = dawati_trace_get_tid ();
+  event->vfunc = call->vfunc;
+  event->detail = g_intern_string (call->detail);
+  event->type_name = call->widget ? G_OBJECT_TYPE_NAME (call->widget) : NULL;
+  event->state = call->state;
+  event->width = call->width;
+  event->height = call->height;
+  event->has_area = call->has_area;
+  event->area = call->area;
+
+  g_atomic_int_inc (&trace_committed);
+}
+
+static void
+dawati_trace_close (void)
+{
+  /* nothing else is drawing by now */
+  dawati_trace_write_events (MIN (g_atomic_int_get (&trace_committed),
+                                  TRACE_BUFFER_SIZE));
+  fputs ("\n]\n", trace_file);
+  fclose (trace_file);
+  trace_file = NULL;
+}
+
+static void
+dawati_slow_draw_free (DawatiSlowDraw *slow)
+{
+  g_free (slow->class_path);
+  g_free (slow->path);
+  g_slice_free (DawatiSlowDraw, slow);
+}
+
+/* most time spent first */
+static gint
+dawati_slow_draw_compare (gconstpointer a,
+                          gconstpointer b)
+{
+  const DawatiSlowDraw *sa = *(DawatiSlowDraw **) a;
+  const DawatiSlowDraw *sb = *(DawatiSlowDraw **) b;
+
+  if (sa->total_ns != sb->total_ns)
+    return sa->total_ns < sb->total_ns ? 1 : -1;
+
+  return 0;
+}
+
+/* Prints what was collected since the last report, and forgets it. Must
+ * be called with the lock held. */
+static void
+dawati_slow_report (void)
+{
+  GHashTableIter iter;
+  GPtrArray *sorted;
+  DawatiSlowDraw *slow;
+  guint i;
+
+  if (g_hash_table_size (slow_draws) == 0)
+    return;
+
+  sorted = g_ptr_array_new ();
+
+  g_hash_table_iter_init (&iter, slow_draws);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &slow))
+    g_ptr_array_add (sorted, slow);
+
+  g_ptr_array_sort (sorted, dawati_slow_draw_compare);
+
+  for (i = 0; i < MIN (sorted->len, SLOW_REPORT_MAX); i++)
+    {
+      slow = g_ptr_array_index (sorted, i);
+
+      g_printerr ("dawati: slow %s, detail '%s': %u calls over %"
+                  G_GUINT64_FORMAT " us, %" G_GUINT64_FORMAT " us in total;"
+                  " slowest %" G_GUINT64_FORMAT " us, state %s, %dx%d\n"
+                  "  widget: %s\n"
+                  "  widget_class: %s\n",
+                  vfunc_names[slow->vfunc],
+                  slow->detail ? slow->detail : "",
+                  slow->count, slow_threshold_ns / 1000,
+                  slow->total_ns / 1000, slow->max_ns / 1000,
+                  (guint) slow->state < G_N_ELEMENTS (state_names)
+                  ? state_names[slow->state] : "unknown",
+                  slow->width, slow->height,
+                  slow->path, slow->class_path);
+    }
+
+  if (sorted->len > SLOW_REPORT_MAX)
+    g_printerr ("dawati: and %u more kinds of slow draw\n",
+                sorted->len - SLOW_REPORT_MAX);
+
+  g_ptr_array_free (sorted, TRUE);
+
+  g_hash_table_remove_all (slow_draws);
+}
+
+static void
+dawati_slow_record (const DawatiDrawCall *call)
+{
+  DawatiSlowDraw *slow;
+  gchar *path, *class_path, *key;
+  const gchar *detail;
+  guint64 now;
+
+  detail = g_intern_string (call->detail);
+
+  if (call->widget)
+    {
+      gtk_widget_path (call->widget, NULL, &path, NULL);
+      gtk_widget_class_path (call->widget, NULL, &class_path, NULL);
+    }
+  else
+    {
+      path = g_strdup ("(none)");
+      class_path = g_strdup ("(none)");
+    }
+
+  key = g_strdup_printf ("%d %s %s", call->vfunc, detail ? detail : "",
+                         class_path);
+
+  G_LOCK (slow_draws);
+
+  slow = g_hash_table_lookup (slow_draws, key);
+  if (!slow)
+    {
+      slow = g_slice_new0 (DawatiSlowDraw);
+      slow->vfunc = call->vfunc;
+      slow->detail = detail;
+      slow->class_path = class_path;
+      class_path = NULL;
+
+      g_hash_table_insert (slow_draws, key, slow);
+      key = NULL;
+    }
+
+  slow->count++;
+  slow->total_ns += call->duration;
+
+  if (call->duration > slow->max_ns)
+    {
+      slow->max_ns = call->duration;
+      slow->state = call->state;
+      slow->width = call->width;
+      slow->height = call->height;
+
+      g_free (slow->path);
+      slow->path = path;
+      path = NULL;
+    }
+
+  now = dawati_debug_now_ns ();
+  if (slow_last_report == 0 || now - slow_last_report >= SLOW_REPORT_INTERVAL)
+    {
+      dawati_slow_report ();
+      slow_last_report = now;
+    }
+
+  G_UNLOCK (slow_draws);
+
+  g_free (key);
+  g_free (class_path);
+  g_free (path);
+}
+
+static void
+dawati_slow_report_at_exit (void)
+{
+  G_LOCK (slow_draws);
+  dawati_slow_report ();
+  G_UNLOCK (slow_draws);
+}
+
+static void
+dawati_debug_end (DawatiDrawCall *call)
+{
+  call->duration = dawati_debug_now_ns () - call->start;
+
+#ifdef GDK_WINDOWING_X11
+  /* Xlib only learns that the server got as far as one of our requests by
+   * reading a reply, an error or an event sent after it, so the call must
+   * have waited for the server at least once. */
+  call->x_requests = NextRequest (call->xdisplay) - call->x_next_request;
+  call->x_round_trip =
+    LastKnownRequestProcessed (call->xdisplay) >= call->x_next_request;
+#endif
+
+  if (stats)
+    dawati_debug_record_stats (call);
+
+  if (trace_file)
+    dawati_trace_record (call);
+
+  /* checked here so that fast calls don't pay for the widget paths */
+  if (slow_threshold_ns && call->duration >= slow_threshold_ns)
+    dawati_slow_record (call);
+}
+
+static void
+dawati_debug_draw_shadow (GtkStyle      *style,
+                          GdkWindow     *window,
+                          GtkStateType   state_type,
+                          GtkShadowType  shadow_type,
+                          GdkRectangle  *area,
+                          GtkWidget     *widget,
+                          const gchar   *detail,
+                          gint           x,
+                          gint           y,
+                          gint           width,
+                          gint           height)
+{
+  DawatiDrawCall call;
+
+  dawati_debug_begin (&call, DAWATI_VFUNC_SHADOW, window, widget, detail,
+                      state_type, area, x, y, width, height);
+  real_class.draw_shadow (style, window, state_type, shadow_type, area,
+                          widget, detail, x, y, width, height);
+  dawati_debug_end (&call);
+}
+
+static void
+dawati_debug_draw_box (GtkStyle      *style,
+                       GdkWindow     *window,
+                       GtkStateType   state_type,
+                       GtkShadowType  shadow_type,
+                       GdkRectangle  *area,
+                       GtkWidget     *widget,
+                       const gchar   *detail,
+                       gint           x,
+                       gint           y,
+                       gint           width,
+                       gint           height)
+{
+  DawatiDrawCall call;
+
+  dawati_debug_begin (&call, DAWATI_VFUNC_BOX, window, widget, detail,
+                      state_type, area, x, y, width, height);
+  real_class.draw_box (style, window, state_type, shadow_type, area,
+                       widget, detail, x, y, width, height);
+  dawati_debug_end (&call);
+}
+
+static void
+dawati_debug_draw_flat_box (GtkStyle      *style,
+                            GdkWindow     *window,
+                            GtkStateType   state_type,
+                            GtkShadowType  shadow_type,
+                            GdkRectangle  *area,
+                            GtkWidget     *widget,
+                            const gchar   *detail,
+                            gint           x,
+                            gint           y,
+                            gint           width,
+                            gint           height)
+{
+  DawatiDrawCall call;
+
+  dawati_debug_begin (&call, DAWATI_VFUNC_FLAT_BOX, window, widget, detail,
+                      state_type, area, x, y, width, height);
+  real_class.draw_flat_box (style, window, state_type, shadow_type, area,
+                            widget, detail, x, y, width, height);
+  dawati_debug_end (&call);
+}
+
+static void
+dawati_debug_draw_check (GtkStyle      *style,
+                         GdkWindow     *window,
+                         GtkStateType   state_type,
+                         GtkShadowType  shadow_type,
+                         GdkRectangle  *area,
+                         GtkWidget     *widget,
+                         const gchar   *detail,
+                         gint           x,
+                         gint           y,
+                         gint           width,
+                         gint           height)
+{
+  DawatiDrawCall call;
+
+  dawati_debug_begin (&call, DAWATI_VFUNC_CHECK, window, widget, detail,
+                      state_type, area, x, y, width, height);
+  real_class.draw_check (style, window, state_type, shadow_type, area,
+                         widget, detail, x, y, width, height);
+  dawati_debug_end (&call);
+}
+
+static void
+dawati_debug_draw_option (GtkStyle      *style,
+                          GdkWindow     *window,
+                          GtkStateType   state_type,
+                          GtkShadowType  shadow_type,
+                          GdkRectangle  *area,
+                          GtkWidget     *widget,
+                          const gchar   *detail,
+                          gint           x,
+                          gint           y,
+                          gint           width,
+                          gint           height)
+{
+  DawatiDrawCall call;
+
+  dawati_debug_begin (&call, DAWATI_VFUNC_OPTION, window, widget, detail,
+                      state_type, area, x, y, width, height);
+  real_class.draw_option (style, window, state_type, shadow_type, area,
+                          widget, detail, x, y, width, height);
+  dawati_debug_end (&call);
+}
+
+static void
+dawati_debug_draw_box_gap (GtkStyle        *style,
+                           GdkWindow       *window,
+                           GtkStateType     state_type,
+                           GtkShadowType    shadow_type,
+                           GdkRectangle    *area,
+                           GtkWidget       *widget,
+                           const gchar     *detail,
+                           gint             x,
+                           gint             y,
+                           gint             width,
+                           gint             height,
+                           GtkPositionType  gap_side,
+                           gint             gap_x,
+                           gint             gap_width)
+{
+  DawatiDrawCall call;
+
+  dawati_debug_begin (&call, DAWATI_VFUNC_BOX_GAP, window, widget, detail,
+                      state_type, area, x, y, width, height);
+  real_class.draw_box_gap (style, window, state_type, shadow_type, area,
+                           widget, detail, x, y, width, height,
+                           gap_side, gap_x, gap_width);
+  dawati_debug_end (&call);
+}
+
+static void
+dawati_debug_draw_shadow_gap (GtkStyle        *style,
+                              GdkWindow       *window,
+                              GtkStateType     state_type,
+                              GtkShadowType    shadow_type,
+                              GdkRectangle    *area,
+                              GtkWidget       *widget,
+                              const gchar     *detail,
+                              gint             x,
+                              gint             y,
+                              gint             width,
+                              gint             height,
+                              GtkPositionType  gap_side,
+                              gint             gap_x,
+                              gint             gap_width)
+{
+  DawatiDrawCall call;
+
+  dawati_debug_begin (&call, DAWATI_VFUNC_SHADOW_GAP, window, widget, detail,
+                      state_type, area, x, y, width, height);
+  real_class.draw_shadow_gap (style, window, state_type, shadow_type, area,
+                              widget, detail, x, y, width, height,
+                              gap_side, gap_x, gap_width);
+  dawati_debug_end (&call);
+}
+
+static void
+dawati_debug_draw_extension (GtkStyle        *style,
+                             GdkWindow       *window,
+                             GtkStateType     state_type,
+                             GtkShadowType    shadow_type,
+                             GdkRectangle    *area,
+                             GtkWidget       *widget,
+                             const gchar     *detail,
+                             gint             x,
+                             gint             y,
+                             gint             width,
+                             gint             height,
+                             GtkPositionType  gap_side)
+{
+  DawatiDrawCall call;
+
+  dawati_debug_begin (&call, DAWATI_VFUNC_EXTENSION, window, widget, detail,
+                      state_type, area, x, y, width, height);
+  real_class.draw_extension (style, window, state_type, shadow_type, area,
+                             widget, detail, x, y, width, height, gap_side);
+  dawati_debug_end (&call);
+}
+
+static void
+dawati_debug_draw_hline (GtkStyle     *style,
+                         GdkWindow    *window,
+                         GtkStateType  state_type,
+                         GdkRectangle *area,
+                         GtkWidget    *widget,
+                         const gchar  *detail,
+                         gint          x1,
+                         gint          x2,
+                         gint          y)
+{
+  DawatiDrawCall call;
+
+  dawati_debug_begin (&call, DAWATI_VFUNC_HLINE, window, widget, detail,
+                      state_type, area, x1, y, x2 - x1, 1);
+  real_class.draw_hline (style, window, state_type, area, widget, detail,
+                         x1, x2, y);
+  dawati_debug_end (&call);
+}
+
+static void
+dawati_debug_draw_vline (GtkStyle     *style,
+                         GdkWindow    *window,
+                         GtkStateType  state_type,
+                         GdkRectangle *area,
+                         GtkWidget    *widget,
+                         const gchar  *detail,
+                         gint          y1,
+                         gint          y2,
+                         gint          x)
+{
+  DawatiDrawCall call;
+
+  dawati_debug_begin (&call, DAWATI_VFUNC_VLINE, window, widget, detail,
+                      state_type, area, x, y1, 1, y2 - y1);
+  real_class.draw_vline (style, window, state_type, area, widget, detail,
+                         y1, y2, x);
+  dawati_debug_end (&call);
+}
+
+static void
+dawati_debug_draw_focus (GtkStyle     *style,
+                         GdkWindow    *window,
+                         GtkStateType  state_type,
+                         GdkRectangle *area,
+                         GtkWidget    *widget,
+                         const gchar  *detail,
+                         gint          x,
+                         gint          y,
+                         gint          width,
+                         gint          height)
+{
+  DawatiDrawCall call;
+
+  dawati_debug_begin (&call, DAWATI_VFUNC_FOCUS, window, widget, detail,
+                      state_type, area, x, y, width, height);
+  real_class.draw_focus (style, window, state_type, area, widget, detail,
+                         x, y, width, height);
+  dawati_debug_end (&call);
+}
+
+static void
+dawati_debug_draw_arrow (GtkStyle      *style,
+                         GdkWindow     *window,
+                         GtkStateType   state_type,
+                         GtkShadowType  shadow_type,
+                         GdkRectangle  *area,
+                         GtkWidget     *widget,
+                         const gchar   *detail,
+                         GtkArrowType   arrow_type,
+                         gboolean       fill,
+                         gint           x,
+                         gint           y,
+                         gint           width,
+                         gint           height)
+{
+  DawatiDrawCall call;
+
+  dawati_debug_begin (&call, DAWATI_VFUNC_ARROW, window, widget, detail,
+                      state_type, area, x, y, width, height);
+  real_class.draw_arrow (style, window, state_type, shadow_type, area,
+                         widget, detail, arrow_type, fill,
+                         x, y, width, height);
+  dawati_debug_end (&call);
+}
+
+static void
+dawati_debug_draw_handle (GtkStyle       *style,
+                          GdkWindow      *window,
+                          GtkStateType    state_type,
+                          GtkShadowType   shadow_type,
+                          GdkRectangle   *area,
+                          GtkWidget      *widget,
+                          const gchar    *detail,
+                          gint            x,
+                          gint            y,
+                          gint            width,
+                          gint            height,
+                          GtkOrientation  orientation)
+{
+  DawatiDrawCall call;
+
+  dawati_debug_begin (&call, DAWATI_VFUNC_HANDLE, window, widget, detail,
+                      state_type, area, x, y, width, height);
+  real_class.draw_handle (style, window, state_type, shadow_type, area,
+                          widget, detail, x, y, width, height, orientation);
+  dawati_debug_end (&call);
+}
+
+static void
+dawati_debug_draw_slider (GtkStyle       *style,
+                          GdkWindow      *window,
+                          GtkStateType    state_type,
+                          GtkShadowType   shadow_type,
+                          GdkRectangle   *area,
+                          GtkWidget      *widget,
+                          const gchar    *detail,
+                          gint            x,
+                          gint            y,
+                          gint            width,
+                          gint            height,
+                          GtkOrientation  orientation)
+{
+  DawatiDrawCall call;
+
+  dawati_debug_begin (&call, DAWATI_VFUNC_SLIDER, window, widget, detail,
+                      state_type, area, x, y, width, height);
+  real_class.draw_slider (style, window, state_type, shadow_type, area,
+                          widget, detail, x, y, width, height, orientation);
+  dawati_debug_end (&call);
+}
+
+static void
+dawati_debug_draw_resize_grip (GtkStyle      *style,
+                               GdkWindow     *window,
+                               GtkStateType   state_type,
+                               GdkRectangle  *area,
+                               GtkWidget     *widget,
+                               const gchar   *detail,
+                               GdkWindowEdge  edge,
+                               gint           x,
+                               gint           y,
+                               gint           width,
+                               gint           height)
+{
+  DawatiDrawCall call;
+
+  dawati_debug_begin (&call, DAWATI_VFUNC_RESIZE_GRIP, window, widget, detail,
+                      state_type, area, x, y, width, height);
+  real_class.draw_resize_grip (style, window, state_type, area, widget,
+                               detail, edge, x, y, width, height);
+  dawati_debug_end (&call);
+}
+
+static void
+dawati_debug_draw_layout (GtkStyle     *style,
+                          GdkWindow    *window,
+                          GtkStateType  state_type,
+                          gboolean      use_text,
+                          GdkRectangle *area,
+                          GtkWidget    *widget,
+                          const gchar  *detail,
+                          gint          x,
+                          gint          y,
+                          PangoLayout  *layout)
+{
+  DawatiDrawCall call;
+  gint width, height;
+
+  pango_layout_get_pixel_size (layout, &width, &height);
+
+  dawati_debug_begin (&call, DAWATI_VFUNC_LAYOUT, window, widget, detail,
+                      state_type, area, x, y, width, height);
+  real_class.draw_layout (style, window, state_type, use_text, area, widget,
+                          detail, x, y, layout);
+  dawati_debug_end (&call);
+}
+
+static GdkPixbuf *
+dawati_debug_render_icon (GtkStyle            *style,
+                          const GtkIconSource *source,
+                          GtkTextDirection     direction,
+                          GtkStateType         state,
+                          GtkIconSize          size,
+                          GtkWidget           *widget,
+                          const gchar         *detail)
+{
+  DawatiDrawCall call;
+  GdkPixbuf *pixbuf;
+
+  dawati_debug_begin (&call, DAWATI_VFUNC_RENDER_ICON, NULL, widget, detail,
+                      state, NULL, 0, 0, 0, 0);
+  pixbuf = real_class.render_icon (style, source, direction, state, size,
+                                   widget, detail);
+
+  /* the size is only known once the icon has been made */
+  call.width = pixbuf ? gdk_pixbuf_get_width (pixbuf) : 0;
+  call.height = pixbuf ? gdk_pixbuf_get_height (pixbuf) : 0;
+  dawati_debug_end (&call);
+
+  return pixbuf;
+}
+
+static void
+dawati_debug_draw_expander (GtkStyle         *style,
+                            GdkWindow        *window,
+                            GtkStateType      state_type,
+                            GdkRectangle     *area,
+                            GtkWidget        *widget,
+                            const gchar      *detail,
+                            gint              x,
+                            gint              y,
+                            GtkExpanderStyle  expander_style)
+{
+  DawatiDrawCall call;
+  gint size = 12;
+
+  /* x and y are the centre of the expander */
+  if (widget && gtk_widget_class_find_style_property
+      (GTK_WIDGET_GET_CLASS (widget), "expander-size"))
+    gtk_widget_style_get (widget, "expander-size", &size, NULL);
+
+  dawati_debug_begin (&call, DAWATI_VFUNC_EXPANDER, window, widget, detail,
+                      state_type, area, x - size / 2, y - size / 2, size,
+                      size);
+  real_class.draw_expander (style, window, state_type, area, widget, detail,
+                            x, y, expander_style);
+  dawati_debug_end (&call);
+}
+
+void
+dawati_debug_install (GtkStyleClass   *klass,
+                      DawatiDebugMode  mode)
+{
+  const gchar *signal_name;
+  const gchar *trace_name;
+  const gchar *slow_name;
+
+  trace_name = g_getenv ("DAWATI_ENGINE_TRACE");
+  if (trace_name)
+    {
+      trace_file = fopen (trace_name, "w");
+      if (trace_file)
+        {
+          trace_events = g_new (DawatiTraceEvent, TRACE_BUFFER_SIZE);
+          fputs ("[\n", trace_file);
+          atexit (dawati_trace_close);
+        }
+      else
+        {
+          g_warning ("Could not open the engine trace %s: %s",
+                     trace_name, g_strerror (errno));
+        }
+    }
+
+  if (mode == DAWATI_DEBUG_STATS)
+    {
+      stats = g_hash_table_new (dawati_draw_stats_hash,
+                                dawati_draw_stats_equal);
+      stats_file = g_strdup (g_getenv ("DAWATI_ENGINE_STATS_FILE"));
+
+      atexit (dawati_debug_dump_stats);
+    }
+
+  /* e.g. DAWATI_ENGINE_SLOW_US=5000 to hear about calls over 5 ms */
+  slow_name = g_getenv ("DAWATI_ENGINE_SLOW_US");
+  if (slow_name)
+    {
+      slow_threshold_ns = g_ascii_strtoull (slow_name, NULL, 10) * 1000;
+
+      if (slow_threshold_ns)
+        {
+          slow_draws = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                              (GDestroyNotify)
+                                              dawati_slow_draw_free);
+          atexit (dawati_slow_report_at_exit);
+        }
+    }
+
+  if (!stats && !trace_file && !slow_threshold_ns)
+    return;
+
+  /* e.g. DAWATI_ENGINE_STATS_SIGNAL=USR1, then kill -USR1 <pid> */
+  signal_name = g_getenv ("DAWATI_ENGINE_STATS_SIGNAL");
+  if (stats && signal_name)
+    {
+      struct sigaction action;
+      int signum;
+
+      signum = dawati_debug_parse_signal (signal_name);
+      if (signum > 0)
+        {
+          memset (&action, 0, sizeof (action));
+          action.sa_handler = dawati_debug_signal_handler;
+          action.sa_flags = SA_RESTART;
+          sigemptyset (&action.sa_mask);
+          sigaction (signum, &action, NULL);
+        }
+      else
+        {
+          g_warning ("Unknown signal in DAWATI_ENGINE_STATS_SIGNAL: %s",
+                     signal_name);
+        }
+    }
+
+  real_class = *klass;
+
+  klass->draw_shadow = dawati_debug_draw_shadow;
+  klass->draw_box = dawati_debug_draw_box;
+  klass->draw_flat_box = dawati_debug_draw_flat_box;
+  klass->draw_check = dawati_debug_draw_check;
+  klass->draw_option = dawati_debug_draw_option;
+  klass->draw_box_gap = dawati_debug_draw_box_gap;
+  klass->draw_shadow_gap = dawati_debug_draw_shadow_gap;
+  klass->draw_extension = dawati_debug_draw_extension;
+  klass->draw_hline = dawati_debug_draw_hline;
+  klass->draw_vline = dawati_debug_draw_vline;
+  klass->draw_focus = dawati_debug_draw_focus;
+  klass->draw_arrow = dawati_debug_draw_arrow;
+  klass->draw_handle = dawati_debug_draw_handle;
+  klass->draw_slider = dawati_debug_draw_slider;
+  klass->draw_resize_grip = dawati_debug_draw_resize_grip;
+  klass->draw_layout = dawati_debug_draw_layout;
+  klass->render_icon = dawati_debug_render_icon;
+  klass->draw_expander = dawati_debug_draw_expander;
+}
@@ -0,0 +1,61 @@
+/*
+ * dawati-gtk-engine - A GTK+ theme engine for Dawati
+ *
+ * Copyright (c) 2011, Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef _DAWATI_DEBUG_H
+#define _DAWATI_DEBUG_H
+
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+/* values of DAWATI_ENGINE_DEBUG */
+typedef enum
+{
+  DAWATI_DEBUG_NONE = 0,
+  DAWATI_DEBUG_CALLS = 1,        /* print every draw call */
+  DAWATI_DEBUG_WIDGET_PATHS = 2, /* print the path of every widget drawn */
+  DAWATI_DEBUG_STATS = 3         /* count and time the draw calls */
+} DawatiDebugMode;
+
+/* The statistics are written as JSON when the application exits, to
+ * DAWATI_ENGINE_STATS_FILE or stdout, and also every time the process gets
+ * the signal named by DAWATI_ENGINE_STATS_SIGNAL (e.g. "USR1"). */
+
+/* On X11 the statistics also count the X requests made by the draw calls,
+ * and the calls that had to wait for a reply from the server, which none
+ * should. */
+
+/* Whatever the mode, DAWATI_ENGINE_TRACE names a file that every draw call
+ * is written to as a Chrome trace event, to be loaded into chrome://tracing
+ * or a compatible viewer. */
+
+/* DAWATI_ENGINE_SLOW_US sets a time budget for a single draw call. Calls
+ * over it are reported on stderr with the widget's path, grouped by draw
+ * function, detail and widget class, at most once every five seconds. */
+
+/* Replaces the draw functions of the class with wrappers that measure each
+ * call, if the environment asks for it. Must be called at the end of
+ * class_init, once the real draw functions are set. */
+void dawati_debug_install (GtkStyleClass   *klass,
+                           DawatiDebugMode  mode);
+
+G_END_DECLS
+
+#endif /* _DAWATI_DEBUG_H */
@@ -0,0 +1,65 @@
+/*
+ * dawati-gtk-engine - A GTK+ theme engine for Dawati
+ *
+ * Copyright (c) 2011, Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "dawati-detail.h"
+
+static const gchar *detail_names[DAWATI_N_DETAILS] =
+{
+  NULL,
+#define DAWATI_DETAIL_NAME(id, name) name,
+  DAWATI_DETAILS (DAWATI_DETAIL_NAME)
+#undef DAWATI_DETAIL_NAME
+};
+
+static GHashTable *details = NULL;
+
+DawatiDetail
+dawati_detail_lookup (const gchar *detail)
+{
+  static gsize initialised = 0;
+
+  if (!detail)
+    return DAWATI_DETAIL_NONE;
+
+  /* details can be looked up from any thread that renders */
+  if (g_once_init_enter (&initialised))
+    {
+      gint i;
+
+      details = g_hash_table_new (g_str_hash, g_str_equal);
+
+      for (i = 1; i < DAWATI_N_DETAILS; i++)
+        g_hash_table_insert (details, (gpointer) detail_names[i],
+                             GINT_TO_POINTER (i));
+
+      g_once_init_leave (&initialised, 1);
+    }
+
+  /* unknown details map to DAWATI_DETAIL_NONE */
+  return GPOINTER_TO_INT (g_hash_table_lookup (details, detail));
+}
+
+const gchar *
+dawati_detail_name (DawatiDetail detail)
+{
+  g_return_val_if_fail (detail < DAWATI_N_DETAILS, NULL);
+
+  return detail_names[detail];
+}
@@ -0,0 +1,68 @@
+/*
+ * dawati-gtk-engine - A GTK+ theme engine for Dawati
+ *
+ * Copyright (c) 2011, Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef _DAWATI_DETAIL_H
+#define _DAWATI_DETAIL_H
+
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+/* Every detail string the engine looks at. Details are looked up once per
+ * call and the draw functions compare the resulting enum values instead of
+ * strings. */
+#define DAWATI_DETAILS(D) \
+  D (ACCELLABEL,             "accellabel") \
+  D (BUTTON,                 "button") \
+  D (BUTTONDEFAULT,          "buttondefault") \
+  D (ENTRY,                  "entry") \
+  D (HSCALE,                 "hscale") \
+  D (HSCROLLBAR,             "hscrollbar") \
+  D (LIGHT_SWITCH_HANDLE,    "light-switch-handle") \
+  D (LIGHT_SWITCH_TROUGH,    "light-switch-trough") \
+  D (PANED,                  "paned") \
+  D (SLIDER,                 "slider") \
+  D (SPINBUTTON,             "spinbutton") \
+  D (SPINBUTTON_DOWN,        "spinbutton_down") \
+  D (SPINBUTTON_UP,          "spinbutton_up") \
+  D (TROUGH,                 "trough") \
+  D (TROUGH_FILL_LEVEL,      "trough-fill-level") \
+  D (TROUGH_FILL_LEVEL_FULL, "trough-fill-level-full") \
+  D (VSCALE,                 "vscale") \
+  D (VSCROLLBAR,             "vscrollbar") \
+  D (VSEPARATOR,             "vseparator")
+
+typedef enum
+{
+  DAWATI_DETAIL_NONE, /* no detail, or one the engine does not know */
+
+#define DAWATI_DETAIL_ENUM(id, name) DAWATI_DETAIL_##id,
+  DAWATI_DETAILS (DAWATI_DETAIL_ENUM)
+#undef DAWATI_DETAIL_ENUM
+
+  DAWATI_N_DETAILS
+} DawatiDetail;
+
+DawatiDetail dawati_detail_lookup (const gchar  *detail);
+const gchar *dawati_detail_name   (DawatiDetail  detail);
+
+G_END_DECLS
+
+#endif /* _DAWATI_DETAIL_H */
@@ -0,0 +1,209 @@
+/*
+ * dawati-gtk-engine - A GTK+ theme engine for Dawati
+ *
+ * Copyright (c) 2011, Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "dawati-icon-cache.h"
+#include "dawati-cache.h"
+
+/* upper bound on the memory used by cached icons */
+#define ICON_CACHE_SIZE (1024 * 1024)
+
+typedef struct
+{
+  GdkPixbuf    *source; /* not a reference */
+  gint          width;
+  gint          height;
+  GtkStateType  state;
+} DawatiIconKey;
+
+static DawatiCache *icon_cache = NULL;
+
+/* the sources with a weak reference on them */
+static GHashTable *icon_sources = NULL;
+
+/* Icons dropped from the cache, released once the lock is let go, as one
+ * of them could be the source of other entries. */
+static GSList *icon_dropped = NULL;
+
+/* guards the cache and the sources */
+G_LOCK_DEFINE_STATIC (icon_cache);
+
+static guint
+dawati_icon_key_hash (gconstpointer key)
+{
+  const DawatiIconKey *k = key;
+
+  return GPOINTER_TO_UINT (k->source) ^ (k->width << 20) ^ (k->height << 8)
+    ^ k->state;
+}
+
+static gboolean
+dawati_icon_key_equal (gconstpointer a,
+                       gconstpointer b)
+{
+  const DawatiIconKey *ka = a;
+  const DawatiIconKey *kb = b;
+
+  return ka->source == kb->source
+    && ka->width == kb->width
+    && ka->height == kb->height
+    && ka->state == kb->state;
+}
+
+static void
+dawati_icon_key_free (gpointer key)
+{
+  g_slice_free (DawatiIconKey, key);
+}
+
+static gboolean
+dawati_icon_key_has_source (gpointer key,
+                            gpointer value,
+                            gpointer source)
+{
+  return ((DawatiIconKey *) key)->source == source;
+}
+
+static void
+dawati_icon_drop (gpointer pixbuf)
+{
+  icon_dropped = g_slist_prepend (icon_dropped, pixbuf);
+}
+
+/* called with the lock held, unlocks it */
+static void
+dawati_icon_cache_unlock (void)
+{
+  GSList *dropped = icon_dropped;
+
+  icon_dropped = NULL;
+
+  G_UNLOCK (icon_cache);
+
+  g_slist_foreach (dropped, (GFunc) g_object_unref, NULL);
+  g_slist_free (dropped);
+}
+
+static void
+dawati_icon_source_finalized (gpointer  data,
+                              GObject  *source)
+{
+  G_LOCK (icon_cache);
+
+  dawati_cache_remove_matching (icon_cache, dawati_icon_key_has_source,
+                                source);
+  g_hash_table_remove (icon_sources, source);
+
+  dawati_icon_cache_unlock ();
+}
+
+/* Returns a new reference to the icon made from source for width, height
+ * and state, or NULL. */
+GdkPixbuf *
+dawati_icon_cache_lookup (GdkPixbuf    *source,
+                          gint          width,
+                          gint          height,
+                          GtkStateType  state)
+{
+  DawatiIconKey key;
+  GdkPixbuf *pixbuf = NULL;
+
+  G_LOCK (icon_cache);
+
+  if (icon_cache)
+    {
+      key.source = source;
+      key.width = width;
+      key.height = height;
+      key.state = state;
+
+      pixbuf = dawati_cache_lookup (icon_cache, &key);
+      if (pixbuf)
+        g_object_ref (pixbuf);
+    }
+
+  G_UNLOCK (icon_cache);
+
+  return pixbuf;
+}
+
+void
+dawati_icon_cache_insert (GdkPixbuf    *source,
+                          gint          width,
+                          gint          height,
+                          GtkStateType  state,
+                          GdkPixbuf    *pixbuf)
+{
+  DawatiIconKey key;
+  gsize cost;
+
+  /* the entry would keep the source alive */
+  if (pixbuf == source)
+    return;
+
+  cost = (gsize) gdk_pixbuf_get_rowstride (pixbuf)
+    * gdk_pixbuf_get_height (pixbuf);
+  if (cost > ICON_CACHE_SIZE)
+    return;
+
+  G_LOCK (icon_cache);
+
+  if (!icon_cache)
+    {
+      icon_cache = dawati_cache_new (dawati_icon_key_hash,
+                                     dawati_icon_key_equal,
+                                     dawati_icon_key_free,
+                                     dawati_icon_drop,
+                                     ICON_CACHE_SIZE);
+      icon_sources = g_hash_table_new (NULL, NULL);
+    }
+
+  key.source = source;
+  key.width = width;
+  key.height = height;
+  key.state = state;
+
+  dawati_cache_insert (icon_cache, g_slice_dup (DawatiIconKey, &key),
+                       g_object_ref (pixbuf), cost);
+
+  if (!g_hash_table_lookup (icon_sources, source))
+    {
+      g_hash_table_insert (icon_sources, source, source);
+      g_object_weak_ref (G_OBJECT (source), dawati_icon_source_finalized,
+                         NULL);
+    }
+
+  dawati_icon_cache_unlock ();
+}
+
+void
+dawati_icon_cache_print_stats (void)
+{
+  DawatiCacheStats stats;
+
+  if (!icon_cache)
+    return;
+
+  dawati_cache_get_stats (icon_cache, &stats);
+
+  g_printerr ("icon cache: hits = %u; misses = %u; evictions = %u; "
+              "entries = %u; bytes = %lu/%lu;\n",
+              stats.hits, stats.misses, stats.evictions, stats.n_entries,
+              (gulong) stats.cost, (gulong) stats.max_cost);
+}
@@ -0,0 +1,49 @@
+/*
+ * dawati-gtk-engine - A GTK+ theme engine for Dawati
+ *
+ * Copyright (c) 2011, Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef _DAWATI_ICON_CACHE_H
+#define _DAWATI_ICON_CACHE_H
+
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+/* The icons made by render_icon, by source pixbuf, size and state, so that
+ * icons which go insensitive and back are not scaled and faded every time.
+ * The entries of a source go when the source is finalized. */
+
+/* the state of the halved copies of a source, see dawati_pixbuf_halve() */
+#define DAWATI_ICON_CACHE_MIP ((GtkStateType) -1)
+
+GdkPixbuf *dawati_icon_cache_lookup      (GdkPixbuf    *source,
+                                          gint          width,
+                                          gint          height,
+                                          GtkStateType  state);
+void       dawati_icon_cache_insert      (GdkPixbuf    *source,
+                                          gint          width,
+                                          gint          height,
+                                          GtkStateType  state,
+                                          GdkPixbuf    *pixbuf);
+
+void       dawati_icon_cache_print_stats (void);
+
+G_END_DECLS
+
+#endif /* _DAWATI_ICON_CACHE_H */
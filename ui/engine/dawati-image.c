@@ -0,0 +1,451 @@
+/*
+ * dawati-gtk-engine - A GTK+ theme engine for Dawati
+ *
+ * Copyright (c) 2011, Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "dawati-image.h"
+#include "dawati-assets.h"
+#include "dawati-cache.h"
+
+#include <string.h>
+
+/* upper bound on the memory used by stretched images */
+#define IMAGE_CACHE_SIZE (4 * 1024 * 1024)
+
+/* a stretched image, by the asset it comes from rather than the image
+ * block, so that styles with the same file and borders share it */
+typedef struct
+{
+  cairo_surface_t *source;  /* not a reference, assets are never freed */
+  gint             border[4];
+  gboolean         draw_center;
+  gint             width;
+  gint             height;
+} DawatiImageKey;
+
+static DawatiCache *image_cache = NULL;
+
+G_LOCK_DEFINE_STATIC (image_cache);
+
+DawatiImage *
+dawati_image_new (void)
+{
+  DawatiImage *image;
+
+  image = g_slice_new0 (DawatiImage);
+  image->ref_count = 1;
+
+  return image;
+}
+
+DawatiImage *
+dawati_image_ref (DawatiImage *image)
+{
+  g_atomic_int_inc (&image->ref_count);
+
+  return image;
+}
+
+static void
+dawati_image_part_free (DawatiImagePart *part)
+{
+  if (!part)
+    return;
+
+  g_free (part->filename);
+  g_slice_free (DawatiImagePart, part);
+}
+
+void
+dawati_image_unref (DawatiImage *image)
+{
+  if (!g_atomic_int_dec_and_test (&image->ref_count))
+    return;
+
+  g_free (image->detail);
+  dawati_image_part_free (image->background);
+  dawati_image_part_free (image->overlay);
+  g_slice_free (DawatiImage, image);
+}
+
+DawatiImagePart *
+dawati_image_part_new (void)
+{
+  DawatiImagePart *part;
+
+  part = g_slice_new0 (DawatiImagePart);
+  part->stretch = TRUE;
+
+  return part;
+}
+
+GSList *
+dawati_image_list_copy (GSList *images)
+{
+  GSList *copy;
+
+  copy = g_slist_copy (images);
+  g_slist_foreach (copy, (GFunc) dawati_image_ref, NULL);
+
+  return copy;
+}
+
+void
+dawati_image_list_free (GSList *images)
+{
+  g_slist_foreach (images, (GFunc) dawati_image_unref, NULL);
+  g_slist_free (images);
+}
+
+/* Returns the first image of images that match asks for, or NULL. */
+DawatiImage *
+dawati_image_find (GSList                 *images,
+                   const DawatiImageMatch *match)
+{
+  GSList *l;
+
+  for (l = images; l; l = l->next)
+    {
+      const DawatiImage *image = l->data;
+      const DawatiImageMatch *m = &image->match;
+
+      if (m->function != match->function)
+        continue;
+
+      /* the image needs something the draw call doesn't have */
+      if ((m->flags & match->flags) != m->flags)
+        continue;
+
+      if ((m->flags & DAWATI_IMAGE_MATCH_STATE)
+          && m->state != match->state)
+        continue;
+      if ((m->flags & DAWATI_IMAGE_MATCH_SHADOW)
+          && m->shadow != match->shadow)
+        continue;
+      if ((m->flags & DAWATI_IMAGE_MATCH_ORIENTATION)
+          && m->orientation != match->orientation)
+        continue;
+      if ((m->flags & DAWATI_IMAGE_MATCH_ARROW_DIRECTION)
+          && m->arrow_direction != match->arrow_direction)
+        continue;
+      if ((m->flags & DAWATI_IMAGE_MATCH_EXPANDER_STYLE)
+          && m->expander_style != match->expander_style)
+        continue;
+
+      if (m->detail
+          && (!match->detail || strcmp (m->detail, match->detail) != 0))
+        continue;
+
+      return l->data;
+    }
+
+  return NULL;
+}
+
+gboolean
+dawati_image_list_has (GSList              *images,
+                       DawatiImageFunction  function)
+{
+  GSList *l;
+
+  for (l = images; l; l = l->next)
+    if (((DawatiImage *) l->data)->match.function == function)
+      return TRUE;
+
+  return FALSE;
+}
+
+static guint
+dawati_image_key_hash (gconstpointer key)
+{
+  const DawatiImageKey *k = key;
+
+  return GPOINTER_TO_UINT (k->source) ^ (k->width << 20) ^ (k->height << 8)
+    ^ (k->border[0] << 24) ^ (k->border[2] << 16) ^ k->draw_center;
+}
+
+static gboolean
+dawati_image_key_equal (gconstpointer a,
+                        gconstpointer b)
+{
+  const DawatiImageKey *ka = a;
+  const DawatiImageKey *kb = b;
+
+  return ka->source == kb->source
+    && ka->width == kb->width
+    && ka->height == kb->height
+    && ka->draw_center == kb->draw_center
+    && memcmp (ka->border, kb->border, sizeof (ka->border)) == 0;
+}
+
+static void
+dawati_image_key_free (gpointer key)
+{
+  g_slice_free (DawatiImageKey, key);
+}
+
+/* Split size between the borders at either end and the stretched middle,
+ * into the four edges of the three parts. Borders that don't fit are
+ * shrunk in proportion. */
+static void
+dawati_image_divide (gint  size,
+                     gint  start,
+                     gint  end,
+                     gint  edges[4])
+{
+  edges[0] = 0;
+  edges[3] = size;
+
+  if (start + end <= size)
+    {
+      edges[1] = start;
+      edges[2] = size - end;
+    }
+  else
+    {
+      edges[1] = edges[2] = size * start / (start + end);
+    }
+}
+
+/* Draw source into width by height at (0, 0) with its borders kept at
+ * their size and the rest scaled, the way the pixmap engine does. */
+static void
+dawati_image_stretch (cairo_t         *cr,
+                      cairo_surface_t *source,
+                      const gint       border[4],
+                      gboolean         draw_center,
+                      gint             width,
+                      gint             height)
+{
+  gint sw = cairo_image_surface_get_width (source);
+  gint sh = cairo_image_surface_get_height (source);
+  gint src_x[4], src_y[4], dst_x[4], dst_y[4];
+  gint i, j;
+
+  dawati_image_divide (sw, border[0], border[1], src_x);
+  dawati_image_divide (sh, border[2], border[3], src_y);
+  dawati_image_divide (width, border[0], border[1], dst_x);
+  dawati_image_divide (height, border[2], border[3], dst_y);
+
+  for (j = 0; j < 3; j++)
+    for (i = 0; i < 3; i++)
+      {
+        gint src_width = src_x[i + 1] - src_x[i];
+        gint src_height = src_y[j + 1] - src_y[j];
+        gint dst_width = dst_x[i + 1] - dst_x[i];
+        gint dst_height = dst_y[j + 1] - dst_y[j];
+        cairo_surface_t *slice;
+        cairo_pattern_t *pattern;
+        cairo_matrix_t matrix;
+        cairo_t *slice_cr;
+
+        if (i == 1 && j == 1 && !draw_center)
+          continue;
+
+        if (src_width <= 0 || src_height <= 0
+            || dst_width <= 0 || dst_height <= 0)
+          continue;
+
+        /* a copy of the part on its own, so that scaling it doesn't pull
+         * in the pixels next to it */
+        slice = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
+                                            src_width, src_height);
+        slice_cr = cairo_create (slice);
+        cairo_set_operator (slice_cr, CAIRO_OPERATOR_SOURCE);
+        cairo_set_source_surface (slice_cr, source, -src_x[i], -src_y[j]);
+        cairo_paint (slice_cr);
+        cairo_destroy (slice_cr);
+
+        pattern = cairo_pattern_create_for_surface (slice);
+        cairo_pattern_set_extend (pattern, CAIRO_EXTEND_PAD);
+        cairo_pattern_set_filter (pattern, CAIRO_FILTER_BILINEAR);
+        cairo_matrix_init_scale (&matrix,
+                                 (gdouble) src_width / dst_width,
+                                 (gdouble) src_height / dst_height);
+        cairo_matrix_translate (&matrix, -dst_x[i], -dst_y[j]);
+        cairo_pattern_set_matrix (pattern, &matrix);
+
+        cairo_set_source (cr, pattern);
+        cairo_rectangle (cr, dst_x[i], dst_y[j], dst_width, dst_height);
+        cairo_fill (cr);
+
+        cairo_pattern_destroy (pattern);
+        cairo_surface_destroy (slice);
+      }
+}
+
+/* Returns a reference to source stretched to width by height, from the
+ * cache if it was made before. NULL if it is too big to be kept. */
+static cairo_surface_t *
+dawati_image_get_stretched (cairo_surface_t *source,
+                            const gint       border[4],
+                            gboolean         draw_center,
+                            gint             width,
+                            gint             height)
+{
+  DawatiImageKey key;
+  cairo_surface_t *surface;
+  cairo_t *cr;
+  gsize cost;
+
+  cost = (gsize) width * height * 4;
+  if (cost > IMAGE_CACHE_SIZE / 8)
+    return NULL;
+
+  key.source = source;
+  memcpy (key.border, border, sizeof (key.border));
+  key.draw_center = draw_center;
+  key.width = width;
+  key.height = height;
+
+  G_LOCK (image_cache);
+
+  if (!image_cache)
+    image_cache = dawati_cache_new (dawati_image_key_hash,
+                                    dawati_image_key_equal,
+                                    dawati_image_key_free,
+                                    (GDestroyNotify) cairo_surface_destroy,
+                                    IMAGE_CACHE_SIZE);
+
+  surface = dawati_cache_lookup (image_cache, &key);
+  if (surface)
+    cairo_surface_reference (surface);
+
+  G_UNLOCK (image_cache);
+
+  if (surface)
+    return surface;
+
+  surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, width, height);
+  cr = cairo_create (surface);
+  dawati_image_stretch (cr, source, border, draw_center, width, height);
+  cairo_destroy (cr);
+
+  G_LOCK (image_cache);
+  dawati_cache_insert (image_cache, g_slice_dup (DawatiImageKey, &key),
+                       cairo_surface_reference (surface), cost);
+  G_UNLOCK (image_cache);
+
+  return surface;
+}
+
+static void
+dawati_image_part_render (cairo_t               *cr,
+                          const DawatiImagePart *part,
+                          gboolean               draw_center,
+                          gboolean               centred,
+                          gint                   x,
+                          gint                   y,
+                          gint                   width,
+                          gint                   height)
+{
+  cairo_surface_t *source;
+  cairo_surface_t *stretched;
+  gint sw, sh;
+
+  /* no file, or it wasn't found when the image was parsed */
+  if (!part->filename)
+    return;
+
+  source = dawati_assets_get (part->filename);
+  if (!source)
+    return;
+
+  sw = cairo_image_surface_get_width (source);
+  sh = cairo_image_surface_get_height (source);
+
+  if (!part->stretch && centred)
+    {
+      cairo_set_source_surface (cr, source,
+                                x + (width - sw) / 2, y + (height - sh) / 2);
+      cairo_paint (cr);
+    }
+  else if (!part->stretch)
+    {
+      /* tiled from the corner */
+      cairo_set_source_surface (cr, source, x, y);
+      cairo_pattern_set_extend (cairo_get_source (cr), CAIRO_EXTEND_REPEAT);
+      cairo_rectangle (cr, x, y, width, height);
+      cairo_fill (cr);
+    }
+  else if (sw == width && sh == height && draw_center)
+    {
+      cairo_set_source_surface (cr, source, x, y);
+      cairo_paint (cr);
+    }
+  else
+    {
+      stretched = dawati_image_get_stretched (source, part->border,
+                                              draw_center, width, height);
+      if (stretched)
+        {
+          cairo_set_source_surface (cr, stretched, x, y);
+          cairo_paint (cr);
+          cairo_surface_destroy (stretched);
+        }
+      else
+        {
+          cairo_save (cr);
+          cairo_translate (cr, x, y);
+          dawati_image_stretch (cr, source, part->border, draw_center,
+                                width, height);
+          cairo_restore (cr);
+        }
+    }
+}
+
+/* Draw the background of image, without its centre unless draw_center is
+ * set, and then its overlay. */
+void
+dawati_image_render (cairo_t           *cr,
+                     const DawatiImage *image,
+                     gboolean           draw_center,
+                     gint               x,
+                     gint               y,
+                     gint               width,
+                     gint               height)
+{
+  if (width <= 0 || height <= 0)
+    return;
+
+  if (image->background)
+    dawati_image_part_render (cr, image->background, draw_center, FALSE,
+                              x, y, width, height);
+
+  if (image->overlay)
+    dawati_image_part_render (cr, image->overlay, TRUE, TRUE,
+                              x, y, width, height);
+}
+
+void
+dawati_image_print_stats (void)
+{
+  DawatiCacheStats stats;
+
+  dawati_assets_print_stats ();
+
+  if (!image_cache)
+    return;
+
+  dawati_cache_get_stats (image_cache, &stats);
+
+  g_printerr ("image cache: hits = %u; misses = %u; evictions = %u; "
+              "entries = %u; bytes = %lu/%lu;\n",
+              stats.hits, stats.misses, stats.evictions, stats.n_entries,
+              (gulong) stats.cost, (gulong) stats.max_cost);
+}
@@ -0,0 +1,115 @@
+/*
+ * dawati-gtk-engine - A GTK+ theme engine for Dawati
+ *
+ * Copyright (c) 2011, Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef _DAWATI_IMAGE_H
+#define _DAWATI_IMAGE_H
+
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+/* The image blocks of an engine "dawati" section, in the syntax of the
+ * pixmap engine. An image is drawn for the first one of a style that
+ * matches the draw call. In a style with images, anything else is drawn
+ * by GtkStyle as with the pixmap engine, and the render core only draws
+ * styles without any. */
+
+typedef enum
+{
+  DAWATI_IMAGE_BOX,
+  DAWATI_IMAGE_FLAT_BOX,
+  DAWATI_IMAGE_SHADOW,
+  DAWATI_IMAGE_CHECK,
+  DAWATI_IMAGE_OPTION,
+  DAWATI_IMAGE_SLIDER,
+  DAWATI_IMAGE_STEPPER,   /* a scrollbar button, box and arrow together */
+  DAWATI_IMAGE_EXPANDER,
+  DAWATI_IMAGE_ARROW
+} DawatiImageFunction;
+
+/* which of the fields of a DawatiImageMatch are to be compared */
+typedef enum
+{
+  DAWATI_IMAGE_MATCH_STATE = 1 << 0,
+  DAWATI_IMAGE_MATCH_SHADOW = 1 << 1,
+  DAWATI_IMAGE_MATCH_ORIENTATION = 1 << 2,
+  DAWATI_IMAGE_MATCH_ARROW_DIRECTION = 1 << 3,
+  DAWATI_IMAGE_MATCH_EXPANDER_STYLE = 1 << 4
+} DawatiImageMatchFlags;
+
+typedef struct
+{
+  DawatiImageFunction  function;
+  guint                flags;
+  const gchar         *detail;
+  GtkStateType         state;
+  GtkShadowType        shadow;
+  GtkOrientation       orientation;
+  GtkArrowType         arrow_direction;
+  GtkExpanderStyle     expander_style;
+} DawatiImageMatch;
+
+/* one file of an image, the borders are left, right, top and bottom */
+typedef struct
+{
+  gchar    *filename;
+  gint      border[4];
+  gboolean  stretch;
+} DawatiImagePart;
+
+typedef struct
+{
+  gint              ref_count;
+
+  /* an image only requires the fields that are set in match.flags, and
+   * the detail if it has one */
+  DawatiImageMatch  match;
+  gchar            *detail;
+
+  DawatiImagePart  *background;
+  DawatiImagePart  *overlay;   /* drawn centred if it isn't stretched */
+} DawatiImage;
+
+DawatiImage     *dawati_image_new          (void);
+DawatiImage     *dawati_image_ref          (DawatiImage            *image);
+void             dawati_image_unref        (DawatiImage            *image);
+DawatiImagePart *dawati_image_part_new     (void);
+
+GSList          *dawati_image_list_copy    (GSList                 *images);
+void             dawati_image_list_free    (GSList                 *images);
+
+DawatiImage     *dawati_image_find         (GSList                 *images,
+                                            const DawatiImageMatch *match);
+gboolean         dawati_image_list_has     (GSList                 *images,
+                                            DawatiImageFunction     function);
+
+void             dawati_image_render       (cairo_t                *cr,
+                                            const DawatiImage      *image,
+                                            gboolean                draw_center,
+                                            gint                    x,
+                                            gint                    y,
+                                            gint                    width,
+                                            gint                    height);
+
+void             dawati_image_print_stats  (void);
+
+G_END_DECLS
+
+#endif /* _DAWATI_IMAGE_H */
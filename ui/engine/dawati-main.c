@@ -27,6 +27,16 @@
 
 
 
+G_MODULE_EXPORT const gchar *
+g_module_check_init (GModule *module)
+{
+  /* never unload the engine, the debug output is written from an atexit()
+   * handler */
+  g_module_make_resident (module);
+
+  return NULL;
+}
+
 G_MODULE_EXPORT void
 theme_init (GTypeModule *module)
 {
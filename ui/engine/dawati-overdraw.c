@@ -0,0 +1,373 @@
+/*
+ * dawati-gtk-engine - A GTK+ theme engine for Dawati
+ *
+ * Copyright (c) 2011, Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "dawati-overdraw.h"
+#include "dawati-render.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+typedef struct
+{
+  GdkWindow       *toplevel;
+  gchar           *type_name;
+  cairo_surface_t *counts;  /* passes in the current frame */
+  cairo_surface_t *peak;    /* most passes in any one frame */
+  gboolean         painted; /* in the current frame */
+} DawatiOverdrawWindow;
+
+static gchar *overdraw_dir = NULL;
+
+/* toplevel GdkWindow to DawatiOverdrawWindow */
+static GHashTable *overdraw_windows = NULL;
+static guint overdraw_n_written = 0;
+
+/* the idle that ends the current frame, if anything was painted in it */
+static guint overdraw_frame_idle = 0;
+
+/* the colours for one, two, three, four and five or more passes */
+static const guint32 overdraw_colors[] =
+{
+  0xff0000ff, 0xff00c000, 0xffe0e000, 0xffff8000, 0xffff0000
+};
+
+/* Returns a copy of counts at least width x height large. */
+static cairo_surface_t *
+dawati_overdraw_grow (cairo_surface_t *counts,
+                      gint             width,
+                      gint             height)
+{
+  cairo_surface_t *grown;
+  cairo_t *cr;
+
+  grown = cairo_image_surface_create
+    (CAIRO_FORMAT_A8,
+     MAX (width, cairo_image_surface_get_width (counts)),
+     MAX (height, cairo_image_surface_get_height (counts)));
+
+  cr = cairo_create (grown);
+  cairo_set_source_surface (cr, counts, 0, 0);
+  cairo_paint (cr);
+  cairo_destroy (cr);
+
+  return grown;
+}
+
+/* Keeps the most passes of each pixel of the frame in the peak, and clears
+ * the counts for the next frame. */
+static void
+dawati_overdraw_end_frame (DawatiOverdrawWindow *ow)
+{
+  guchar *counts, *peak;
+  gint width, height, stride, x, y;
+
+  if (!ow->painted)
+    return;
+
+  cairo_surface_flush (ow->counts);
+  cairo_surface_flush (ow->peak);
+  counts = cairo_image_surface_get_data (ow->counts);
+  peak = cairo_image_surface_get_data (ow->peak);
+
+  /* both have the same size */
+  stride = cairo_image_surface_get_stride (ow->counts);
+  width = cairo_image_surface_get_width (ow->counts);
+  height = cairo_image_surface_get_height (ow->counts);
+
+  for (y = 0; y < height; y++)
+    for (x = 0; x < width; x++)
+      peak[y * stride + x] = MAX (peak[y * stride + x],
+                                  counts[y * stride + x]);
+
+  memset (counts, 0, stride * height);
+
+  cairo_surface_mark_dirty (ow->counts);
+  cairo_surface_mark_dirty (ow->peak);
+
+  ow->painted = FALSE;
+}
+
+/* A frame is everything painted until the main loop goes idle, which is
+ * after the pending events, resizes and redraws have all been handled. */
+static gboolean
+dawati_overdraw_frame_done (gpointer data)
+{
+  GHashTableIter iter;
+  DawatiOverdrawWindow *ow;
+
+  overdraw_frame_idle = 0;
+
+  if (!overdraw_windows)
+    return FALSE;
+
+  g_hash_table_iter_init (&iter, overdraw_windows);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &ow))
+    dawati_overdraw_end_frame (ow);
+
+  return FALSE;
+}
+
+static void
+dawati_overdraw_write (DawatiOverdrawWindow *ow)
+{
+  cairo_surface_t *image;
+  cairo_status_t status;
+  const guchar *counts;
+  guint32 *pixels;
+  guint64 n_painted = 0, n_passes = 0, n_over = 0;
+  gint width, height, stride, image_stride;
+  gchar *filename;
+  gint x, y;
+
+  dawati_overdraw_end_frame (ow);
+
+  counts = cairo_image_surface_get_data (ow->peak);
+  stride = cairo_image_surface_get_stride (ow->peak);
+  width = cairo_image_surface_get_width (ow->peak);
+  height = cairo_image_surface_get_height (ow->peak);
+
+  image = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, width, height);
+  pixels = (guint32 *) cairo_image_surface_get_data (image);
+  image_stride = cairo_image_surface_get_stride (image) / 4;
+
+  for (y = 0; y < height; y++)
+    for (x = 0; x < width; x++)
+      {
+        guint n = counts[y * stride + x];
+
+        if (n == 0)
+          {
+            pixels[y * image_stride + x] = 0;
+            continue;
+          }
+
+        pixels[y * image_stride + x] =
+          overdraw_colors[MIN (n, G_N_ELEMENTS (overdraw_colors)) - 1];
+
+        n_painted++;
+        n_passes += n;
+        if (n > 1)
+          n_over++;
+      }
+
+  cairo_surface_mark_dirty (image);
+
+  filename = g_strdup_printf ("%s/overdraw-%d-%u-%s.png", overdraw_dir,
+                              (gint) getpid (), overdraw_n_written++,
+                              ow->type_name);
+
+  status = cairo_surface_write_to_png (image, filename);
+  if (status != CAIRO_STATUS_SUCCESS)
+    g_warning ("Could not write the overdraw map %s: %s",
+               filename, cairo_status_to_string (status));
+  else if (n_painted > 0)
+    g_printerr ("dawati: %s: %dx%d, %" G_GUINT64_FORMAT " pixels painted "
+                "at most %.2f times a frame on average, %.1f%% more than "
+                "once in a frame\n",
+                filename, width, height, n_painted,
+                (gdouble) n_passes / n_painted, 100.0 * n_over / n_painted);
+
+  g_free (filename);
+  cairo_surface_destroy (image);
+}
+
+static void
+dawati_overdraw_window_free (gpointer data)
+{
+  DawatiOverdrawWindow *ow = data;
+
+  dawati_overdraw_write (ow);
+
+  cairo_surface_destroy (ow->counts);
+  cairo_surface_destroy (ow->peak);
+  g_free (ow->type_name);
+  g_slice_free (DawatiOverdrawWindow, ow);
+}
+
+static void
+dawati_overdraw_toplevel_gone (gpointer  data,
+                               GObject  *toplevel)
+{
+  g_hash_table_remove (overdraw_windows, toplevel);
+}
+
+static void
+dawati_overdraw_close (void)
+{
+  GHashTableIter iter;
+  gpointer toplevel;
+
+  g_hash_table_iter_init (&iter, overdraw_windows);
+  while (g_hash_table_iter_next (&iter, &toplevel, NULL))
+    g_object_weak_unref (toplevel, dawati_overdraw_toplevel_gone, NULL);
+
+  g_hash_table_destroy (overdraw_windows);
+  overdraw_windows = NULL;
+}
+
+/* Returns the counts of the current frame for the toplevel of window, large
+ * enough to hold it, and the position of window there. The sizes and
+ * positions are the ones GDK keeps, so that this costs no round trip to the
+ * X server. */
+static cairo_surface_t *
+dawati_overdraw_lookup (GdkWindow *window,
+                        gint      *dx,
+                        gint      *dy)
+{
+  DawatiOverdrawWindow *ow;
+  GdkWindow *toplevel, *w;
+  GtkWidget *widget = NULL;
+  gint width, height, x, y;
+
+  if (!overdraw_windows || !GDK_IS_WINDOW (window))
+    return NULL;
+
+  toplevel = gdk_window_get_toplevel (window);
+
+  *dx = *dy = 0;
+  for (w = window; w && w != toplevel; w = gdk_window_get_parent (w))
+    {
+      gdk_window_get_position (w, &x, &y);
+      *dx += x;
+      *dy += y;
+    }
+
+  gdk_window_get_user_data (toplevel, (gpointer *) &widget);
+  if (GTK_IS_WIDGET (widget))
+    {
+      width = widget->allocation.width;
+      height = widget->allocation.height;
+    }
+  else
+    {
+      gdk_drawable_get_size (toplevel, &width, &height);
+    }
+
+  ow = g_hash_table_lookup (overdraw_windows, toplevel);
+  if (!ow)
+    {
+      ow = g_slice_new0 (DawatiOverdrawWindow);
+      ow->toplevel = toplevel;
+      ow->type_name = g_strdup (widget ? G_OBJECT_TYPE_NAME (widget)
+                                       : "GdkWindow");
+      ow->counts = cairo_image_surface_create (CAIRO_FORMAT_A8,
+                                               MAX (width, 1),
+                                               MAX (height, 1));
+      ow->peak = cairo_image_surface_create (CAIRO_FORMAT_A8,
+                                             MAX (width, 1),
+                                             MAX (height, 1));
+
+      g_hash_table_insert (overdraw_windows, toplevel, ow);
+      g_object_weak_ref (G_OBJECT (toplevel), dawati_overdraw_toplevel_gone,
+                         NULL);
+    }
+  else if (width > cairo_image_surface_get_width (ow->counts)
+           || height > cairo_image_surface_get_height (ow->counts))
+    {
+      cairo_surface_t *grown;
+
+      /* the window grew, keep what was counted so far */
+      grown = dawati_overdraw_grow (ow->counts, width, height);
+      cairo_surface_destroy (ow->counts);
+      ow->counts = grown;
+
+      grown = dawati_overdraw_grow (ow->peak, width, height);
+      cairo_surface_destroy (ow->peak);
+      ow->peak = grown;
+    }
+
+  ow->painted = TRUE;
+  if (!overdraw_frame_idle)
+    overdraw_frame_idle = g_idle_add (dawati_overdraw_frame_done, NULL);
+
+  return ow->counts;
+}
+
+void
+dawati_overdraw_open (const gchar *directory)
+{
+  if (g_mkdir_with_parents (directory, 0755) != 0)
+    {
+      g_warning ("Could not create the overdraw directory %s: %s",
+                 directory, g_strerror (errno));
+      return;
+    }
+
+  overdraw_dir = g_strdup (directory);
+  overdraw_windows = g_hash_table_new_full (NULL, NULL, NULL,
+                                            dawati_overdraw_window_free);
+
+  atexit (dawati_overdraw_close);
+}
+
+void
+dawati_overdraw_begin (GdkWindow *window,
+                       cairo_t   *cr)
+{
+  cairo_surface_t *counts;
+  gint dx, dy;
+
+  counts = dawati_overdraw_lookup (window, &dx, &dy);
+  if (counts)
+    dawati_render_set_overdraw (cairo_get_target (cr), counts, dx, dy);
+}
+
+void
+dawati_overdraw_end (void)
+{
+  if (overdraw_windows)
+    dawati_render_set_overdraw (NULL, NULL, 0, 0);
+}
+
+/* for what the engine paints without the render core */
+void
+dawati_overdraw_add_rectangle (GdkWindow    *window,
+                               GdkRectangle *area,
+                               gint          x,
+                               gint          y,
+                               gint          width,
+                               gint          height)
+{
+  cairo_surface_t *counts;
+  cairo_t *cr;
+  gint dx, dy;
+
+  counts = dawati_overdraw_lookup (window, &dx, &dy);
+  if (!counts)
+    return;
+
+  cr = cairo_create (counts);
+  cairo_translate (cr, dx, dy);
+
+  if (area)
+    {
+      cairo_rectangle (cr, area->x, area->y, area->width, area->height);
+      cairo_clip (cr);
+    }
+
+  cairo_rectangle (cr, x, y, width, height);
+  cairo_set_operator (cr, CAIRO_OPERATOR_ADD);
+  cairo_set_source_rgba (cr, 0, 0, 0, 1.0 / 255.0);
+  cairo_fill (cr);
+
+  cairo_destroy (cr);
+}
@@ -0,0 +1,51 @@
+/*
+ * dawati-gtk-engine - A GTK+ theme engine for Dawati
+ *
+ * Copyright (c) 2011, Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef _DAWATI_OVERDRAW_H
+#define _DAWATI_OVERDRAW_H
+
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+/* With DAWATI_ENGINE_OVERDRAW set to a directory, every pass the engine
+ * makes over a pixel is counted, per toplevel window and per frame, and
+ * each toplevel is written there as a false colour PNG of the most passes
+ * in any one frame when it goes away or at exit. Pixels painted once a
+ * frame are blue, then green, yellow and orange, and five or more passes
+ * are red. A frame ends when the main loop goes idle, so repainting the
+ * same pixels later, on hover for example, is not overdraw. */
+
+void dawati_overdraw_open          (const gchar  *directory);
+
+void dawati_overdraw_begin         (GdkWindow    *window,
+                                    cairo_t      *cr);
+void dawati_overdraw_end           (void);
+
+void dawati_overdraw_add_rectangle (GdkWindow    *window,
+                                    GdkRectangle *area,
+                                    gint          x,
+                                    gint          y,
+                                    gint          width,
+                                    gint          height);
+
+G_END_DECLS
+
+#endif /* _DAWATI_OVERDRAW_H */
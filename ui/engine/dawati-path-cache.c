@@ -0,0 +1,164 @@
+/*
+ * dawati-gtk-engine - A GTK+ theme engine for Dawati
+ *
+ * Copyright (c) 2011, Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "dawati-path-cache.h"
+#include "dawati-cache.h"
+
+#include <string.h>
+
+/* upper bound on the memory used by cached paths */
+#define PATH_CACHE_SIZE (256 * 1024)
+
+typedef struct
+{
+  DawatiPathKind kind;
+  gdouble        params[DAWATI_PATH_N_PARAMS];
+} DawatiPathKey;
+
+static DawatiCache *path_cache = NULL;
+static cairo_t *scratch_cr = NULL;
+
+/* guards the cache and the scratch context */
+G_LOCK_DEFINE_STATIC (path_cache);
+
+static guint
+dawati_path_key_hash (gconstpointer key)
+{
+  const DawatiPathKey *k = key;
+  guint hash = k->kind;
+  gint i;
+
+  /* the bits of the params, which is what equal compares; converting a
+   * negative double to an unsigned type is undefined */
+  for (i = 0; i < DAWATI_PATH_N_PARAMS; i++)
+    {
+      guint64 bits;
+
+      memcpy (&bits, &k->params[i], sizeof (bits));
+      hash = hash * 31 + (guint) (bits ^ (bits >> 32));
+    }
+
+  return hash;
+}
+
+static gboolean
+dawati_path_key_equal (gconstpointer a,
+                       gconstpointer b)
+{
+  const DawatiPathKey *ka = a;
+  const DawatiPathKey *kb = b;
+
+  return ka->kind == kb->kind
+    && memcmp (ka->params, kb->params, sizeof (ka->params)) == 0;
+}
+
+static void
+dawati_path_key_free (gpointer key)
+{
+  g_slice_free (DawatiPathKey, key);
+}
+
+static cairo_path_t *
+dawati_path_build (DawatiPathBuildFunc  build,
+                   const gdouble       *params)
+{
+  if (!scratch_cr)
+    {
+      cairo_surface_t *surface;
+
+      surface = cairo_image_surface_create (CAIRO_FORMAT_A8, 1, 1);
+      scratch_cr = cairo_create (surface);
+      cairo_surface_destroy (surface);
+    }
+
+  cairo_new_path (scratch_cr);
+  build (scratch_cr, params);
+
+  return cairo_copy_path (scratch_cr);
+}
+
+void
+dawati_path_cache_append (cairo_t             *cr,
+                          gdouble              x,
+                          gdouble              y,
+                          DawatiPathKind       kind,
+                          const gdouble       *params,
+                          DawatiPathBuildFunc  build)
+{
+  DawatiPathKey key;
+  cairo_path_t *path;
+
+  G_LOCK (path_cache);
+
+  if (!path_cache)
+    path_cache = dawati_cache_new (dawati_path_key_hash,
+                                   dawati_path_key_equal,
+                                   dawati_path_key_free,
+                                   (GDestroyNotify) cairo_path_destroy,
+                                   PATH_CACHE_SIZE);
+
+  key.kind = kind;
+  memcpy (key.params, params, sizeof (key.params));
+
+  cairo_translate (cr, x, y);
+
+  path = dawati_cache_lookup (path_cache, &key);
+  if (path)
+    {
+      cairo_append_path (cr, path);
+    }
+  else
+    {
+      gsize cost;
+
+      path = dawati_path_build (build, params);
+      cost = sizeof (cairo_path_t)
+        + path->num_data * sizeof (cairo_path_data_t);
+
+      if (path->status == CAIRO_STATUS_SUCCESS)
+        cairo_append_path (cr, path);
+
+      if (path->status == CAIRO_STATUS_SUCCESS && cost <= PATH_CACHE_SIZE)
+        dawati_cache_insert (path_cache, g_slice_dup (DawatiPathKey, &key),
+                             path, cost);
+      else
+        cairo_path_destroy (path);
+    }
+
+  cairo_translate (cr, -x, -y);
+
+  G_UNLOCK (path_cache);
+}
+
+void
+dawati_path_cache_print_stats (void)
+{
+  DawatiCacheStats stats;
+
+  if (!path_cache)
+    return;
+
+  dawati_cache_get_stats (path_cache, &stats);
+
+  g_printerr ("path cache: hits = %u; misses = %u; evictions = %u; "
+              "entries = %u; bytes = %lu/%lu;\n",
+              stats.hits, stats.misses, stats.evictions, stats.n_entries,
+              (gulong) stats.cost, (gulong) stats.max_cost);
+}
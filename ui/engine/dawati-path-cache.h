@@ -0,0 +1,55 @@
+/*
+ * dawati-gtk-engine - A GTK+ theme engine for Dawati
+ *
+ * Copyright (c) 2011, Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef _DAWATI_PATH_CACHE_H
+#define _DAWATI_PATH_CACHE_H
+
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+/* Paths are built once with their origin at (0, 0) and replayed at any
+ * position, so the arc to bezier conversion is only done once per shape. */
+
+#define DAWATI_PATH_N_PARAMS 5
+
+typedef enum
+{
+  DAWATI_PATH_ROUNDED_RECTANGLE,
+  DAWATI_PATH_TAB,
+  DAWATI_PATH_TICK,
+  DAWATI_PATH_ARROW
+} DawatiPathKind;
+
+typedef void (*DawatiPathBuildFunc) (cairo_t       *cr,
+                                     const gdouble *params);
+
+void dawati_path_cache_append (cairo_t             *cr,
+                               gdouble              x,
+                               gdouble              y,
+                               DawatiPathKind       kind,
+                               const gdouble       *params,
+                               DawatiPathBuildFunc  build);
+
+void dawati_path_cache_print_stats (void);
+
+G_END_DECLS
+
+#endif /* _DAWATI_PATH_CACHE_H */
@@ -0,0 +1,379 @@
+/*
+ * dawati-gtk-engine - A GTK+ theme engine for Dawati
+ *
+ * Copyright (c) 2011, Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "dawati-pixbuf.h"
+
+#include <string.h>
+
+/* The SIMD versions are built with the target attribute, so the rest of
+ * the engine needs no special compiler flags, and picked at run time. */
+#if (defined (__x86_64__) || defined (__i386__)) \
+  && (defined (__clang__) \
+      || (defined (__GNUC__) \
+          && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#define DAWATI_PIXBUF_X86 1
+#include <immintrin.h>
+#endif
+
+/* Transforms n pixels of a row from src to dest. Pixels in both have four
+ * channels, with the alpha last. */
+typedef void (*DawatiRowFunc) (const guchar *src,
+                               guchar       *dest,
+                               gint          n,
+                               gdouble       alpha,
+                               gfloat        saturation);
+
+/* The same arithmetic as gdk_pixbuf_saturate_and_pixelate(), so that the
+ * results don't change. */
+static inline void
+dawati_transform_pixel (const guchar *src,
+                        guchar       *dest,
+                        gint          src_channels,
+                        gint          dest_channels,
+                        gdouble       alpha,
+                        gfloat        saturation)
+{
+  guchar intensity;
+  gint t, i;
+
+  intensity = src[0] * 0.30 + src[1] * 0.59 + src[2] * 0.11;
+
+  for (i = 0; i < 3; i++)
+    {
+      t = (1.0 - saturation) * intensity + saturation * src[i];
+      dest[i] = CLAMP (t, 0, 255);
+    }
+
+  if (dest_channels == 4)
+    dest[3] = src_channels == 4 ? (guchar) (src[3] * alpha)
+                                : (guchar) (255 * alpha);
+}
+
+static void
+dawati_transform_row_scalar (const guchar *src,
+                             guchar       *dest,
+                             gint          n,
+                             gdouble       alpha,
+                             gfloat        saturation)
+{
+  gint x;
+
+  for (x = 0; x < n; x++)
+    dawati_transform_pixel (src + x * 4, dest + x * 4, 4, 4,
+                            alpha, saturation);
+}
+
+#ifdef DAWATI_PIXBUF_X86
+/* Four pixels at a time: the channels are taken out of each 32 bit pixel
+ * into their own vector, worked on as floats and put back. The results
+ * can be a level away from the scalar ones where the float and double
+ * products truncate differently. */
+__attribute__ ((target ("sse2")))
+static void
+dawati_transform_row_sse2 (const guchar *src,
+                           guchar       *dest,
+                           gint          n,
+                           gdouble       alpha,
+                           gfloat        saturation)
+{
+  const __m128i mask = _mm_set1_epi32 (0xff);
+  const __m128 zero = _mm_setzero_ps ();
+  const __m128 max = _mm_set1_ps (255.0f);
+  const __m128 kr = _mm_set1_ps (0.30f);
+  const __m128 kg = _mm_set1_ps (0.59f);
+  const __m128 kb = _mm_set1_ps (0.11f);
+  const __m128 ka = _mm_set1_ps ((gfloat) alpha);
+  const __m128 ks = _mm_set1_ps (saturation);
+  const __m128 ki = _mm_set1_ps (1.0f - saturation);
+  gint x;
+
+  for (x = 0; x + 4 <= n; x += 4)
+    {
+      __m128i p = _mm_loadu_si128 ((const __m128i *) (src + x * 4));
+      __m128 r, g, b, a, i;
+      __m128i out;
+
+      r = _mm_cvtepi32_ps (_mm_and_si128 (p, mask));
+      g = _mm_cvtepi32_ps (_mm_and_si128 (_mm_srli_epi32 (p, 8), mask));
+      b = _mm_cvtepi32_ps (_mm_and_si128 (_mm_srli_epi32 (p, 16), mask));
+      a = _mm_cvtepi32_ps (_mm_srli_epi32 (p, 24));
+
+      i = _mm_add_ps (_mm_add_ps (_mm_mul_ps (r, kr), _mm_mul_ps (g, kg)),
+                      _mm_mul_ps (b, kb));
+      i = _mm_mul_ps (_mm_cvtepi32_ps (_mm_cvttps_epi32 (i)), ki);
+
+#define SATURATE(c) \
+  _mm_cvttps_epi32 (_mm_min_ps (_mm_max_ps (_mm_add_ps (i, _mm_mul_ps (c, ks)), \
+                                            zero), max))
+
+      out = _mm_or_si128 (SATURATE (r),
+                          _mm_slli_epi32 (SATURATE (g), 8));
+      out = _mm_or_si128 (out, _mm_slli_epi32 (SATURATE (b), 16));
+      out = _mm_or_si128 (out, _mm_slli_epi32 (_mm_cvttps_epi32
+                                               (_mm_mul_ps (a, ka)), 24));
+#undef SATURATE
+
+      _mm_storeu_si128 ((__m128i *) (dest + x * 4), out);
+    }
+
+  dawati_transform_row_scalar (src + x * 4, dest + x * 4, n - x,
+                               alpha, saturation);
+}
+
+/* the same eight pixels at a time */
+__attribute__ ((target ("avx2")))
+static void
+dawati_transform_row_avx2 (const guchar *src,
+                           guchar       *dest,
+                           gint          n,
+                           gdouble       alpha,
+                           gfloat        saturation)
+{
+  const __m256i mask = _mm256_set1_epi32 (0xff);
+  const __m256 zero = _mm256_setzero_ps ();
+  const __m256 max = _mm256_set1_ps (255.0f);
+  const __m256 kr = _mm256_set1_ps (0.30f);
+  const __m256 kg = _mm256_set1_ps (0.59f);
+  const __m256 kb = _mm256_set1_ps (0.11f);
+  const __m256 ka = _mm256_set1_ps ((gfloat) alpha);
+  const __m256 ks = _mm256_set1_ps (saturation);
+  const __m256 ki = _mm256_set1_ps (1.0f - saturation);
+  gint x;
+
+  for (x = 0; x + 8 <= n; x += 8)
+    {
+      __m256i p = _mm256_loadu_si256 ((const __m256i *) (src + x * 4));
+      __m256 r, g, b, a, i;
+      __m256i out;
+
+      r = _mm256_cvtepi32_ps (_mm256_and_si256 (p, mask));
+      g = _mm256_cvtepi32_ps (_mm256_and_si256 (_mm256_srli_epi32 (p, 8),
+                                                mask));
+      b = _mm256_cvtepi32_ps (_mm256_and_si256 (_mm256_srli_epi32 (p, 16),
+                                                mask));
+      a = _mm256_cvtepi32_ps (_mm256_srli_epi32 (p, 24));
+
+      i = _mm256_add_ps (_mm256_add_ps (_mm256_mul_ps (r, kr),
+                                        _mm256_mul_ps (g, kg)),
+                         _mm256_mul_ps (b, kb));
+      i = _mm256_mul_ps (_mm256_cvtepi32_ps (_mm256_cvttps_epi32 (i)), ki);
+
+#define SATURATE(c) \
+  _mm256_cvttps_epi32 (_mm256_min_ps (_mm256_max_ps \
+                                      (_mm256_add_ps (i, _mm256_mul_ps (c, ks)), \
+                                       zero), max))
+
+      out = _mm256_or_si256 (SATURATE (r),
+                             _mm256_slli_epi32 (SATURATE (g), 8));
+      out = _mm256_or_si256 (out, _mm256_slli_epi32 (SATURATE (b), 16));
+      out = _mm256_or_si256 (out, _mm256_slli_epi32 (_mm256_cvttps_epi32
+                                                     (_mm256_mul_ps (a, ka)),
+                                                     24));
+#undef SATURATE
+
+      _mm256_storeu_si256 ((__m256i *) (dest + x * 4), out);
+    }
+
+  dawati_transform_row_sse2 (src + x * 4, dest + x * 4, n - x,
+                             alpha, saturation);
+}
+#endif
+
+static DawatiRowFunc transform_row = NULL;
+static const gchar *transform_name = NULL;
+
+gboolean
+dawati_pixbuf_set_impl (DawatiPixbufImpl impl)
+{
+#ifdef DAWATI_PIXBUF_X86
+  __builtin_cpu_init ();
+
+  if (impl == DAWATI_PIXBUF_IMPL_AUTO)
+    impl = __builtin_cpu_supports ("avx2") ? DAWATI_PIXBUF_IMPL_AVX2
+      : __builtin_cpu_supports ("sse2") ? DAWATI_PIXBUF_IMPL_SSE2
+      : DAWATI_PIXBUF_IMPL_SCALAR;
+
+  switch (impl)
+    {
+    case DAWATI_PIXBUF_IMPL_AVX2:
+      if (!__builtin_cpu_supports ("avx2"))
+        return FALSE;
+      transform_row = dawati_transform_row_avx2;
+      transform_name = "avx2";
+      return TRUE;
+
+    case DAWATI_PIXBUF_IMPL_SSE2:
+      if (!__builtin_cpu_supports ("sse2"))
+        return FALSE;
+      transform_row = dawati_transform_row_sse2;
+      transform_name = "sse2";
+      return TRUE;
+
+    default:
+      break;
+    }
+#else
+  if (impl != DAWATI_PIXBUF_IMPL_AUTO && impl != DAWATI_PIXBUF_IMPL_SCALAR)
+    return FALSE;
+#endif
+
+  transform_row = dawati_transform_row_scalar;
+  transform_name = "scalar";
+  return TRUE;
+}
+
+const gchar *
+dawati_pixbuf_get_impl_name (void)
+{
+  if (!transform_row)
+    dawati_pixbuf_set_impl (DAWATI_PIXBUF_IMPL_AUTO);
+
+  return transform_name;
+}
+
+GdkPixbuf *
+dawati_pixbuf_transform (const GdkPixbuf *src,
+                         gdouble          alpha,
+                         gfloat           saturation,
+                         gboolean         add_alpha)
+{
+  GdkPixbuf *dest;
+  const guchar *src_pixels;
+  guchar *dest_pixels;
+  gint width, height, src_stride, dest_stride;
+  gint src_channels, dest_channels;
+  gint x, y;
+
+  g_return_val_if_fail (GDK_IS_PIXBUF (src), NULL);
+  g_return_val_if_fail (gdk_pixbuf_get_bits_per_sample (src) == 8, NULL);
+
+  if (!transform_row)
+    dawati_pixbuf_set_impl (DAWATI_PIXBUF_IMPL_AUTO);
+
+  width = gdk_pixbuf_get_width (src);
+  height = gdk_pixbuf_get_height (src);
+  src_channels = gdk_pixbuf_get_n_channels (src);
+  src_stride = gdk_pixbuf_get_rowstride (src);
+  src_pixels = gdk_pixbuf_get_pixels (src);
+
+  dest = gdk_pixbuf_new (GDK_COLORSPACE_RGB,
+                         add_alpha || src_channels == 4, 8, width, height);
+  if (!dest)
+    return NULL;
+
+  dest_channels = gdk_pixbuf_get_n_channels (dest);
+  dest_stride = gdk_pixbuf_get_rowstride (dest);
+  dest_pixels = gdk_pixbuf_get_pixels (dest);
+
+  for (y = 0; y < height; y++)
+    {
+      const guchar *s = src_pixels + y * src_stride;
+      guchar *d = dest_pixels + y * dest_stride;
+
+      /* the vector versions only know four channel pixels */
+      if (src_channels == 4)
+        transform_row (s, d, width, alpha, saturation);
+      else
+        for (x = 0; x < width; x++)
+          dawati_transform_pixel (s + x * src_channels, d + x * dest_channels,
+                                  src_channels, dest_channels,
+                                  alpha, saturation);
+    }
+
+  return dest;
+}
+
+/* Odd rows and columns are folded into the last pixel. Colours are
+ * weighted by their alpha so that transparent pixels don't darken the
+ * edges. */
+GdkPixbuf *
+dawati_pixbuf_halve (const GdkPixbuf *src)
+{
+  GdkPixbuf *dest;
+  const guchar *src_pixels;
+  guchar *dest_pixels;
+  gint width, height, src_stride, dest_stride, n_channels;
+  gint dest_width, dest_height;
+  gint x, y, c;
+
+  g_return_val_if_fail (GDK_IS_PIXBUF (src), NULL);
+  g_return_val_if_fail (gdk_pixbuf_get_bits_per_sample (src) == 8, NULL);
+
+  width = gdk_pixbuf_get_width (src);
+  height = gdk_pixbuf_get_height (src);
+  n_channels = gdk_pixbuf_get_n_channels (src);
+  src_stride = gdk_pixbuf_get_rowstride (src);
+  src_pixels = gdk_pixbuf_get_pixels (src);
+
+  dest_width = MAX (width / 2, 1);
+  dest_height = MAX (height / 2, 1);
+
+  dest = gdk_pixbuf_new (GDK_COLORSPACE_RGB, n_channels == 4, 8,
+                         dest_width, dest_height);
+  if (!dest)
+    return NULL;
+
+  dest_stride = gdk_pixbuf_get_rowstride (dest);
+  dest_pixels = gdk_pixbuf_get_pixels (dest);
+
+  for (y = 0; y < dest_height; y++)
+    {
+      gint y0 = y * 2;
+      gint y1 = y == dest_height - 1 ? height : y0 + 2;
+      guchar *d = dest_pixels + y * dest_stride;
+
+      for (x = 0; x < dest_width; x++, d += n_channels)
+        {
+          gint x0 = x * 2;
+          gint x1 = x == dest_width - 1 ? width : x0 + 2;
+          guint sum[4] = { 0, 0, 0, 0 };
+          guint n = (x1 - x0) * (y1 - y0);
+          gint sx, sy;
+
+          for (sy = y0; sy < y1; sy++)
+            {
+              const guchar *s = src_pixels + sy * src_stride + x0 * n_channels;
+
+              for (sx = x0; sx < x1; sx++, s += n_channels)
+                {
+                  guint weight = n_channels == 4 ? s[3] : 1;
+
+                  for (c = 0; c < 3; c++)
+                    sum[c] += s[c] * weight;
+                  sum[3] += weight;
+                }
+            }
+
+          if (n_channels == 4)
+            {
+              for (c = 0; c < 3; c++)
+                d[c] = sum[3] ? (sum[c] + sum[3] / 2) / sum[3] : 0;
+              d[3] = (sum[3] + n / 2) / n;
+            }
+          else
+            {
+              for (c = 0; c < 3; c++)
+                d[c] = (sum[c] + n / 2) / n;
+            }
+        }
+    }
+
+  return dest;
+}
@@ -0,0 +1,57 @@
+/*
+ * dawati-gtk-engine - A GTK+ theme engine for Dawati
+ *
+ * Copyright (c) 2011, Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef _DAWATI_PIXBUF_H
+#define _DAWATI_PIXBUF_H
+
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+/* The insensitive and prelight icons in one pass over the pixels: a copy
+ * of src with its alpha scaled by alpha and its colours saturated as
+ * gdk_pixbuf_saturate_and_pixelate() does without pixelation. With
+ * add_alpha the copy always has an alpha channel. */
+
+typedef enum
+{
+  DAWATI_PIXBUF_IMPL_AUTO,
+  DAWATI_PIXBUF_IMPL_SCALAR,
+  DAWATI_PIXBUF_IMPL_SSE2,
+  DAWATI_PIXBUF_IMPL_AVX2
+} DawatiPixbufImpl;
+
+GdkPixbuf   *dawati_pixbuf_transform     (const GdkPixbuf  *src,
+                                          gdouble           alpha,
+                                          gfloat            saturation,
+                                          gboolean          add_alpha);
+
+/* a copy of src at half its size, each pixel the average of four, for
+ * scaling icons down by large factors without aliasing */
+GdkPixbuf   *dawati_pixbuf_halve         (const GdkPixbuf  *src);
+
+/* the best implementation the processor has is used, these are for
+ * benchmarks and comparisons */
+gboolean     dawati_pixbuf_set_impl      (DawatiPixbufImpl  impl);
+const gchar *dawati_pixbuf_get_impl_name (void);
+
+G_END_DECLS
+
+#endif /* _DAWATI_PIXBUF_H */
@@ -0,0 +1,47 @@
+/*
+ * dawati-gtk-engine - A GTK+ theme engine for Dawati
+ *
+ * Copyright (c) 2011, Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef _DAWATI_PROBES_H
+#define _DAWATI_PROBES_H
+
+/* Static probes on entry and return of the draw functions, for perf,
+ * bpftrace or SystemTap to attach to, e.g.
+ *
+ *   bpftrace -e 'usdt:/path/to/libdawati.so:dawati:draw_box_entry
+ *                { printf ("%s\n", str (arg0)); }'
+ *
+ * The arguments are the detail, the state, the width and the height, with
+ * -1 for a size that is not known. Probes are only compiled in with
+ * --enable-sdt-probes, and cost a nop each when nothing is attached. */
+
+#ifdef ENABLE_SDT_PROBES
+
+#include <sys/sdt.h>
+
+#define DAWATI_PROBE(name, detail, state, width, height) \
+  DTRACE_PROBE4 (dawati, name, detail, state, width, height)
+
+#else
+
+#define DAWATI_PROBE(name, detail, state, width, height)
+
+#endif /* ENABLE_SDT_PROBES */
+
+#endif /* _DAWATI_PROBES_H */
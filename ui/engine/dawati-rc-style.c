@@ -34,6 +34,26 @@ enum
   TOKEN_BORDER_COLOR = G_TOKEN_LAST + 1,
   TOKEN_RADIUS,
   TOKEN_SHADOW,
+  TOKEN_IMAGE,
+
+  /* inside image blocks */
+  TOKEN_FUNCTION,
+  TOKEN_FILE,
+  TOKEN_BORDER,
+  TOKEN_STRETCH,
+  TOKEN_OVERLAY_FILE,
+  TOKEN_OVERLAY_BORDER,
+  TOKEN_OVERLAY_STRETCH,
+  TOKEN_RECOLORABLE,
+  TOKEN_DETAIL,
+  TOKEN_STATE,
+  TOKEN_IMAGE_SHADOW,
+  TOKEN_ORIENTATION,
+  TOKEN_ARROW_DIRECTION,
+  TOKEN_EXPANDER_STYLE,
+
+  /* the values of image fields, indexes into dawati_image_values */
+  TOKEN_VALUE
 };
 
 static struct
@@ -46,7 +66,84 @@ dawati_rc_symbols[] =
   { "border", TOKEN_BORDER_COLOR },
   { "radius", TOKEN_RADIUS },
   { "shadow", TOKEN_SHADOW },
+  { "image", TOKEN_IMAGE },
   { NULL, 0 }
+},
+dawati_image_symbols[] =
+{
+  { "function", TOKEN_FUNCTION },
+  { "file", TOKEN_FILE },
+  { "border", TOKEN_BORDER },
+  { "stretch", TOKEN_STRETCH },
+  { "overlay_file", TOKEN_OVERLAY_FILE },
+  { "overlay_border", TOKEN_OVERLAY_BORDER },
+  { "overlay_stretch", TOKEN_OVERLAY_STRETCH },
+  { "recolorable", TOKEN_RECOLORABLE },
+  { "detail", TOKEN_DETAIL },
+  { "state", TOKEN_STATE },
+  { "shadow", TOKEN_IMAGE_SHADOW },
+  { "orientation", TOKEN_ORIENTATION },
+  { "arrow_direction", TOKEN_ARROW_DIRECTION },
+  { "expander_style", TOKEN_EXPANDER_STYLE },
+  { NULL, 0 }
+};
+
+typedef enum
+{
+  VALUE_FUNCTION,
+  VALUE_BOOLEAN,
+  VALUE_STATE,
+  VALUE_SHADOW,
+  VALUE_ORIENTATION,
+  VALUE_ARROW,
+  VALUE_EXPANDER
+} DawatiValueType;
+
+static const struct
+{
+  gchar           *name;
+  DawatiValueType  type;
+  gint             value;
+}
+dawati_image_values[] =
+{
+  { "BOX", VALUE_FUNCTION, DAWATI_IMAGE_BOX },
+  { "FLAT_BOX", VALUE_FUNCTION, DAWATI_IMAGE_FLAT_BOX },
+  { "SHADOW", VALUE_FUNCTION, DAWATI_IMAGE_SHADOW },
+  { "CHECK", VALUE_FUNCTION, DAWATI_IMAGE_CHECK },
+  { "OPTION", VALUE_FUNCTION, DAWATI_IMAGE_OPTION },
+  { "SLIDER", VALUE_FUNCTION, DAWATI_IMAGE_SLIDER },
+  { "STEPPER", VALUE_FUNCTION, DAWATI_IMAGE_STEPPER },
+  { "EXPANDER", VALUE_FUNCTION, DAWATI_IMAGE_EXPANDER },
+  { "ARROW", VALUE_FUNCTION, DAWATI_IMAGE_ARROW },
+
+  { "TRUE", VALUE_BOOLEAN, TRUE },
+  { "FALSE", VALUE_BOOLEAN, FALSE },
+
+  { "NORMAL", VALUE_STATE, GTK_STATE_NORMAL },
+  { "ACTIVE", VALUE_STATE, GTK_STATE_ACTIVE },
+  { "PRELIGHT", VALUE_STATE, GTK_STATE_PRELIGHT },
+  { "SELECTED", VALUE_STATE, GTK_STATE_SELECTED },
+  { "INSENSITIVE", VALUE_STATE, GTK_STATE_INSENSITIVE },
+
+  { "NONE", VALUE_SHADOW, GTK_SHADOW_NONE },
+  { "IN", VALUE_SHADOW, GTK_SHADOW_IN },
+  { "OUT", VALUE_SHADOW, GTK_SHADOW_OUT },
+  { "ETCHED_IN", VALUE_SHADOW, GTK_SHADOW_ETCHED_IN },
+  { "ETCHED_OUT", VALUE_SHADOW, GTK_SHADOW_ETCHED_OUT },
+
+  { "HORIZONTAL", VALUE_ORIENTATION, GTK_ORIENTATION_HORIZONTAL },
+  { "VERTICAL", VALUE_ORIENTATION, GTK_ORIENTATION_VERTICAL },
+
+  { "UP", VALUE_ARROW, GTK_ARROW_UP },
+  { "DOWN", VALUE_ARROW, GTK_ARROW_DOWN },
+  { "LEFT", VALUE_ARROW, GTK_ARROW_LEFT },
+  { "RIGHT", VALUE_ARROW, GTK_ARROW_RIGHT },
+
+  { "COLLAPSED", VALUE_EXPANDER, GTK_EXPANDER_COLLAPSED },
+  { "SEMI_COLLAPSED", VALUE_EXPANDER, GTK_EXPANDER_SEMI_COLLAPSED },
+  { "SEMI_EXPANDED", VALUE_EXPANDER, GTK_EXPANDER_SEMI_EXPANDED },
+  { "EXPANDED", VALUE_EXPANDER, GTK_EXPANDER_EXPANDED }
 };
 
 static GtkStyle *
@@ -105,6 +202,259 @@ dawati_parse_border_color (GScanner             *scanner,
   return G_TOKEN_NONE;
 }
 
+/* = VALUE, where VALUE is one of dawati_image_values of the given type */
+static guint
+dawati_parse_image_value (GScanner        *scanner,
+                          DawatiValueType  type,
+                          gint            *value)
+{
+  guint token;
+
+  /* the field */
+  g_scanner_get_next_token (scanner);
+
+  token = dawati_get_token (scanner, G_TOKEN_EQUAL_SIGN);
+  if (token != G_TOKEN_NONE)
+    return token;
+
+  token = g_scanner_get_next_token (scanner);
+  if (token < TOKEN_VALUE
+      || token >= TOKEN_VALUE + G_N_ELEMENTS (dawati_image_values)
+      || dawati_image_values[token - TOKEN_VALUE].type != type)
+    return G_TOKEN_IDENTIFIER;
+
+  *value = dawati_image_values[token - TOKEN_VALUE].value;
+
+  return G_TOKEN_NONE;
+}
+
+/* = "string" */
+static guint
+dawati_parse_image_string (GScanner  *scanner,
+                           gchar    **string)
+{
+  guint token;
+
+  g_scanner_get_next_token (scanner);
+
+  token = dawati_get_token (scanner, G_TOKEN_EQUAL_SIGN);
+  if (token != G_TOKEN_NONE)
+    return token;
+
+  token = dawati_get_token (scanner, G_TOKEN_STRING);
+  if (token != G_TOKEN_NONE)
+    return token;
+
+  g_free (*string);
+  *string = g_strdup (scanner->value.v_string);
+
+  return G_TOKEN_NONE;
+}
+
+/* = { left, right, top, bottom } */
+static guint
+dawati_parse_image_border (GScanner *scanner,
+                           gint      border[4])
+{
+  guint token;
+  gint i;
+
+  g_scanner_get_next_token (scanner);
+
+  token = dawati_get_token (scanner, G_TOKEN_EQUAL_SIGN);
+  if (token != G_TOKEN_NONE)
+    return token;
+
+  token = dawati_get_token (scanner, G_TOKEN_LEFT_CURLY);
+  if (token != G_TOKEN_NONE)
+    return token;
+
+  for (i = 0; i < 4; i++)
+    {
+      if (i > 0)
+        {
+          token = dawati_get_token (scanner, G_TOKEN_COMMA);
+          if (token != G_TOKEN_NONE)
+            return token;
+        }
+
+      token = dawati_get_token (scanner, G_TOKEN_INT);
+      if (token != G_TOKEN_NONE)
+        return token;
+
+      border[i] = scanner->value.v_int;
+    }
+
+  return dawati_get_token (scanner, G_TOKEN_RIGHT_CURLY);
+}
+
+static DawatiImagePart *
+dawati_image_get_part (DawatiImagePart **part)
+{
+  if (!*part)
+    *part = dawati_image_part_new ();
+
+  return *part;
+}
+
+/* image { ... }, in the syntax of the pixmap engine */
+static guint
+dawati_parse_image (GtkSettings   *settings,
+                    GScanner      *scanner,
+                    DawatiRcStyle *rc_style)
+{
+  static GQuark scope_id;
+  DawatiImage *image;
+  DawatiImagePart **part;
+  gboolean function_set = FALSE;
+  gchar *filename;
+  guint old_scope;
+  guint token;
+  gint value = 0;
+  guint i;
+
+  if (!scope_id)
+    scope_id = g_quark_from_string ("dawati-gtk-engine-image");
+
+  /* image */
+  g_scanner_get_next_token (scanner);
+
+  token = dawati_get_token (scanner, G_TOKEN_LEFT_CURLY);
+  if (token != G_TOKEN_NONE)
+    return token;
+
+  old_scope = g_scanner_set_scope (scanner, scope_id);
+
+  if (!g_scanner_lookup_symbol (scanner, dawati_image_symbols[0].name))
+    {
+      for (i = 0; dawati_image_symbols[i].name; i++)
+        g_scanner_scope_add_symbol (scanner, scope_id,
+                                    dawati_image_symbols[i].name,
+                                    GINT_TO_POINTER (dawati_image_symbols[i].
+                                                     token));
+
+      for (i = 0; i < G_N_ELEMENTS (dawati_image_values); i++)
+        g_scanner_scope_add_symbol (scanner, scope_id,
+                                    dawati_image_values[i].name,
+                                    GINT_TO_POINTER (TOKEN_VALUE + i));
+    }
+
+  image = dawati_image_new ();
+
+  token = g_scanner_peek_next_token (scanner);
+  while (token != G_TOKEN_RIGHT_CURLY)
+    {
+      part = (token == TOKEN_OVERLAY_FILE
+              || token == TOKEN_OVERLAY_BORDER
+              || token == TOKEN_OVERLAY_STRETCH)
+        ? &image->overlay : &image->background;
+
+      switch (token)
+        {
+        case TOKEN_FUNCTION:
+          token = dawati_parse_image_value (scanner, VALUE_FUNCTION, &value);
+          image->match.function = value;
+          function_set = TRUE;
+          break;
+
+        case TOKEN_FILE:
+        case TOKEN_OVERLAY_FILE:
+          filename = NULL;
+          token = dawati_parse_image_string (scanner, &filename);
+          if (token != G_TOKEN_NONE)
+            break;
+
+          /* warns when the file isn't there */
+          g_free (dawati_image_get_part (part)->filename);
+          (*part)->filename = gtk_rc_find_pixmap_in_path (settings, scanner,
+                                                          filename);
+          g_free (filename);
+          break;
+
+        case TOKEN_BORDER:
+        case TOKEN_OVERLAY_BORDER:
+          token = dawati_parse_image_border (scanner,
+                                             dawati_image_get_part (part)->
+                                             border);
+          break;
+
+        case TOKEN_STRETCH:
+        case TOKEN_OVERLAY_STRETCH:
+          token = dawati_parse_image_value (scanner, VALUE_BOOLEAN, &value);
+          dawati_image_get_part (part)->stretch = value;
+          break;
+
+        case TOKEN_RECOLORABLE:
+          /* not implemented by the pixmap engine either */
+          token = dawati_parse_image_value (scanner, VALUE_BOOLEAN, &value);
+          break;
+
+        case TOKEN_DETAIL:
+          token = dawati_parse_image_string (scanner, &image->detail);
+          image->match.detail = image->detail;
+          break;
+
+        case TOKEN_STATE:
+          token = dawati_parse_image_value (scanner, VALUE_STATE, &value);
+          image->match.state = value;
+          image->match.flags |= DAWATI_IMAGE_MATCH_STATE;
+          break;
+
+        case TOKEN_IMAGE_SHADOW:
+          token = dawati_parse_image_value (scanner, VALUE_SHADOW, &value);
+          image->match.shadow = value;
+          image->match.flags |= DAWATI_IMAGE_MATCH_SHADOW;
+          break;
+
+        case TOKEN_ORIENTATION:
+          token = dawati_parse_image_value (scanner, VALUE_ORIENTATION,
+                                            &value);
+          image->match.orientation = value;
+          image->match.flags |= DAWATI_IMAGE_MATCH_ORIENTATION;
+          break;
+
+        case TOKEN_ARROW_DIRECTION:
+          token = dawati_parse_image_value (scanner, VALUE_ARROW, &value);
+          image->match.arrow_direction = value;
+          image->match.flags |= DAWATI_IMAGE_MATCH_ARROW_DIRECTION;
+          break;
+
+        case TOKEN_EXPANDER_STYLE:
+          token = dawati_parse_image_value (scanner, VALUE_EXPANDER, &value);
+          image->match.expander_style = value;
+          image->match.flags |= DAWATI_IMAGE_MATCH_EXPANDER_STYLE;
+          break;
+
+        default:
+          g_scanner_get_next_token (scanner);
+          token = G_TOKEN_RIGHT_CURLY;
+          break;
+        }
+
+      if (token != G_TOKEN_NONE)
+        {
+          dawati_image_unref (image);
+          return token;
+        }
+
+      token = g_scanner_peek_next_token (scanner);
+    }
+
+  g_scanner_get_next_token (scanner);
+  g_scanner_set_scope (scanner, old_scope);
+
+  /* an image without a function never matches */
+  if (!function_set)
+    {
+      dawati_image_unref (image);
+      return G_TOKEN_NONE;
+    }
+
+  rc_style->images = g_slist_append (rc_style->images, image);
+
+  return G_TOKEN_NONE;
+}
+
 static guint
 dawati_rc_style_parse (GtkRcStyle  *rc_style,
                                GtkSettings *settings,
@@ -135,11 +485,21 @@ dawati_rc_style_parse (GtkRcStyle  *rc_style,
         }
     }
 
+  /* the images of an engine section replace those of the parent style,
+   * and one without images is drawn by the render core */
+  dawati_image_list_free (mb_style->images);
+  mb_style->images = NULL;
+  mb_style->images_set = TRUE;
+
   token = g_scanner_peek_next_token (scanner);
   while (token != G_TOKEN_RIGHT_CURLY)
     {
       switch (token)
         {
+        case TOKEN_IMAGE:
+          token = dawati_parse_image (settings, scanner, mb_style);
+          break;
+
         case TOKEN_BORDER_COLOR:
           token = dawati_parse_border_color (scanner, mb_style);
           break;
@@ -235,13 +595,39 @@ dawati_rc_style_merge (GtkRcStyle *adest,
       dest->shadow = src->shadow;
       dest->shadow_set = TRUE;
     }
+
+  /* the images of styles with images add up, as with the pixmap engine,
+   * but a style that has an engine section without any keeps none */
+  if (!dest->images_set)
+    {
+      dest->images = dawati_image_list_copy (src->images);
+      dest->images_set = src->images_set;
+    }
+  else if (dest->images && src->images)
+    {
+      dest->images = g_slist_concat (dest->images,
+                                     dawati_image_list_copy (src->images));
+    }
+}
+
+static void
+dawati_rc_style_finalize (GObject *object)
+{
+  DawatiRcStyle *rc_style = DAWATI_RC_STYLE (object);
+
+  dawati_image_list_free (rc_style->images);
+
+  G_OBJECT_CLASS (dawati_rc_style_parent_class)->finalize (object);
 }
 
 static void
 dawati_rc_style_class_init (DawatiRcStyleClass *klass)
 {
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
   GtkRcStyleClass *rc_style_class = GTK_RC_STYLE_CLASS (klass);
 
+  object_class->finalize = dawati_rc_style_finalize;
+
   rc_style_class->create_style = dawati_rc_style_create_style;
   rc_style_class->parse = dawati_rc_style_parse;
   rc_style_class->merge = dawati_rc_style_merge;
@@ -24,6 +24,8 @@
 #include <gtk/gtk.h>
 #include <gmodule.h>
 
+#include "dawati-image.h"
+
 G_BEGIN_DECLS
 
 #define DAWATI_TYPE_RC_STYLE                    \
@@ -58,10 +60,12 @@ struct _DawatiRcStyle
   gint radius;
   GdkColor border_color[5];
   gdouble shadow;
+  GSList *images;   /* of DawatiImage */
 
   /* flags for merge */
   gboolean radius_set : 1;
   gboolean shadow_set : 1;
+  gboolean images_set : 1;
   gboolean border_color_set[5];
 };
 
@@ -0,0 +1,610 @@
+/*
+ * dawati-gtk-engine - A GTK+ theme engine for Dawati
+ *
+ * Copyright (c) 2011, Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "dawati-record.h"
+
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* The log starts with RECORD_MAGIC, the format version and the names of
+ * the details, so that logs stay readable when details are added. Then
+ * come the records, all little endian:
+ *
+ *   'P' serial, radius, shadow, then fg, bg, mid, text, base and border for
+ *       each state, each colour as three 16 bit channels
+ *   'D' serial of the parameters, the op and the clip area; the fill colours
+ *       and the clip area are only there if their flag is set
+ */
+#define RECORD_MAGIC "DAWATIRC"
+#define RECORD_VERSION 1
+
+#define RECORD_PARAMS 'P'
+#define RECORD_DRAW 'D'
+
+#define DRAW_FILL_CORNERS (1 << 0)
+#define DRAW_FILL_COLORS  (1 << 1)
+#define DRAW_AREA         (1 << 2)
+
+static FILE *record_file = NULL;
+static GHashTable *recorded_params = NULL;
+static GByteArray *record_buffer = NULL;
+
+G_LOCK_DEFINE_STATIC (record);
+
+struct _DawatiRecordReader
+{
+  gchar        *contents;
+  gsize         length;
+  gsize         offset;
+
+  /* the details of the recording, by their value there */
+  DawatiDetail *details;
+  guint         n_details;
+
+  /* recorded serial to DawatiRenderParams */
+  GHashTable   *params;
+};
+
+static void
+put_u8 (GByteArray *buffer,
+        guint8      value)
+{
+  g_byte_array_append (buffer, &value, 1);
+}
+
+static void
+put_u16 (GByteArray *buffer,
+         guint16     value)
+{
+  value = GUINT16_TO_LE (value);
+  g_byte_array_append (buffer, (guint8 *) &value, 2);
+}
+
+static void
+put_u32 (GByteArray *buffer,
+         guint32     value)
+{
+  value = GUINT32_TO_LE (value);
+  g_byte_array_append (buffer, (guint8 *) &value, 4);
+}
+
+static void
+put_double (GByteArray *buffer,
+            gdouble     value)
+{
+  guint64 bits;
+
+  memcpy (&bits, &value, sizeof (bits));
+  bits = GUINT64_TO_LE (bits);
+  g_byte_array_append (buffer, (guint8 *) &bits, 8);
+}
+
+/* the colours come from 16 bit GdkColors, so this loses nothing */
+static void
+put_colors (GByteArray        *buffer,
+            const DawatiColor *colors)
+{
+  gint i;
+
+  for (i = 0; i < 5; i++)
+    {
+      put_u16 (buffer, (guint16) floor (colors[i].red * 65535.0 + 0.5));
+      put_u16 (buffer, (guint16) floor (colors[i].green * 65535.0 + 0.5));
+      put_u16 (buffer, (guint16) floor (colors[i].blue * 65535.0 + 0.5));
+    }
+}
+
+static void
+dawati_record_close (void)
+{
+  G_LOCK (record);
+
+  if (record_file)
+    fclose (record_file);
+  record_file = NULL;
+
+  G_UNLOCK (record);
+}
+
+gboolean
+dawati_record_open (const gchar *filename)
+{
+  guint i;
+
+  record_file = fopen (filename, "wb");
+  if (!record_file)
+    {
+      g_warning ("Could not open the engine recording %s: %s",
+                 filename, g_strerror (errno));
+      return FALSE;
+    }
+
+  recorded_params = g_hash_table_new (g_direct_hash, g_direct_equal);
+  record_buffer = g_byte_array_new ();
+
+  g_byte_array_append (record_buffer, (guint8 *) RECORD_MAGIC,
+                       strlen (RECORD_MAGIC));
+  put_u32 (record_buffer, RECORD_VERSION);
+
+  put_u8 (record_buffer, DAWATI_N_DETAILS);
+  for (i = 1; i < DAWATI_N_DETAILS; i++)
+    {
+      const gchar *name = dawati_detail_name (i);
+
+      put_u8 (record_buffer, strlen (name));
+      g_byte_array_append (record_buffer, (guint8 *) name, strlen (name));
+    }
+
+  fwrite (record_buffer->data, 1, record_buffer->len, record_file);
+  g_byte_array_set_size (record_buffer, 0);
+
+  atexit (dawati_record_close);
+
+  return TRUE;
+}
+
+void
+dawati_record_op (const DawatiRenderParams *params,
+                  const GdkRectangle       *area,
+                  const DawatiRenderOp     *op)
+{
+  GByteArray *buffer;
+  guint8 flags = 0;
+
+  if (!record_file)
+    return;
+
+  G_LOCK (record);
+
+  /* the file may have been closed at exit */
+  if (!record_file)
+    {
+      G_UNLOCK (record);
+      return;
+    }
+
+  buffer = record_buffer;
+
+  if (!g_hash_table_lookup (recorded_params,
+                            GUINT_TO_POINTER (params->serial)))
+    {
+      put_u8 (buffer, RECORD_PARAMS);
+      put_u32 (buffer, params->serial);
+      put_u32 (buffer, params->radius);
+      put_double (buffer, params->shadow);
+      put_colors (buffer, params->fg);
+      put_colors (buffer, params->bg);
+      put_colors (buffer, params->mid);
+      put_colors (buffer, params->text);
+      put_colors (buffer, params->base);
+      put_colors (buffer, params->border);
+
+      g_hash_table_insert (recorded_params, GUINT_TO_POINTER (params->serial),
+                           GUINT_TO_POINTER (TRUE));
+    }
+
+  if (op->fill_corners)
+    flags |= DRAW_FILL_CORNERS;
+  if (op->fill_colors)
+    flags |= DRAW_FILL_COLORS;
+  if (area)
+    flags |= DRAW_AREA;
+
+  put_u8 (buffer, RECORD_DRAW);
+  put_u32 (buffer, params->serial);
+  put_u8 (buffer, op->element);
+  put_u8 (buffer, op->detail);
+  put_u32 (buffer, op->role);
+  put_u8 (buffer, op->state);
+  put_u8 (buffer, op->shadow);
+  put_u32 (buffer, op->x);
+  put_u32 (buffer, op->y);
+  put_u32 (buffer, op->width);
+  put_u32 (buffer, op->height);
+  put_u8 (buffer, op->widget_state);
+  put_u8 (buffer, op->gap_side);
+  put_u32 (buffer, op->gap_x);
+  put_u32 (buffer, op->gap_width);
+  put_u8 (buffer, op->arrow_type);
+  put_u8 (buffer, op->orientation);
+  put_u8 (buffer, op->edge);
+  put_u8 (buffer, op->expander_style);
+  put_u32 (buffer, op->line_width);
+  put_u8 (buffer, op->fill_state);
+  put_u8 (buffer, flags);
+
+  if (op->fill_colors)
+    put_colors (buffer, op->fill_colors);
+
+  if (area)
+    {
+      put_u32 (buffer, area->x);
+      put_u32 (buffer, area->y);
+      put_u32 (buffer, area->width);
+      put_u32 (buffer, area->height);
+    }
+
+  fwrite (buffer->data, 1, buffer->len, record_file);
+  g_byte_array_set_size (buffer, 0);
+
+  G_UNLOCK (record);
+}
+
+/* reading */
+
+static gboolean
+get_bytes (DawatiRecordReader  *reader,
+           gpointer             data,
+           gsize                size,
+           GError             **error)
+{
+  if (reader->length - reader->offset < size)
+    {
+      g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+                   "Recording is truncated at byte %lu",
+                   (gulong) reader->offset);
+      return FALSE;
+    }
+
+  memcpy (data, reader->contents + reader->offset, size);
+  reader->offset += size;
+
+  return TRUE;
+}
+
+static gboolean
+get_u8 (DawatiRecordReader  *reader,
+        guint8              *value,
+        GError             **error)
+{
+  return get_bytes (reader, value, 1, error);
+}
+
+static gboolean
+get_u32 (DawatiRecordReader  *reader,
+         guint32             *value,
+         GError             **error)
+{
+  if (!get_bytes (reader, value, 4, error))
+    return FALSE;
+
+  *value = GUINT32_FROM_LE (*value);
+
+  return TRUE;
+}
+
+static gboolean
+get_int (DawatiRecordReader  *reader,
+         gint                *value,
+         GError             **error)
+{
+  guint32 u;
+
+  if (!get_u32 (reader, &u, error))
+    return FALSE;
+
+  *value = (gint32) u;
+
+  return TRUE;
+}
+
+static gboolean
+get_double (DawatiRecordReader  *reader,
+            gdouble             *value,
+            GError             **error)
+{
+  guint64 bits;
+
+  if (!get_bytes (reader, &bits, 8, error))
+    return FALSE;
+
+  bits = GUINT64_FROM_LE (bits);
+  memcpy (value, &bits, sizeof (bits));
+
+  return TRUE;
+}
+
+static gboolean
+get_colors (DawatiRecordReader  *reader,
+            DawatiColor         *colors,
+            GError             **error)
+{
+  guint16 channels[15];
+  gint i;
+
+  if (!get_bytes (reader, channels, sizeof (channels), error))
+    return FALSE;
+
+  for (i = 0; i < 5; i++)
+    {
+      colors[i].red = GUINT16_FROM_LE (channels[i * 3]) / 65535.0;
+      colors[i].green = GUINT16_FROM_LE (channels[i * 3 + 1]) / 65535.0;
+      colors[i].blue = GUINT16_FROM_LE (channels[i * 3 + 2]) / 65535.0;
+    }
+
+  return TRUE;
+}
+
+DawatiRecordReader *
+dawati_record_reader_new (const gchar  *filename,
+                          GError      **error)
+{
+  DawatiRecordReader *reader;
+  gchar magic[sizeof (RECORD_MAGIC) - 1];
+  guint32 version;
+  guint8 n_details;
+  guint i;
+
+  reader = g_slice_new0 (DawatiRecordReader);
+  reader->params = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                          NULL, g_free);
+
+  if (!g_file_get_contents (filename, &reader->contents, &reader->length,
+                            error))
+    goto fail;
+
+  if (!get_bytes (reader, magic, sizeof (magic), error))
+    goto fail;
+
+  if (memcmp (magic, RECORD_MAGIC, sizeof (magic)) != 0)
+    {
+      g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+                   "%s is not an engine recording", filename);
+      goto fail;
+    }
+
+  if (!get_u32 (reader, &version, error))
+    goto fail;
+
+  if (version != RECORD_VERSION)
+    {
+      g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+                   "%s is a version %u recording, only version %u is "
+                   "supported", filename, version, RECORD_VERSION);
+      goto fail;
+    }
+
+  /* map the recorded details to the ones known now */
+  if (!get_u8 (reader, &n_details, error))
+    goto fail;
+
+  reader->n_details = MAX (n_details, 1);
+  reader->details = g_new0 (DawatiDetail, reader->n_details);
+
+  for (i = 1; i < reader->n_details; i++)
+    {
+      gchar name[256];
+      guint8 length;
+
+      if (!get_u8 (reader, &length, error)
+          || !get_bytes (reader, name, length, error))
+        goto fail;
+
+      name[length] = '\0';
+      reader->details[i] = dawati_detail_lookup (name);
+    }
+
+  return reader;
+
+fail:
+  dawati_record_reader_free (reader);
+
+  return NULL;
+}
+
+static gboolean
+dawati_record_reader_read_params (DawatiRecordReader  *reader,
+                                  GError             **error)
+{
+  DawatiRenderParams *params;
+  guint32 serial;
+
+  params = g_new0 (DawatiRenderParams, 1);
+
+  if (!get_u32 (reader, &serial, error)
+      || !get_int (reader, &params->radius, error)
+      || !get_double (reader, &params->shadow, error)
+      || !get_colors (reader, params->fg, error)
+      || !get_colors (reader, params->bg, error)
+      || !get_colors (reader, params->mid, error)
+      || !get_colors (reader, params->text, error)
+      || !get_colors (reader, params->base, error)
+      || !get_colors (reader, params->border, error))
+    {
+      g_free (params);
+      return FALSE;
+    }
+
+  /* a serial of this process, so the raster cache works as it did in the
+   * recorded one */
+  dawati_render_params_changed (params);
+
+  g_hash_table_insert (reader->params, GUINT_TO_POINTER (serial), params);
+
+  return TRUE;
+}
+
+static gboolean
+dawati_record_reader_read_draw (DawatiRecordReader  *reader,
+                                DawatiRecordedDraw  *draw,
+                                GError             **error)
+{
+  DawatiRenderOp *op = &draw->op;
+  guint8 element, detail, state, shadow, widget_state, gap_side;
+  guint8 arrow_type, orientation, edge, expander_style, fill_state, flags;
+  guint32 serial;
+
+  memset (draw, 0, sizeof (DawatiRecordedDraw));
+
+  if (!get_u32 (reader, &serial, error)
+      || !get_u8 (reader, &element, error)
+      || !get_u8 (reader, &detail, error)
+      || !get_u32 (reader, &op->role, error)
+      || !get_u8 (reader, &state, error)
+      || !get_u8 (reader, &shadow, error)
+      || !get_int (reader, &op->x, error)
+      || !get_int (reader, &op->y, error)
+      || !get_int (reader, &op->width, error)
+      || !get_int (reader, &op->height, error)
+      || !get_u8 (reader, &widget_state, error)
+      || !get_u8 (reader, &gap_side, error)
+      || !get_int (reader, &op->gap_x, error)
+      || !get_int (reader, &op->gap_width, error)
+      || !get_u8 (reader, &arrow_type, error)
+      || !get_u8 (reader, &orientation, error)
+      || !get_u8 (reader, &edge, error)
+      || !get_u8 (reader, &expander_style, error)
+      || !get_int (reader, &op->line_width, error)
+      || !get_u8 (reader, &fill_state, error)
+      || !get_u8 (reader, &flags, error))
+    return FALSE;
+
+  draw->params = g_hash_table_lookup (reader->params,
+                                      GUINT_TO_POINTER (serial));
+  if (!draw->params)
+    {
+      g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+                   "Draw at byte %lu uses unknown parameters %u",
+                   (gulong) reader->offset, serial);
+      return FALSE;
+    }
+
+  op->element = element;
+  op->detail = detail < reader->n_details ? reader->details[detail]
+                                          : DAWATI_DETAIL_NONE;
+  op->state = state;
+  op->shadow = shadow;
+  op->widget_state = widget_state;
+  op->gap_side = gap_side;
+  op->arrow_type = arrow_type;
+  op->orientation = orientation;
+  op->edge = edge;
+  op->expander_style = expander_style;
+  op->fill_corners = (flags & DRAW_FILL_CORNERS) != 0;
+  op->fill_state = fill_state;
+
+  if (flags & DRAW_FILL_COLORS)
+    {
+      if (!get_colors (reader, draw->fill_colors, error))
+        return FALSE;
+
+      op->fill_colors = draw->fill_colors;
+    }
+
+  if (flags & DRAW_AREA)
+    {
+      draw->has_area = TRUE;
+
+      if (!get_int (reader, &draw->area.x, error)
+          || !get_int (reader, &draw->area.y, error)
+          || !get_int (reader, &draw->area.width, error)
+          || !get_int (reader, &draw->area.height, error))
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* Returns FALSE at the end of the recording, or with error set if it can't
+ * be read. draw->op.fill_colors points into draw, and draw->params stays
+ * valid until the reader is freed. */
+gboolean
+dawati_record_reader_next (DawatiRecordReader  *reader,
+                           DawatiRecordedDraw  *draw,
+                           GError             **error)
+{
+  guint8 tag;
+
+  while (reader->offset < reader->length)
+    {
+      if (!get_u8 (reader, &tag, error))
+        return FALSE;
+
+      switch (tag)
+        {
+        case RECORD_PARAMS:
+          if (!dawati_record_reader_read_params (reader, error))
+            return FALSE;
+          break;
+
+        case RECORD_DRAW:
+          return dawati_record_reader_read_draw (reader, draw, error);
+
+        default:
+          g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+                       "Unknown record '%c' at byte %lu",
+                       tag, (gulong) reader->offset - 1);
+          return FALSE;
+        }
+    }
+
+  return FALSE;
+}
+
+/* Reads the rest of the recording into an array of DawatiRecordedDraw,
+ * with their fill_colors pointing into the array. */
+GArray *
+dawati_record_reader_read_all (DawatiRecordReader  *reader,
+                               GError             **error)
+{
+  DawatiRecordedDraw draw;
+  GError *read_error = NULL;
+  GArray *draws;
+  guint i;
+
+  draws = g_array_new (FALSE, FALSE, sizeof (DawatiRecordedDraw));
+
+  while (dawati_record_reader_next (reader, &draw, &read_error))
+    g_array_append_val (draws, draw);
+
+  if (read_error)
+    {
+      g_propagate_error (error, read_error);
+      g_array_free (draws, TRUE);
+      return NULL;
+    }
+
+  /* the fill colours have moved with the draws */
+  for (i = 0; i < draws->len; i++)
+    {
+      DawatiRecordedDraw *d = &g_array_index (draws, DawatiRecordedDraw, i);
+
+      if (d->op.fill_colors)
+        d->op.fill_colors = d->fill_colors;
+    }
+
+  return draws;
+}
+
+void
+dawati_record_reader_free (DawatiRecordReader *reader)
+{
+  if (!reader)
+    return;
+
+  g_free (reader->contents);
+  g_free (reader->details);
+  g_hash_table_destroy (reader->params);
+
+  g_slice_free (DawatiRecordReader, reader);
+}
@@ -0,0 +1,64 @@
+/*
+ * dawati-gtk-engine - A GTK+ theme engine for Dawati
+ *
+ * Copyright (c) 2011, Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef _DAWATI_RECORD_H
+#define _DAWATI_RECORD_H
+
+#include <gtk/gtk.h>
+
+#include "dawati-render.h"
+
+G_BEGIN_DECLS
+
+/* Everything the engine hands to the render core can be written to a
+ * compact binary log, set with DAWATI_ENGINE_RECORD, and read back later to
+ * replay or analyse a real session without the application or an X
+ * server. The parameters of each style are written once, the first time
+ * something is drawn with them, and every draw refers to them. */
+
+typedef struct
+{
+  const DawatiRenderParams *params;
+  DawatiRenderOp            op;
+  DawatiColor               fill_colors[5];
+
+  gboolean                  has_area;
+  GdkRectangle              area;
+} DawatiRecordedDraw;
+
+typedef struct _DawatiRecordReader DawatiRecordReader;
+
+gboolean            dawati_record_open            (const gchar              *filename);
+void                dawati_record_op              (const DawatiRenderParams *params,
+                                                   const GdkRectangle       *area,
+                                                   const DawatiRenderOp     *op);
+
+DawatiRecordReader *dawati_record_reader_new      (const gchar              *filename,
+                                                   GError                  **error);
+gboolean            dawati_record_reader_next     (DawatiRecordReader       *reader,
+                                                   DawatiRecordedDraw       *draw,
+                                                   GError                  **error);
+GArray             *dawati_record_reader_read_all (DawatiRecordReader       *reader,
+                                                   GError                  **error);
+void                dawati_record_reader_free     (DawatiRecordReader       *reader);
+
+G_END_DECLS
+
+#endif /* _DAWATI_RECORD_H */
@@ -0,0 +1,2134 @@
+/*
+ * dawati-gtk-engine - A GTK+ theme engine for Dawati
+ *
+ * Copyright (c) 2011, Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "dawati-render.h"
+#include "dawati-cache.h"
+#include "dawati-path-cache.h"
+#include "dawati-role.h"
+
+#include <stdlib.h>
+#include <math.h>
+
+#define DETAIL(id) (op->detail == DAWATI_DETAIL_##id)
+
+#define LINE_WIDTH 1
+
+/* default size of the raster cache in KiB, overridden with
+ * DAWATI_ENGINE_CACHE_SIZE (0 disables the cache) */
+#define RASTER_CACHE_SIZE 2048
+
+/* distance from the edges of a box or shadow within which the outer
+ * shadow, the rounded corners and the button ring are drawn; everything
+ * further in is a straight edge or plain fill */
+#define SLICE_CORNER(params) (MAX ((params)->radius, 0) + 4)
+
+/* flags describing the detail dependent parts of a box */
+enum
+{
+  DAWATI_BOX_BUTTON = 1 << 0,              /* prelight ring for buttons */
+  DAWATI_BOX_GRIP_HORIZONTAL = 1 << 1,
+  DAWATI_BOX_GRIP_VERTICAL = 1 << 2,
+  DAWATI_BOX_LIGHT_SWITCH_TROUGH = 1 << 3,
+
+  DAWATI_SHADOW_FILL_CORNERS = 1 << 4,
+
+  DAWATI_DOT_BG = 1 << 5                   /* bg rather than border colour */
+};
+
+/* what dawati_render_box does for each detail */
+enum
+{
+  BOX_SKIP = 1 << 0,
+  BOX_SKIP_SPINBUTTON_ARROW = 1 << 1,
+  BOX_TROUGH = 1 << 2,
+  BOX_FILL_LEVEL = 1 << 3,
+  BOX_SPINBUTTON = 1 << 4,
+  BOX_BUTTON = 1 << 5,
+  BOX_SCROLLBAR_BUTTON = 1 << 6,
+  BOX_SLIDER = 1 << 7,
+  BOX_GRIP_HORIZONTAL = 1 << 8,
+  BOX_GRIP_VERTICAL = 1 << 9,
+  BOX_LIGHT_SWITCH_TROUGH = 1 << 10
+};
+
+static const guint16 box_details[DAWATI_N_DETAILS] =
+{
+  [DAWATI_DETAIL_PANED] = BOX_SKIP,
+  [DAWATI_DETAIL_BUTTONDEFAULT] = BOX_SKIP,
+  [DAWATI_DETAIL_SPINBUTTON_DOWN] = BOX_SKIP_SPINBUTTON_ARROW,
+  [DAWATI_DETAIL_SPINBUTTON_UP] = BOX_SKIP_SPINBUTTON_ARROW,
+  [DAWATI_DETAIL_SPINBUTTON] = BOX_SPINBUTTON,
+  [DAWATI_DETAIL_BUTTON] = BOX_BUTTON,
+  [DAWATI_DETAIL_TROUGH] = BOX_TROUGH,
+  [DAWATI_DETAIL_TROUGH_FILL_LEVEL] = BOX_TROUGH | BOX_FILL_LEVEL,
+  [DAWATI_DETAIL_TROUGH_FILL_LEVEL_FULL] = BOX_TROUGH | BOX_FILL_LEVEL,
+  [DAWATI_DETAIL_HSCROLLBAR] = BOX_SCROLLBAR_BUTTON,
+  [DAWATI_DETAIL_VSCROLLBAR] = BOX_SCROLLBAR_BUTTON,
+  [DAWATI_DETAIL_SLIDER] = BOX_SLIDER,
+  [DAWATI_DETAIL_LIGHT_SWITCH_HANDLE] = BOX_GRIP_HORIZONTAL,
+  [DAWATI_DETAIL_HSCALE] = BOX_GRIP_HORIZONTAL,
+  [DAWATI_DETAIL_VSCALE] = BOX_GRIP_VERTICAL,
+  [DAWATI_DETAIL_LIGHT_SWITCH_TROUGH] = BOX_LIGHT_SWITCH_TROUGH
+};
+
+enum
+{
+  DAWATI_RASTER_BOX,
+  DAWATI_RASTER_SHADOW,
+
+  /* glyphs, always cached per size */
+  DAWATI_RASTER_CHECK,
+  DAWATI_RASTER_OPTION,
+  DAWATI_RASTER_ARROW,      /* the arrow type in flags */
+  DAWATI_RASTER_EXPANDER,   /* the expander style in flags */
+  DAWATI_RASTER_DOT,
+
+  /* set on entries holding the slices of a nine-slice rendering */
+  DAWATI_RASTER_SLICED = 1 << 7
+};
+
+/* Everything a cached box, shadow or glyph depends on. The colours, radius
+ * and shadow come from the render parameters, identified by their serial. */
+typedef struct
+{
+  guint  serial;
+  guint8 kind;
+  guint8 state_type;
+  guint8 shadow_type;
+  guint8 flags;
+  gint   width;
+  gint   height;
+
+  /* state and width of the corner fill under a shadow, which can differ
+   * from the border for combo box and spin button entries */
+  guint8 fill_state;
+  gint   fill_width;
+} DawatiRasterKey;
+
+/* A cached rendering. Nine-slice renderings are drawn at the smallest size
+ * that holds all four corners plus a one pixel wide row and column in the
+ * middle, which are extracted so they can be stretched to any size. */
+typedef struct
+{
+  cairo_surface_t *surface;
+
+  gint             corner;
+  cairo_surface_t *edges[4];  /* top, bottom, left, right */
+  cairo_surface_t *centre;
+} DawatiRaster;
+
+typedef void (*DawatiPaintFunc) (cairo_t                  *cr,
+                                 const DawatiRenderParams *params,
+                                 const DawatiRasterKey    *key,
+                                 gint                      x,
+                                 gint                      y);
+
+/* the drawing that depends on the radius and shadow of the parameters */
+struct _DawatiRenderFuncs
+{
+  DawatiPaintFunc paint_box;
+  DawatiPaintFunc paint_shadow;
+  void (*paint_shadow_full) (cairo_t                  *cr,
+                             const DawatiRenderParams *params,
+                             const DawatiColor        *fill_colors,
+                             const DawatiRasterKey    *key,
+                             gint                      x,
+                             gint                      y);
+  void (*render_focus)      (cairo_t                  *cr,
+                             const DawatiRenderParams *params,
+                             const DawatiRenderOp     *op);
+};
+
+static const DawatiRenderFuncs *dawati_render_pick_funcs
+  (const DawatiRenderParams *params);
+
+/* parameters that were not passed to dawati_render_params_changed() get
+ * their functions picked on every draw */
+#define DAWATI_RENDER_FUNCS(params) \
+  (G_LIKELY ((params)->funcs) ? (params)->funcs \
+                              : dawati_render_pick_funcs (params))
+
+#ifdef __GNUC__
+#define DAWATI_ALWAYS_INLINE inline __attribute__ ((always_inline))
+#else
+#define DAWATI_ALWAYS_INLINE inline
+#endif
+
+static DawatiCache *raster_cache = NULL;
+static gboolean nine_slice = TRUE;
+
+/* the raster cache is shared by every thread that renders */
+G_LOCK_DEFINE_STATIC (raster_cache);
+
+static void dawati_render_vline (cairo_t                  *cr,
+                                 const DawatiRenderParams *params,
+                                 const DawatiRenderOp     *op);
+
+/* Overdraw measurement: while set, every pass that paints onto
+ * overdraw_target also adds one to the pixels it covers in overdraw_counts,
+ * offset by (overdraw_dx, overdraw_dy). Renderings into cached surfaces
+ * are not counted, only the one pass that puts them on the target. */
+static cairo_surface_t *overdraw_target = NULL;
+static cairo_surface_t *overdraw_counts = NULL;
+static gdouble overdraw_dx = 0;
+static gdouble overdraw_dy = 0;
+
+typedef enum
+{
+  DAWATI_PASS_FILL,
+  DAWATI_PASS_STROKE,
+  DAWATI_PASS_PAINT
+} DawatiPass;
+
+static void
+dawati_overdraw_count (cairo_t    *cr,
+                       DawatiPass  pass)
+{
+  cairo_rectangle_list_t *clip;
+  cairo_pattern_t *source;
+  cairo_surface_t *surface;
+  cairo_matrix_t matrix;
+  cairo_path_t *path;
+  cairo_t *counts;
+  gint i;
+
+  if (cairo_get_target (cr) != overdraw_target)
+    return;
+
+  counts = cairo_create (overdraw_counts);
+  cairo_translate (counts, overdraw_dx, overdraw_dy);
+  cairo_get_matrix (cr, &matrix);
+  cairo_transform (counts, &matrix);
+
+  /* only rectangular clips are copied, anything else counts as unclipped */
+  clip = cairo_copy_clip_rectangle_list (cr);
+  if (clip->status == CAIRO_STATUS_SUCCESS)
+    {
+      for (i = 0; i < clip->num_rectangles; i++)
+        cairo_rectangle (counts, clip->rectangles[i].x, clip->rectangles[i].y,
+                         clip->rectangles[i].width,
+                         clip->rectangles[i].height);
+      cairo_clip (counts);
+    }
+  cairo_rectangle_list_destroy (clip);
+
+  /* one pass adds one to an A8 surface */
+  cairo_set_operator (counts, CAIRO_OPERATOR_ADD);
+  cairo_set_source_rgba (counts, 0, 0, 0, 1.0 / 255.0);
+
+  switch (pass)
+    {
+    case DAWATI_PASS_FILL:
+      path = cairo_copy_path (cr);
+      cairo_append_path (counts, path);
+      cairo_path_destroy (path);
+      cairo_set_fill_rule (counts, cairo_get_fill_rule (cr));
+      cairo_fill (counts);
+      break;
+
+    case DAWATI_PASS_STROKE:
+      path = cairo_copy_path (cr);
+      cairo_append_path (counts, path);
+      cairo_path_destroy (path);
+      cairo_set_line_width (counts, cairo_get_line_width (cr));
+      cairo_set_line_cap (counts, cairo_get_line_cap (cr));
+      cairo_set_line_join (counts, cairo_get_line_join (cr));
+      cairo_stroke (counts);
+      break;
+
+    case DAWATI_PASS_PAINT:
+      /* an unextended surface only covers its own extents */
+      source = cairo_get_source (cr);
+      if (cairo_pattern_get_type (source) == CAIRO_PATTERN_TYPE_SURFACE
+          && cairo_pattern_get_extend (source) == CAIRO_EXTEND_NONE
+          && cairo_pattern_get_surface (source, &surface) == CAIRO_STATUS_SUCCESS
+          && cairo_surface_get_type (surface) == CAIRO_SURFACE_TYPE_IMAGE)
+        {
+          cairo_pattern_get_matrix (source, &matrix);
+          if (cairo_matrix_invert (&matrix) == CAIRO_STATUS_SUCCESS)
+            {
+              cairo_transform (counts, &matrix);
+              cairo_rectangle (counts, 0, 0,
+                               cairo_image_surface_get_width (surface),
+                               cairo_image_surface_get_height (surface));
+              cairo_fill (counts);
+            }
+        }
+      else
+        {
+          cairo_paint (counts);
+        }
+      break;
+    }
+
+  cairo_destroy (counts);
+}
+
+static inline void
+dawati_fill (cairo_t *cr)
+{
+  if (G_UNLIKELY (overdraw_counts))
+    dawati_overdraw_count (cr, DAWATI_PASS_FILL);
+  cairo_fill (cr);
+}
+
+static inline void
+dawati_fill_preserve (cairo_t *cr)
+{
+  if (G_UNLIKELY (overdraw_counts))
+    dawati_overdraw_count (cr, DAWATI_PASS_FILL);
+  cairo_fill_preserve (cr);
+}
+
+static inline void
+dawati_stroke (cairo_t *cr)
+{
+  if (G_UNLIKELY (overdraw_counts))
+    dawati_overdraw_count (cr, DAWATI_PASS_STROKE);
+  cairo_stroke (cr);
+}
+
+static inline void
+dawati_stroke_preserve (cairo_t *cr)
+{
+  if (G_UNLIKELY (overdraw_counts))
+    dawati_overdraw_count (cr, DAWATI_PASS_STROKE);
+  cairo_stroke_preserve (cr);
+}
+
+static inline void
+dawati_paint (cairo_t *cr)
+{
+  if (G_UNLIKELY (overdraw_counts))
+    dawati_overdraw_count (cr, DAWATI_PASS_PAINT);
+  cairo_paint (cr);
+}
+
+static guint
+dawati_raster_key_hash (gconstpointer key)
+{
+  const DawatiRasterKey *k = key;
+
+  return (k->serial * 31 + ((k->kind << 24) | (k->state_type << 16)
+                            | (k->shadow_type << 8) | k->flags))
+    ^ (k->width << 16) ^ k->height ^ (k->fill_state << 28) ^ k->fill_width;
+}
+
+static gboolean
+dawati_raster_key_equal (gconstpointer a,
+                         gconstpointer b)
+{
+  const DawatiRasterKey *ka = a;
+  const DawatiRasterKey *kb = b;
+
+  return ka->serial == kb->serial
+    && ka->kind == kb->kind
+    && ka->state_type == kb->state_type
+    && ka->shadow_type == kb->shadow_type
+    && ka->flags == kb->flags
+    && ka->width == kb->width
+    && ka->height == kb->height
+    && ka->fill_state == kb->fill_state
+    && ka->fill_width == kb->fill_width;
+}
+
+static void
+dawati_raster_key_free (gpointer key)
+{
+  g_slice_free (DawatiRasterKey, key);
+}
+
+static gboolean
+dawati_raster_key_has_serial (gpointer key,
+                              gpointer value,
+                              gpointer serial)
+{
+  return ((DawatiRasterKey *) key)->serial == GPOINTER_TO_UINT (serial);
+}
+
+static void
+dawati_raster_free (gpointer data)
+{
+  DawatiRaster *raster = data;
+  gint i;
+
+  cairo_surface_destroy (raster->surface);
+
+  if (raster->corner)
+    {
+      for (i = 0; i < 4; i++)
+        cairo_surface_destroy (raster->edges[i]);
+      cairo_surface_destroy (raster->centre);
+    }
+
+  g_slice_free (DawatiRaster, raster);
+}
+
+static gpointer
+dawati_raster_cache_init (gpointer data)
+{
+  const gchar *env;
+  gsize size = RASTER_CACHE_SIZE;
+
+  /* in KiB, 0 turns the cache off */
+  env = getenv ("DAWATI_ENGINE_CACHE_SIZE");
+  if (env)
+    {
+      gchar *end;
+      guint64 value;
+
+      value = g_ascii_strtoull (env, &end, 10);
+      if (g_ascii_isdigit (*env) && *end == '\0'
+          && value <= G_MAXSIZE / 1024)
+        size = value;
+      else
+        g_warning ("Ignoring invalid DAWATI_ENGINE_CACHE_SIZE '%s', "
+                   "using %d KiB", env, RASTER_CACHE_SIZE);
+    }
+
+  env = getenv ("DAWATI_ENGINE_NINE_SLICE");
+  if (env)
+    nine_slice = atoi (env);
+
+  if (size == 0)
+    return NULL;
+
+  raster_cache = dawati_cache_new (dawati_raster_key_hash,
+                                   dawati_raster_key_equal,
+                                   dawati_raster_key_free,
+                                   dawati_raster_free,
+                                   size * 1024);
+
+  return NULL;
+}
+
+static void
+dawati_raster_cache_ensure (void)
+{
+  static GOnce once = G_ONCE_INIT;
+
+  g_once (&once, dawati_raster_cache_init, NULL);
+}
+
+/* Counts the passes over each pixel of target in counts, an A8 surface,
+ * with (dx, dy) added to the position on target; NULL stops counting.
+ * Only for the thread that renders. */
+void
+dawati_render_set_overdraw (cairo_surface_t *target,
+                            cairo_surface_t *counts,
+                            gdouble          dx,
+                            gdouble          dy)
+{
+  overdraw_target = target;
+  overdraw_counts = counts;
+  overdraw_dx = dx;
+  overdraw_dy = dy;
+}
+
+guint
+dawati_render_new_serial (void)
+{
+  static volatile gint last_serial = 0;
+
+#if GLIB_CHECK_VERSION (2, 30, 0)
+  return g_atomic_int_add (&last_serial, 1) + 1;
+#else
+  return g_atomic_int_exchange_and_add (&last_serial, 1) + 1;
+#endif
+}
+
+/* To be called once the parameters are filled in, and every time they
+ * change: drops what was cached for their old values, gives them a new
+ * serial and picks the drawing functions for their radius and shadow. */
+void
+dawati_render_params_changed (DawatiRenderParams *params)
+{
+  dawati_render_forget (params->serial);
+  params->serial = dawati_render_new_serial ();
+  params->funcs = dawati_render_pick_funcs (params);
+}
+
+/* drop everything cached for a set of parameters */
+void
+dawati_render_forget (guint serial)
+{
+  if (!serial || !raster_cache)
+    return;
+
+  G_LOCK (raster_cache);
+  dawati_cache_remove_matching (raster_cache, dawati_raster_key_has_serial,
+                                GUINT_TO_POINTER (serial));
+  G_UNLOCK (raster_cache);
+}
+
+void
+dawati_render_print_stats (void)
+{
+  DawatiCacheStats stats;
+
+  dawati_path_cache_print_stats ();
+
+  if (!raster_cache)
+    return;
+
+  dawati_cache_get_stats (raster_cache, &stats);
+
+  g_printerr ("raster cache: hits = %u; misses = %u; evictions = %u; "
+              "entries = %u; bytes = %lu/%lu;\n",
+              stats.hits, stats.misses, stats.evictions, stats.n_entries,
+              (gulong) stats.cost, (gulong) stats.max_cost);
+}
+
+static inline void
+dawati_set_source_color (cairo_t           *cr,
+                         const DawatiColor *color)
+{
+  cairo_set_source_rgb (cr, color->red, color->green, color->blue);
+}
+
+static cairo_surface_t *
+dawati_render_raster (const DawatiRenderParams *params,
+                      const DawatiRasterKey    *key,
+                      DawatiPaintFunc           paint)
+{
+  cairo_surface_t *surface;
+  cairo_t *cr;
+
+  surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
+                                        key->width, key->height);
+  cr = cairo_create (surface);
+  paint (cr, params, key, 0, 0);
+  cairo_destroy (cr);
+
+  return surface;
+}
+
+/* copy part of an image surface into a new surface */
+static cairo_surface_t *
+dawati_surface_extract (cairo_surface_t *surface,
+                        gint             x,
+                        gint             y,
+                        gint             width,
+                        gint             height)
+{
+  cairo_surface_t *part;
+  cairo_t *cr;
+
+  part = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, width, height);
+  cr = cairo_create (part);
+  cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
+  cairo_set_source_surface (cr, surface, -x, -y);
+  dawati_paint (cr);
+  cairo_destroy (cr);
+
+  return part;
+}
+
+/* fill a rectangle with a surface placed at (sx, sy), repeating its outer
+ * pixels to cover the rectangle */
+static void
+dawati_paint_region (cairo_t         *cr,
+                     cairo_surface_t *surface,
+                     gint             sx,
+                     gint             sy,
+                     gint             x,
+                     gint             y,
+                     gint             width,
+                     gint             height)
+{
+  cairo_pattern_t *pattern;
+  cairo_matrix_t matrix;
+
+  if (width <= 0 || height <= 0)
+    return;
+
+  pattern = cairo_pattern_create_for_surface (surface);
+  cairo_pattern_set_extend (pattern, CAIRO_EXTEND_PAD);
+  cairo_pattern_set_filter (pattern, CAIRO_FILTER_NEAREST);
+  cairo_matrix_init_translate (&matrix, -sx, -sy);
+  cairo_pattern_set_matrix (pattern, &matrix);
+
+  cairo_set_source (cr, pattern);
+  cairo_rectangle (cr, x, y, width, height);
+  dawati_fill (cr);
+
+  cairo_pattern_destroy (pattern);
+}
+
+static DawatiRaster *
+dawati_raster_new_sliced (cairo_surface_t *surface,
+                          gint             corner)
+{
+  DawatiRaster *raster;
+
+  raster = g_slice_new0 (DawatiRaster);
+  raster->surface = surface;
+  raster->corner = corner;
+
+  raster->edges[0] = dawati_surface_extract (surface, corner, 0, 1, corner);
+  raster->edges[1] = dawati_surface_extract (surface, corner, corner + 1,
+                                             1, corner);
+  raster->edges[2] = dawati_surface_extract (surface, 0, corner, corner, 1);
+  raster->edges[3] = dawati_surface_extract (surface, corner + 1, corner,
+                                             corner, 1);
+  raster->centre = dawati_surface_extract (surface, corner, corner, 1, 1);
+
+  return raster;
+}
+
+static void
+dawati_raster_paint_sliced (cairo_t      *cr,
+                            DawatiRaster *raster,
+                            gint          x,
+                            gint          y,
+                            gint          width,
+                            gint          height)
+{
+  gint c = raster->corner;
+  gint size = c * 2 + 1;
+  gint inner_width = width - c * 2;
+  gint inner_height = height - c * 2;
+
+  /* corners */
+  dawati_paint_region (cr, raster->surface, x, y, x, y, c, c);
+  dawati_paint_region (cr, raster->surface, x + width - size, y,
+                       x + width - c, y, c, c);
+  dawati_paint_region (cr, raster->surface, x, y + height - size,
+                       x, y + height - c, c, c);
+  dawati_paint_region (cr, raster->surface, x + width - size,
+                       y + height - size, x + width - c, y + height - c, c, c);
+
+  /* edges */
+  dawati_paint_region (cr, raster->edges[0], x + c, y,
+                       x + c, y, inner_width, c);
+  dawati_paint_region (cr, raster->edges[1], x + c, y + height - c,
+                       x + c, y + height - c, inner_width, c);
+  dawati_paint_region (cr, raster->edges[2], x, y + c,
+                       x, y + c, c, inner_height);
+  dawati_paint_region (cr, raster->edges[3], x + width - c, y + c,
+                       x + width - c, y + c, c, inner_height);
+
+  /* centre */
+  dawati_paint_region (cr, raster->centre, x + c, y + c,
+                       x + c, y + c, inner_width, inner_height);
+}
+
+/* Paint using a copy rendered earlier if there is one, otherwise render
+ * into a new surface and keep it for next time.
+ *
+ * If corner is non-zero the rendering only has detail within that distance
+ * of its edges, so it is assembled from nine slices that are shared by all
+ * sizes. Otherwise a copy is kept per size, and large surfaces are painted
+ * directly so they cannot flush the whole cache. */
+static void
+dawati_paint_cached (cairo_t                  *cr,
+                     const DawatiRenderParams *params,
+                     DawatiRasterKey          *key,
+                     gint                      x,
+                     gint                      y,
+                     gint                      corner,
+                     DawatiPaintFunc           paint)
+{
+  DawatiRaster *raster;
+  gsize cost;
+
+  dawati_raster_cache_ensure ();
+
+  if (!raster_cache || !params->serial || key->width <= 0 || key->height <= 0)
+    {
+      paint (cr, params, key, x, y);
+      return;
+    }
+
+  key->serial = params->serial;
+
+  if (nine_slice && corner > 0
+      && key->width > corner * 2 && key->height > corner * 2)
+    {
+      DawatiRasterKey slice_key = *key;
+
+      slice_key.kind |= DAWATI_RASTER_SLICED;
+      slice_key.width = corner * 2 + 1;
+      slice_key.height = corner * 2 + 1;
+      if (slice_key.flags & DAWATI_SHADOW_FILL_CORNERS)
+        slice_key.fill_width = slice_key.width;
+
+      G_LOCK (raster_cache);
+      raster = dawati_cache_lookup (raster_cache, &slice_key);
+      if (raster)
+        dawati_raster_paint_sliced (cr, raster, x, y,
+                                    key->width, key->height);
+      G_UNLOCK (raster_cache);
+
+      if (raster)
+        return;
+
+      raster = dawati_raster_new_sliced (dawati_render_raster (params,
+                                                               &slice_key,
+                                                               paint),
+                                         corner);
+      dawati_raster_paint_sliced (cr, raster, x, y, key->width, key->height);
+
+      G_LOCK (raster_cache);
+      dawati_cache_insert (raster_cache,
+                           g_slice_dup (DawatiRasterKey, &slice_key),
+                           raster,
+                           (slice_key.width * slice_key.height
+                            + corner * 4 + 1) * 4);
+      G_UNLOCK (raster_cache);
+      return;
+    }
+
+  cost = (gsize) key->width * key->height * 4;
+  if (cost > dawati_cache_get_max_cost (raster_cache) / 8)
+    {
+      paint (cr, params, key, x, y);
+      return;
+    }
+
+  G_LOCK (raster_cache);
+  raster = dawati_cache_lookup (raster_cache, key);
+  if (raster)
+    {
+      cairo_set_source_surface (cr, raster->surface, x, y);
+      dawati_paint (cr);
+    }
+  G_UNLOCK (raster_cache);
+
+  if (raster)
+    return;
+
+  raster = g_slice_new0 (DawatiRaster);
+  raster->surface = dawati_render_raster (params, key, paint);
+
+  cairo_set_source_surface (cr, raster->surface, x, y);
+  dawati_paint (cr);
+
+  G_LOCK (raster_cache);
+  dawati_cache_insert (raster_cache, g_slice_dup (DawatiRasterKey, key),
+                       raster, cost);
+  G_UNLOCK (raster_cache);
+}
+
+/* Paint the same small rendering at each of n positions, looking it up
+ * once. */
+static void
+dawati_paint_stamps (cairo_t                  *cr,
+                     const DawatiRenderParams *params,
+                     DawatiRasterKey          *key,
+                     const gint              (*positions)[2],
+                     guint                     n,
+                     DawatiPaintFunc           paint)
+{
+  DawatiRaster *raster;
+  guint i;
+
+  dawati_raster_cache_ensure ();
+
+  if (!raster_cache || !params->serial || key->width <= 0 || key->height <= 0)
+    {
+      for (i = 0; i < n; i++)
+        paint (cr, params, key, positions[i][0], positions[i][1]);
+      return;
+    }
+
+  key->serial = params->serial;
+
+  G_LOCK (raster_cache);
+  raster = dawati_cache_lookup (raster_cache, key);
+  if (raster)
+    {
+      for (i = 0; i < n; i++)
+        {
+          cairo_set_source_surface (cr, raster->surface,
+                                    positions[i][0], positions[i][1]);
+          dawati_paint (cr);
+        }
+    }
+  G_UNLOCK (raster_cache);
+
+  if (raster)
+    return;
+
+  raster = g_slice_new0 (DawatiRaster);
+  raster->surface = dawati_render_raster (params, key, paint);
+
+  for (i = 0; i < n; i++)
+    {
+      cairo_set_source_surface (cr, raster->surface,
+                                positions[i][0], positions[i][1]);
+      dawati_paint (cr);
+    }
+
+  G_LOCK (raster_cache);
+  dawati_cache_insert (raster_cache, g_slice_dup (DawatiRasterKey, key),
+                       raster, (gsize) key->width * key->height * 4);
+  G_UNLOCK (raster_cache);
+}
+
+/* params: width, height, radius */
+static void
+dawati_build_rounded_rectangle (cairo_t       *cr,
+                                const gdouble *params)
+{
+  gdouble width = params[0];
+  gdouble height = params[1];
+  gdouble radius = params[2];
+
+  cairo_move_to (cr, 0, height - radius);
+  cairo_arc (cr, radius, radius, radius, M_PI, M_PI * 1.5);
+  cairo_arc (cr, width - radius, radius, radius, M_PI * 1.5, 0);
+  cairo_arc (cr, width - radius, height - radius, radius, 0, M_PI * 0.5);
+  cairo_arc (cr, radius, height - radius, radius, M_PI * 0.5, M_PI);
+}
+
+/* params: gap side, width, height, radius, whether the tab is in the
+ * normal state */
+static void
+dawati_build_tab (cairo_t       *cr,
+                  const gdouble *params)
+{
+  GtkPositionType gap_side = params[0];
+  gdouble width = params[1];
+  gdouble height = params[2];
+  gdouble radius = params[3];
+  gboolean normal = params[4];
+
+  switch (gap_side)
+    {
+    case GTK_POS_TOP:     /* bottom tab */
+      cairo_move_to (cr, 0, 0);
+      cairo_arc_negative (cr, radius, height - radius, radius, M_PI,
+                          M_PI * 0.5);
+      cairo_arc_negative (cr, width - radius, height - radius, radius,
+                          M_PI * 0.5, 0);
+      cairo_line_to (cr, width, 0);
+      break;
+    case GTK_POS_BOTTOM: /* top tab */
+      if (normal)
+        cairo_arc_negative (cr, 0, height - radius, radius, M_PI / 2.0, 0);
+      else
+        cairo_move_to (cr, radius, height);
+      cairo_arc (cr, radius * 2, radius, radius, M_PI, M_PI * 1.5);
+      cairo_arc (cr, width - radius * 2, radius, radius, M_PI * 1.5, 0);
+      if (normal)
+        cairo_arc_negative (cr, width, height - radius, radius, M_PI, M_PI / 2.0);
+      else
+        cairo_line_to (cr, width - radius, height);
+      break;
+    case GTK_POS_LEFT:  /* right tab */
+      cairo_move_to (cr, 0, 0);
+      cairo_arc (cr, width - radius, radius, radius, M_PI * 1.5, 0);
+      cairo_arc (cr, width - radius, height - radius, radius, 0,
+                 M_PI * 0.5);
+      cairo_line_to (cr, 0, height);
+      break;
+    case GTK_POS_RIGHT: /* left tab */
+      cairo_move_to (cr, width, 0);
+      cairo_arc_negative (cr, radius, radius, radius, M_PI * 1.5, M_PI);
+      cairo_arc_negative (cr, radius, height - radius, radius, M_PI,
+                          M_PI * 0.5);
+      cairo_line_to (cr, width, height);
+      break;
+    }
+}
+
+/* params: width, height; the tick was drawn for a 15x15 box */
+static void
+dawati_build_tick (cairo_t       *cr,
+                   const gdouble *params)
+{
+  gdouble sx = params[0] / 15.0;
+  gdouble sy = params[1] / 15.0;
+
+  cairo_move_to (cr, 3 * sx, 6 * sy);
+  cairo_line_to (cr, 6 * sx, 9 * sy);
+  cairo_line_to (cr, 12 * sx, 3 * sy);
+  cairo_line_to (cr, 12 * sx, 6 * sy);
+  cairo_line_to (cr, 6 * sx, 12 * sy);
+  cairo_line_to (cr, 3 * sx, 9 * sy);
+  cairo_line_to (cr, 3 * sx, 6 * sy);
+}
+
+/* params: arrow type, width, height */
+static void
+dawati_build_arrow (cairo_t       *cr,
+                    const gdouble *params)
+{
+  GtkArrowType arrow_type = params[0];
+  gint width = params[1];
+  gint height = params[2];
+
+  switch (arrow_type)
+    {
+    case GTK_ARROW_UP:
+      cairo_move_to (cr, 0, height);
+      cairo_line_to (cr, width / 2, 0);
+      cairo_line_to (cr, width, height);
+      break;
+    case GTK_ARROW_DOWN:
+      cairo_move_to (cr, 0, 0);
+      cairo_line_to (cr, width / 2, height);
+      cairo_line_to (cr, width, 0);
+      break;
+    case GTK_ARROW_LEFT:
+      cairo_move_to (cr, width, 0);
+      cairo_line_to (cr, 0, height / 2);
+      cairo_line_to (cr, width, height);
+      break;
+    case GTK_ARROW_RIGHT:
+      cairo_move_to (cr, 0, 0);
+      cairo_line_to (cr, width, height / 2);
+      cairo_line_to (cr, 0, height);
+      break;
+    case GTK_ARROW_NONE:
+      break;
+    }
+}
+
+/* radius must not be 0 */
+static void
+dawati_rounded_rectangle_path (cairo_t *cr,
+                               gdouble  x,
+                               gdouble  y,
+                               gdouble  width,
+                               gdouble  height,
+                               gdouble  radius)
+{
+  if (width < radius * 2)
+    {
+      radius = width / 2;
+    }
+  else if (height < radius * 2)
+    {
+      radius = height / 2;
+    }
+
+  {
+    const gdouble params[DAWATI_PATH_N_PARAMS] = { width, height, radius, };
+
+    dawati_path_cache_append (cr, x, y, DAWATI_PATH_ROUNDED_RECTANGLE, params,
+                              dawati_build_rounded_rectangle);
+  }
+}
+
+static void
+dawati_rounded_rectangle (cairo_t *cr,
+                          gdouble  x,
+                          gdouble  y,
+                          gdouble  width,
+                          gdouble  height,
+                          gdouble  radius)
+{
+  if (width < 1 || height < 1)
+    return;
+
+  if (radius == 0)
+    cairo_rectangle (cr, x, y, width, height);
+  else
+    dawati_rounded_rectangle_path (cr, x, y, width, height, radius);
+}
+
+/* The same as dawati_rounded_rectangle() with the radius of the style,
+ * which the caller knows to be 0 unless rounded is set. */
+static DAWATI_ALWAYS_INLINE void
+dawati_style_rectangle (cairo_t  *cr,
+                        gboolean  rounded,
+                        gdouble   x,
+                        gdouble   y,
+                        gdouble   width,
+                        gdouble   height,
+                        gdouble   radius)
+{
+  if (width < 1 || height < 1)
+    return;
+
+  if (rounded)
+    dawati_rounded_rectangle_path (cr, x, y, width, height, radius);
+  else
+    cairo_rectangle (cr, x, y, width, height);
+}
+
+static void
+dawati_draw_grip (cairo_t *cr,
+                  gboolean vertical,
+                  gdouble  x,
+                  gdouble  y,
+                  gdouble  width,
+                  gdouble  height)
+{
+  gdouble cx, cy;
+  gint n_strips = 3;
+  gint strip_w = 3;
+  gint strip_h = 8 - strip_w;
+  gint strip_padding = 2;
+  gint grip_w = (n_strips * strip_w) + ((n_strips - 1) * strip_padding);
+  gint i;
+
+  cairo_save (cr);
+
+  cairo_set_line_width (cr, strip_w);
+  cairo_set_line_cap (cr, CAIRO_LINE_CAP_ROUND);
+
+  if (!vertical)
+    {
+      cx = x + (width / 2.0) - grip_w / 2.0 + strip_w / 2.0;
+      cy = y + (height / 2.0) - (strip_h / 2.0);
+
+      for (i = 0; i < n_strips; i++)
+        {
+          gdouble position;
+
+          position = cx + (i * (strip_w + strip_padding));
+
+          cairo_move_to (cr, position, cy);
+          cairo_line_to (cr, position, cy + strip_h);
+
+          dawati_stroke (cr);
+        }
+    }
+  else
+    {
+      cy = y + (height / 2.0) - grip_w / 2.0 + strip_w / 2.0;
+      cx = x + (width / 2.0) - (strip_h / 2.0);
+
+      for (i = 0; i < n_strips; i++)
+        {
+          gdouble position;
+
+          position = cy + (i * (strip_w + strip_padding));
+
+          cairo_move_to (cr, cx, position);
+          cairo_line_to (cr, cx + strip_h, position);
+
+          dawati_stroke (cr);
+        }
+    }
+
+  cairo_restore (cr);
+}
+
+/* Box, shadow and focus painting for each combination of a zero or
+ * non-zero radius and shadow, so that the draws for the many square or
+ * shadowless styles don't test for them over and over. The variants are
+ * made by DAWATI_DEFINE_RENDER_FUNCS from the functions below, with rounded
+ * and shadowed constant. */
+static DAWATI_ALWAYS_INLINE void
+dawati_paint_box_variant (cairo_t                  *cr,
+                          const DawatiRenderParams *params,
+                          const DawatiRasterKey    *key,
+                          gint                      x,
+                          gint                      y,
+                          gboolean                  rounded,
+                          gboolean                  shadowed)
+{
+  gint radius = params->radius;
+  GtkStateType state_type = key->state_type;
+  gint width = key->width;
+  gint height = key->height;
+
+  cairo_set_line_width (cr, LINE_WIDTH);
+
+  if (shadowed)
+    {
+      if (key->shadow_type == GTK_SHADOW_OUT)
+        {
+          /* outer shadow */
+          dawati_rounded_rectangle (cr, x, y, width, height,
+                                    radius + 1);
+          cairo_set_source_rgba (cr, 0, 0, 0, params->shadow);
+          dawati_fill (cr);
+
+          /* reduce size for outer shadow */
+          height--;
+          width--;
+        }
+      else if (key->shadow_type == GTK_SHADOW_IN)
+        {
+          x++;
+          y++;
+          width--;
+          height--;
+        }
+    }
+
+
+  /* fill */
+  dawati_style_rectangle (cr, rounded, x, y, width, height, radius);
+
+  if (key->flags & DAWATI_BOX_LIGHT_SWITCH_TROUGH)
+    {
+      cairo_pattern_t *crp;
+
+      crp = cairo_pattern_create_linear (x, y, x, height);
+
+      /* FIXME: these colours really should not be defined here */
+
+      if (state_type == GTK_STATE_SELECTED)
+        {
+          cairo_pattern_add_color_stop_rgb (crp, 0, 0.365, 0.820, 0.953);
+          cairo_pattern_add_color_stop_rgb (crp, 1, 0.627, 0.894, 0.973);
+        }
+      else
+        {
+          cairo_pattern_add_color_stop_rgb (crp, 0, 0.937, 0.941, 0.929);
+          cairo_pattern_add_color_stop_rgb (crp, 1, 1.0, 1.0, 1.0);
+        }
+
+      cairo_set_source (cr, crp);
+      cairo_pattern_destroy (crp);
+    }
+  else
+    dawati_set_source_color (cr, &params->bg[state_type]);
+
+  dawati_fill (cr);
+
+  /* extra hilight for "button" widgets, also used as focus rectangle since
+   * state_type is set to prelight for focused widgets */
+  if (state_type == GTK_STATE_PRELIGHT && (key->flags & DAWATI_BOX_BUTTON))
+    {
+      cairo_set_line_width (cr, 2.0);
+      dawati_rounded_rectangle (cr, x + 2, y + 2, width - 4,
+                                height - 4, radius - 1);
+      dawati_set_source_color (cr, &params->bg[GTK_STATE_SELECTED]);
+      dawati_stroke (cr);
+      cairo_set_line_width (cr, 1.0);
+    }
+
+  if (key->shadow_type != GTK_SHADOW_NONE)
+    {
+      /* border */
+      dawati_style_rectangle (cr, rounded, x + 0.5, y + 0.5,
+                              width - 1, height - 1, radius);
+      dawati_set_source_color (cr, &params->border[state_type]);
+      dawati_stroke (cr);
+    }
+
+  /* add a grip to handles */
+  if (key->flags & DAWATI_BOX_GRIP_HORIZONTAL)
+    {
+      dawati_set_source_color (cr, &params->mid[state_type]);
+      dawati_draw_grip (cr, FALSE, x, y, width, height);
+    }
+  else if (key->flags & DAWATI_BOX_GRIP_VERTICAL)
+    {
+      dawati_set_source_color (cr, &params->mid[state_type]);
+      dawati_draw_grip (cr, TRUE, x, y, width, height);
+    }
+}
+
+static void
+dawati_render_box (cairo_t                  *cr,
+                   const DawatiRenderParams *params,
+                   const DawatiRenderOp     *op)
+{
+  const DawatiRenderFuncs *funcs = DAWATI_RENDER_FUNCS (params);
+  DawatiRasterKey key = { 0, };
+  guint box = box_details[op->detail];
+  guint role = op->role;
+  GtkStateType state_type = op->state;
+  GtkShadowType shadow_type = op->shadow;
+  gint x = op->x;
+  gint y = op->y;
+  gint width = op->width;
+  gint height = op->height;
+
+  if (box & BOX_SKIP)
+    return;
+
+  /* scrollbar troughs are a plain rectangle, their fill levels go on to
+   * the "fill" indicator below */
+  if ((role & DAWATI_ROLE_SCROLLBAR) && DETAIL (TROUGH))
+    {
+      cairo_rectangle (cr, x, y, width, height);
+      dawati_set_source_color (cr, &params->base[state_type]);
+      dawati_fill (cr);
+      return;
+    }
+
+  /*** treeview headers ***/
+  if (role & DAWATI_ROLE_PARENT_TREE_VIEW)
+    {
+      DawatiRenderOp line = *op;
+
+      cairo_rectangle (cr, x, y, width, height);
+      dawati_set_source_color (cr, &params->bg[state_type]);
+      dawati_fill (cr);
+
+      line.element = DAWATI_ELEMENT_VLINE;
+      line.x = x + width - 1;
+      line.y = y + 5;
+      line.height = height - 10;
+      dawati_render_vline (cr, params, &line);
+      return;
+    }
+
+  /*** spin buttons ***/
+  if (box & BOX_SKIP_SPINBUTTON_ARROW)
+    return;
+
+  if (box & BOX_SPINBUTTON)
+    {
+      /* FIXME: for RTL */
+      width += 10;
+      x -= 10;
+
+      /* always draw button as shadow out to match the entry */
+      shadow_type = GTK_SHADOW_OUT;
+
+      /* draw the buttons with the same state type as the entry */
+      state_type = op->widget_state;
+    }
+
+  /*** combo boxes ***/
+  if ((box & BOX_BUTTON) && (role & DAWATI_ROLE_PARENT_COMBO_BOX_ENTRY))
+    {
+      /* always draw combo box entry buttons as shadow out to match the entry */
+      shadow_type = GTK_SHADOW_OUT;
+
+      /* FIXME: RTL */
+      width += 10;
+      x -= 10;
+    }
+
+  if ((box & BOX_TROUGH) && (role & DAWATI_ROLE_SCALE))
+    {
+      if (params->shadow)
+        {
+          width--;
+          height--;
+        }
+      if (width > height)
+        {
+          y = y + (height / 2.0 - 2);
+          height = 4;
+        }
+      else
+        {
+          x = x + (width / 2.0 - 2);
+          width = 4;
+        }
+    }
+
+
+  /* scrollbar buttons */
+  if (box & BOX_SCROLLBAR_BUTTON)
+    {
+      x += 2;
+      y += 2;
+      width -= 4;
+      height -= 4;
+    }
+
+  /* scrollbar slider */
+  if (box & BOX_SLIDER)
+    {
+      if (role & DAWATI_ROLE_HSCROLLBAR)
+        {
+          y += 2;
+          height -= 4;
+        }
+      else
+        {
+          x += 2;
+          width -= 4;
+        }
+    }
+
+  cairo_set_line_width (cr, LINE_WIDTH);
+
+
+  /* special "fill" indicator */
+  if (box & BOX_FILL_LEVEL)
+    {
+      dawati_set_source_color (cr, &params->base[GTK_STATE_SELECTED]);
+
+      if (width > height)
+        cairo_rectangle (cr, x, y + 1, width, height - 2);
+      else
+        cairo_rectangle (cr, x + 1, y, width - 2, height);
+
+      dawati_fill (cr);
+      return;
+    }
+
+  key.kind = DAWATI_RASTER_BOX;
+  key.state_type = state_type;
+  key.shadow_type = shadow_type;
+  key.width = width;
+  key.height = height;
+
+  if ((box & BOX_BUTTON) && !(role & DAWATI_ROLE_PARENT_COMBO_BOX_ENTRY))
+    key.flags |= DAWATI_BOX_BUTTON;
+
+  if (box & BOX_GRIP_HORIZONTAL)
+    key.flags |= DAWATI_BOX_GRIP_HORIZONTAL;
+  else if (box & BOX_GRIP_VERTICAL)
+    key.flags |= DAWATI_BOX_GRIP_VERTICAL;
+
+  /* the trough gradient is not relative to the box, so it cannot be cached */
+  if (box & BOX_LIGHT_SWITCH_TROUGH)
+    {
+      key.flags |= DAWATI_BOX_LIGHT_SWITCH_TROUGH;
+      funcs->paint_box (cr, params, &key, x, y);
+    }
+  else if (key.flags & (DAWATI_BOX_GRIP_HORIZONTAL | DAWATI_BOX_GRIP_VERTICAL))
+    dawati_paint_cached (cr, params, &key, x, y, 0, funcs->paint_box);
+  else
+    dawati_paint_cached (cr, params, &key, x, y, SLICE_CORNER (params),
+                         funcs->paint_box);
+}
+
+static DAWATI_ALWAYS_INLINE void
+dawati_paint_shadow_variant (cairo_t                  *cr,
+                             const DawatiRenderParams *params,
+                             const DawatiColor        *fill_colors,
+                             const DawatiRasterKey    *key,
+                             gint                      x,
+                             gint                      y,
+                             gboolean                  rounded,
+                             gboolean                  shadowed)
+{
+  gdouble radius = params->radius;
+  gint width = key->width;
+  gint height = key->height;
+
+  /* initilise the background in the corners to the colour of the widget */
+  if (key->flags & DAWATI_SHADOW_FILL_CORNERS)
+    {
+      cairo_rectangle (cr, x, y, key->fill_width, height);
+      if (shadowed)
+        dawati_style_rectangle (cr, rounded, x, y, key->fill_width - 1,
+                                height - 1, radius);
+      else
+        dawati_style_rectangle (cr, rounded, x, y, key->fill_width, height,
+                                radius);
+
+      dawati_set_source_color (cr, &fill_colors[key->fill_state]);
+      cairo_set_fill_rule (cr, CAIRO_FILL_RULE_EVEN_ODD);
+      dawati_fill (cr);
+    }
+
+  cairo_translate (cr, 0.5, 0.5);
+  width--;
+  height--;
+
+  cairo_set_line_width (cr, 1.0);
+  if (shadowed)
+    {
+      /* outer shadow */
+      dawati_rounded_rectangle (cr, x, y, width, height,
+                                radius + 1.0);
+      cairo_set_source_rgba (cr, 0, 0, 0, params->shadow);
+      dawati_stroke (cr);
+
+
+      /* reduce size for outer shadow */
+      height--;
+      width--;
+    }
+
+  /* border */
+  dawati_style_rectangle (cr, rounded, x, y, width, height, radius);
+  dawati_set_source_color (cr, &params->border[key->state_type]);
+  dawati_stroke (cr);
+
+  cairo_translate (cr, -0.5, -0.5);
+}
+
+static void
+dawati_render_shadow (cairo_t                  *cr,
+                      const DawatiRenderParams *params,
+                      const DawatiRenderOp     *op)
+{
+  const DawatiRenderFuncs *funcs = DAWATI_RENDER_FUNCS (params);
+  DawatiRasterKey key = { 0, };
+  gint width = op->width;
+
+  if (op->shadow == GTK_SHADOW_NONE)
+    return;
+
+  key.kind = DAWATI_RASTER_SHADOW;
+  key.shadow_type = op->shadow;
+
+  if (op->fill_corners)
+    {
+      key.flags |= DAWATI_SHADOW_FILL_CORNERS;
+      key.fill_state = op->fill_state;
+      key.fill_width = width;
+    }
+
+  /* FIXME: for RTL */
+  if (DETAIL (ENTRY)
+      && (op->role & (DAWATI_ROLE_SPIN_BUTTON
+                      | DAWATI_ROLE_PARENT_COMBO_BOX_ENTRY)))
+    width += 10;
+
+  if (DETAIL (ENTRY) && (op->role & DAWATI_ROLE_PARENT_COMBO_BOX_ENTRY))
+    width += 10;
+
+  key.state_type = op->state;
+  key.width = width;
+  key.height = op->height;
+
+  /* the corners are filled from the widget's own style, only cache them
+   * when that is the style being drawn with */
+  if (op->fill_colors)
+    funcs->paint_shadow_full (cr, params, op->fill_colors, &key, op->x, op->y);
+  else if (key.fill_width != 0 && key.fill_width != key.width)
+    dawati_paint_cached (cr, params, &key, op->x, op->y, 0,
+                         funcs->paint_shadow);
+  else
+    dawati_paint_cached (cr, params, &key, op->x, op->y,
+                         SLICE_CORNER (params), funcs->paint_shadow);
+}
+
+static void
+dawati_paint_check (cairo_t                  *cr,
+                    const DawatiRenderParams *params,
+                    const DawatiRasterKey    *key,
+                    gint                      x,
+                    gint                      y)
+{
+  GtkStateType state_type = key->state_type;
+
+  cairo_set_line_width (cr, 1.0);
+
+  dawati_rounded_rectangle (cr, x + 0.5, y + 0.5,
+                            key->width - 1, key->height - 1, params->radius);
+
+  /* fill the background */
+  dawati_set_source_color (cr, &params->base[state_type]);
+  dawati_fill_preserve (cr);
+
+  /* draw the border */
+  dawati_set_source_color (cr, &params->border[state_type]);
+  dawati_stroke (cr);
+
+  dawati_set_source_color (cr, &params->text[state_type]);
+
+  /* draw a tick when checked */
+  if (key->shadow_type == GTK_SHADOW_IN)
+    {
+      const gdouble path_params[DAWATI_PATH_N_PARAMS] =
+        { key->width, key->height, };
+
+      dawati_path_cache_append (cr, x, y, DAWATI_PATH_TICK, path_params,
+                                dawati_build_tick);
+      dawati_fill (cr);
+    }
+}
+
+static void
+dawati_render_check (cairo_t                  *cr,
+                     const DawatiRenderParams *params,
+                     const DawatiRenderOp     *op)
+{
+  DawatiRasterKey key = { 0, };
+  GtkStateType state_type = op->state;
+
+  if (op->shadow == GTK_SHADOW_IN && state_type != GTK_STATE_INSENSITIVE)
+    {
+      state_type = GTK_STATE_SELECTED;
+    }
+
+  key.kind = DAWATI_RASTER_CHECK;
+  key.state_type = state_type;
+  key.shadow_type = op->shadow;
+  key.width = op->width;
+  key.height = op->height;
+
+  dawati_paint_cached (cr, params, &key, op->x, op->y, 0, dawati_paint_check);
+}
+
+/* the circle only depends on the width, the height is set to match */
+static void
+dawati_paint_option (cairo_t                  *cr,
+                     const DawatiRenderParams *params,
+                     const DawatiRasterKey    *key,
+                     gint                      x,
+                     gint                      y)
+{
+  GtkStateType state_type = key->state_type;
+  gint width = key->width;
+  gdouble cx, cy;
+  gint radius;
+
+  cairo_set_line_width (cr, 1);
+  width--;
+
+  /* define radius and centre coordinates */
+  if (width % 2) width--;
+  radius = width / 2;
+  cx = x + radius + 0.5;
+  cy = y + radius + 0.5;
+
+  /* fill the background */
+  dawati_set_source_color (cr, &params->base[state_type]);
+  cairo_arc (cr, cx, cy, radius, 0, M_PI * 2);
+  dawati_fill (cr);
+
+  /* draw the border */
+  cairo_arc (cr, cx, cy, radius, 0, M_PI * 2);
+  dawati_set_source_color (cr, &params->border[state_type]);
+  dawati_stroke (cr);
+
+  /*** draw check mark ***/
+  if (key->shadow_type == GTK_SHADOW_IN)
+    {
+      cairo_arc (cr, cx, cy, radius - 4,  0, M_PI * 2);
+      dawati_set_source_color (cr, &params->text[state_type]);
+      dawati_fill (cr);
+    }
+}
+
+static void
+dawati_render_option (cairo_t                  *cr,
+                      const DawatiRenderParams *params,
+                      const DawatiRenderOp     *op)
+{
+  DawatiRasterKey key = { 0, };
+  GtkStateType state_type = op->state;
+
+  if (op->shadow == GTK_SHADOW_IN && state_type != GTK_STATE_INSENSITIVE)
+    {
+      state_type = GTK_STATE_SELECTED;
+    }
+
+  key.kind = DAWATI_RASTER_OPTION;
+  key.state_type = state_type;
+  key.shadow_type = op->shadow;
+  key.width = op->width;
+  key.height = op->width;
+
+  dawati_paint_cached (cr, params, &key, op->x, op->y, 0,
+                       dawati_paint_option);
+}
+
+/* only the frame, the gap is blanked out by the caller */
+static void
+dawati_render_box_gap (cairo_t                  *cr,
+                       const DawatiRenderParams *params,
+                       const DawatiRenderOp     *op)
+{
+  if (op->shadow == GTK_SHADOW_NONE)
+    return;
+
+  cairo_set_line_width (cr, LINE_WIDTH);
+  cairo_translate (cr, 0.5, 0.5);
+
+  dawati_set_source_color (cr, &params->border[op->state]);
+
+  cairo_rectangle (cr, op->x, op->y, op->width - 1, op->height - 1);
+  dawati_stroke (cr);
+}
+
+static void
+dawati_render_extension (cairo_t                  *cr,
+                         const DawatiRenderParams *params,
+                         const DawatiRenderOp     *op)
+{
+  cairo_pattern_t *pattern;
+  gint x = op->x;
+  gint y = op->y;
+  gint width = op->width;
+  gint height = op->height;
+
+  /* set up for line drawing */
+  cairo_set_line_width (cr, LINE_WIDTH);
+  cairo_set_line_cap (cr, CAIRO_LINE_CAP_SQUARE);
+  cairo_translate (cr, 0.5, 0.5);
+
+  /* reduce with and height since we are using them for co-ordinate values */
+  width--; height--;
+
+  /* tab border */
+  if (op->gap_side == GTK_POS_BOTTOM)
+    height++; /* add overlap */
+
+  {
+    const gdouble path_params[DAWATI_PATH_N_PARAMS] =
+      { op->gap_side, width, height, params->radius,
+        op->state == GTK_STATE_NORMAL };
+
+    dawati_path_cache_append (cr, x, y, DAWATI_PATH_TAB, path_params,
+                              dawati_build_tab);
+  }
+
+  if (op->state == GTK_STATE_NORMAL)
+    {
+      pattern = cairo_pattern_create_linear (x, y, x, y +height);
+      cairo_pattern_add_color_stop_rgb (pattern, 0,
+                                        0xf9/255.0, 0xf9/255.0,0xf9/255.0);
+      cairo_pattern_add_color_stop_rgb (pattern, 1,
+                                        0xe6/255.0, 0xe6/255.0,0xe6/255.0);
+      cairo_set_source (cr, pattern);
+      dawati_fill_preserve (cr);
+      cairo_pattern_destroy (pattern);
+    }
+
+  dawati_set_source_color (cr, &params->border[op->state]);
+  dawati_stroke (cr);
+}
+
+static void
+dawati_render_vline (cairo_t                  *cr,
+                     const DawatiRenderParams *params,
+                     const DawatiRenderOp     *op)
+{
+  if (DETAIL (VSCALE) || DETAIL (HSCALE))
+    return;
+
+  if (DETAIL (VSEPARATOR))
+    return;
+
+  cairo_set_line_width (cr, LINE_WIDTH);
+  cairo_set_line_cap (cr, CAIRO_LINE_CAP_ROUND);
+
+  cairo_move_to (cr, op->x + LINE_WIDTH / 2.0, op->y);
+  cairo_line_to (cr, op->x + LINE_WIDTH / 2.0, op->y + op->height);
+
+  dawati_set_source_color (cr, &params->border[op->state]);
+  dawati_stroke (cr);
+}
+
+static void
+dawati_render_hline (cairo_t                  *cr,
+                     const DawatiRenderParams *params,
+                     const DawatiRenderOp     *op)
+{
+  if (DETAIL (VSCALE) || DETAIL (HSCALE))
+    return;
+
+  cairo_set_line_width (cr, LINE_WIDTH);
+  cairo_set_line_cap (cr, CAIRO_LINE_CAP_ROUND);
+
+  dawati_set_source_color (cr, &params->border[op->state]);
+  cairo_move_to (cr, op->x, op->y + LINE_WIDTH / 2.0);
+  cairo_line_to (cr, op->x + op->width, op->y + LINE_WIDTH / 2.0);
+  dawati_stroke (cr);
+}
+
+/* the focus rectangle has its own radius, only the shadow matters */
+static DAWATI_ALWAYS_INLINE void
+dawati_render_focus_variant (cairo_t                  *cr,
+                             const DawatiRenderParams *params,
+                             const DawatiRenderOp     *op,
+                             gboolean                  shadowed)
+{
+  gint line_width = op->line_width;
+  gint width = op->width;
+  gint height = op->height;
+
+  /* button draws it's own focus */
+  if (DETAIL (BUTTON))
+      return;
+
+  cairo_translate (cr, line_width / 2.0, line_width / 2.0);
+  width -= line_width;
+  height -= line_width;
+
+  if (shadowed)
+    {
+      width -= 1;
+      height -= 1;
+    }
+
+  dawati_rounded_rectangle (cr, op->x, op->y, width, height, line_width);
+  cairo_set_line_width (cr, line_width);
+  dawati_set_source_color (cr, &params->bg[GTK_STATE_SELECTED]);
+  dawati_stroke (cr);
+}
+
+#define DAWATI_DEFINE_RENDER_FUNCS(name, rounded, shadowed)                  \
+static void                                                                  \
+dawati_paint_box_##name (cairo_t                  *cr,                       \
+                         const DawatiRenderParams *params,                   \
+                         const DawatiRasterKey    *key,                      \
+                         gint                      x,                        \
+                         gint                      y)                        \
+{                                                                            \
+  dawati_paint_box_variant (cr, params, key, x, y, rounded, shadowed);       \
+}                                                                            \
+                                                                             \
+static void                                                                  \
+dawati_paint_shadow_full_##name (cairo_t                  *cr,               \
+                                 const DawatiRenderParams *params,           \
+                                 const DawatiColor        *fill_colors,      \
+                                 const DawatiRasterKey    *key,              \
+                                 gint                      x,                \
+                                 gint                      y)                \
+{                                                                            \
+  dawati_paint_shadow_variant (cr, params, fill_colors, key, x, y,           \
+                               rounded, shadowed);                           \
+}                                                                            \
+                                                                             \
+static void                                                                  \
+dawati_paint_shadow_##name (cairo_t                  *cr,                    \
+                            const DawatiRenderParams *params,                \
+                            const DawatiRasterKey    *key,                   \
+                            gint                      x,                     \
+                            gint                      y)                     \
+{                                                                            \
+  dawati_paint_shadow_variant (cr, params, params->bg, key, x, y,            \
+                               rounded, shadowed);                           \
+}                                                                            \
+                                                                             \
+static void                                                                  \
+dawati_render_focus_##name (cairo_t                  *cr,                    \
+                            const DawatiRenderParams *params,                \
+                            const DawatiRenderOp     *op)                    \
+{                                                                            \
+  dawati_render_focus_variant (cr, params, op, shadowed);                    \
+}                                                                            \
+                                                                             \
+static const DawatiRenderFuncs render_funcs_##name =                         \
+{                                                                            \
+  dawati_paint_box_##name,                                                   \
+  dawati_paint_shadow_##name,                                                \
+  dawati_paint_shadow_full_##name,                                           \
+  dawati_render_focus_##name                                                 \
+};
+
+DAWATI_DEFINE_RENDER_FUNCS (square, FALSE, FALSE)
+DAWATI_DEFINE_RENDER_FUNCS (square_shadow, FALSE, TRUE)
+DAWATI_DEFINE_RENDER_FUNCS (rounded, TRUE, FALSE)
+DAWATI_DEFINE_RENDER_FUNCS (rounded_shadow, TRUE, TRUE)
+
+static const DawatiRenderFuncs *
+dawati_render_pick_funcs (const DawatiRenderParams *params)
+{
+  if (params->radius == 0)
+    return params->shadow != 0.0 ? &render_funcs_square_shadow
+                                 : &render_funcs_square;
+  else
+    return params->shadow != 0.0 ? &render_funcs_rounded_shadow
+                                 : &render_funcs_rounded;
+}
+
+/* room around an arrow for its round caps and mitred tip */
+#define ARROW_BLEED 2
+
+static void
+dawati_paint_arrow (cairo_t                  *cr,
+                    const DawatiRenderParams *params,
+                    const DawatiRasterKey    *key,
+                    gint                      x,
+                    gint                      y)
+{
+  const gdouble path_params[DAWATI_PATH_N_PARAMS] =
+    { key->flags, key->width - ARROW_BLEED * 2,
+      key->height - ARROW_BLEED * 2, };
+
+  cairo_set_line_width (cr, 2);
+
+  cairo_set_line_cap (cr, CAIRO_LINE_CAP_ROUND);
+
+  dawati_set_source_color (cr, &params->fg[key->state_type]);
+
+  dawati_path_cache_append (cr, x + ARROW_BLEED, y + ARROW_BLEED,
+                            DAWATI_PATH_ARROW, path_params,
+                            dawati_build_arrow);
+  dawati_stroke (cr);
+}
+
+static void
+dawati_render_arrow (cairo_t                  *cr,
+                     const DawatiRenderParams *params,
+                     const DawatiRenderOp     *op)
+{
+  DawatiRasterKey key = { 0, };
+  GtkArrowType arrow_type = op->arrow_type;
+  gint x = op->x;
+  gint y = op->y;
+  gint width = op->width;
+  gint height = op->height;
+
+  /* add padding around scrollbar buttons */
+  if (DETAIL (VSCROLLBAR) || DETAIL (HSCROLLBAR))
+    {
+      x += 3;
+      width -= 4;
+      y += 3;
+      height -= 4;
+    }
+
+  /* ensure we have odd number of pixels for width or height to allow for
+   * correct centering
+   */
+  if (width % 2) width--;
+  if (height % 2) height--;
+
+
+  switch (arrow_type)
+    {
+    case GTK_ARROW_UP:
+      y = y + height / 2 - (width * 0.12) - 1;
+      height = width * 0.6;
+      break;
+    case GTK_ARROW_DOWN:
+      y = y + height / 2 - (width * 0.12);
+      height = width * 0.6;
+      break;
+    case GTK_ARROW_LEFT:
+      x = x + width / 2 - (height * 0.12) - 1;
+      width = height * 0.6;
+      break;
+    case GTK_ARROW_RIGHT:
+      x = x + width / 2 - (height * 0.12);
+      width = height * 0.6;
+      break;
+    case GTK_ARROW_NONE:
+      return;
+    }
+
+  key.kind = DAWATI_RASTER_ARROW;
+  key.state_type = op->state;
+  key.flags = arrow_type;
+  key.width = width + ARROW_BLEED * 2;
+  key.height = height + ARROW_BLEED * 2;
+
+  dawati_paint_cached (cr, params, &key, x - ARROW_BLEED, y - ARROW_BLEED, 0,
+                       dawati_paint_arrow);
+}
+
+/* a filled circle of radius width / 2 */
+static void
+dawati_paint_dot (cairo_t                  *cr,
+                  const DawatiRenderParams *params,
+                  const DawatiRasterKey    *key,
+                  gint                      x,
+                  gint                      y)
+{
+  gdouble radius = key->width / 2.0;
+
+  if (key->flags & DAWATI_DOT_BG)
+    dawati_set_source_color (cr, &params->bg[key->state_type]);
+  else
+    dawati_set_source_color (cr, &params->border[key->state_type]);
+
+  cairo_arc (cr, x + radius, y + radius, radius, 0, M_PI * 2);
+  dawati_fill (cr);
+}
+
+static void
+dawati_render_handle (cairo_t                  *cr,
+                      const DawatiRenderParams *params,
+                      const DawatiRenderOp     *op)
+{
+  DawatiRasterKey key = { 0, };
+  gint positions[3][2];
+  gint cx, cy, radius, i;
+
+  cx = op->x + op->width / 2;
+  cy = op->y + op->height / 2;
+
+  if (op->orientation == GTK_ORIENTATION_HORIZONTAL)
+    radius = op->height / 2 - 2;
+  else
+    radius = op->width / 2 - 2;
+
+  if (radius <= 0)
+    return;
+
+  /* three dots, three radii apart */
+  for (i = 0; i < 3; i++)
+    {
+      gint offset = (i - 1) * radius * 3;
+
+      if (op->orientation == GTK_ORIENTATION_HORIZONTAL)
+        {
+          positions[i][0] = cx + offset - radius;
+          positions[i][1] = cy - radius;
+        }
+      else
+        {
+          positions[i][0] = cx - radius;
+          positions[i][1] = cy + offset - radius;
+        }
+    }
+
+  key.kind = DAWATI_RASTER_DOT;
+  key.state_type = op->state;
+  key.width = radius * 2;
+  key.height = radius * 2;
+
+  dawati_paint_stamps (cr, params, &key, positions, 3, dawati_paint_dot);
+}
+
+#define GRIP_RADIUS 2
+#define GRIP_SPACING (GRIP_RADIUS * 2 + 2)
+
+/* the dots of a south east grip, in spacings from the one in the corner,
+ * and of a south grip, from the one in the middle */
+static const gint grip_corner_dots[6][2] =
+  { { 0, -2 }, { 0, -1 }, { 0, 0 }, { -1, -1 }, { -1, 0 }, { -2, 0 } };
+static const gint grip_side_dots[3][2] =
+  { { -1, 0 }, { 0, 0 }, { 1, 0 } };
+
+static void
+dawati_render_resize_grip (cairo_t                  *cr,
+                           const DawatiRenderParams *params,
+                           const DawatiRenderOp     *op)
+{
+  DawatiRasterKey key = { 0, };
+  const gint (*dots)[2] = grip_corner_dots;
+  guint n = G_N_ELEMENTS (grip_corner_dots);
+  gint positions[6][2];
+  gint sx = 1, sy = 1;    /* mirror the south east layout */
+  gboolean vertical = FALSE;
+  gint cx, cy;
+  guint i;
+
+  switch (op->edge)
+    {
+    case GDK_WINDOW_EDGE_NORTH_WEST:
+      sx = sy = -1;
+      break;
+    case GDK_WINDOW_EDGE_NORTH_EAST:
+      sy = -1;
+      break;
+    case GDK_WINDOW_EDGE_SOUTH_WEST:
+      sx = -1;
+      break;
+    case GDK_WINDOW_EDGE_SOUTH_EAST:
+      break;
+    case GDK_WINDOW_EDGE_NORTH:
+      sy = -1;
+      /* fall through */
+    case GDK_WINDOW_EDGE_SOUTH:
+      dots = grip_side_dots;
+      n = G_N_ELEMENTS (grip_side_dots);
+      break;
+    case GDK_WINDOW_EDGE_WEST:
+      sx = -1;
+      /* fall through */
+    case GDK_WINDOW_EDGE_EAST:
+      dots = grip_side_dots;
+      n = G_N_ELEMENTS (grip_side_dots);
+      vertical = TRUE;
+      break;
+    }
+
+  /* the centre of the dot the others are placed from */
+  cx = sx > 0 ? op->x + op->width - GRIP_RADIUS : op->x + GRIP_RADIUS;
+  cy = sy > 0 ? op->y + op->height - GRIP_RADIUS : op->y + GRIP_RADIUS;
+
+  if (dots == grip_side_dots)
+    {
+      if (vertical)
+        cy = op->y + op->height / 2;
+      else
+        cx = op->x + op->width / 2;
+    }
+
+  for (i = 0; i < n; i++)
+    {
+      gint dx = dots[i][0] * GRIP_SPACING;
+      gint dy = dots[i][1] * GRIP_SPACING;
+
+      if (vertical)
+        {
+          gint t = dx;
+
+          dx = dy;
+          dy = t;
+        }
+
+      positions[i][0] = cx + dx * sx - GRIP_RADIUS;
+      positions[i][1] = cy + dy * sy - GRIP_RADIUS;
+    }
+
+  key.kind = DAWATI_RASTER_DOT;
+  key.state_type = GTK_STATE_ACTIVE;
+  key.flags = DAWATI_DOT_BG;
+  key.width = GRIP_RADIUS * 2;
+  key.height = GRIP_RADIUS * 2;
+
+  dawati_paint_stamps (cr, params, &key, positions, n, dawati_paint_dot);
+}
+
+/* the size of an expander when the widget has no expander-size, and the
+ * room around it for the half pixel of the border outside it */
+#define EXPANDER_SIZE 12
+#define EXPANDER_BLEED 1
+
+static void
+dawati_paint_expander (cairo_t                  *cr,
+                       const DawatiRenderParams *params,
+                       const DawatiRasterKey    *key,
+                       gint                      x,
+                       gint                      y)
+{
+  GtkStateType state_type = key->state_type;
+  GtkExpanderStyle expander_style = key->flags;
+  gint size = key->width - EXPANDER_BLEED * 2;
+  gint margin = size / 6;
+
+  x += EXPANDER_BLEED;
+  y += EXPANDER_BLEED;
+
+  cairo_set_source_rgb (cr, 0.6, 0.6, 0.6);
+  cairo_set_line_width (cr, 1.0);
+  dawati_rounded_rectangle (cr, x, y, size, size, 2 );
+  dawati_stroke_preserve (cr);
+
+  if (state_type == GTK_STATE_PRELIGHT || state_type == GTK_STATE_ACTIVE)
+    cairo_set_source_rgba (cr, 0, 0.6, 0.8, 1);
+  else
+    cairo_set_source_rgba (cr, 1, 1, 1, 1);
+
+  dawati_fill (cr);
+
+  if (state_type == GTK_STATE_PRELIGHT || state_type == GTK_STATE_ACTIVE)
+    cairo_set_source_rgba (cr, 1, 1, 1, 1);
+  else
+    cairo_set_source_rgba (cr, 0, 0.6, 0.8, 1);
+
+  cairo_set_line_width (cr, 2.0);
+  cairo_move_to (cr, x + margin, y + size / 2);
+  cairo_line_to (cr, x + size - margin, y + size / 2);
+  dawati_stroke (cr);
+
+  if (expander_style != GTK_EXPANDER_EXPANDED)
+    {
+      if (expander_style == GTK_EXPANDER_SEMI_COLLAPSED
+          || expander_style == GTK_EXPANDER_SEMI_EXPANDED)
+        {
+          if (state_type == GTK_STATE_PRELIGHT
+              || state_type == GTK_STATE_ACTIVE)
+            cairo_set_source_rgba (cr, 1, 1, 1, 0.5);
+          else
+            cairo_set_source_rgba (cr, 0, 0.6, 0.8, 0.5);
+        }
+
+      cairo_move_to (cr, x + size / 2, y + margin);
+      cairo_line_to (cr, x + size / 2, y + size - margin);
+      dawati_stroke (cr);
+    }
+}
+
+/* op->x and op->y are the centre, op->width the expander-size if any */
+static void
+dawati_render_expander (cairo_t                  *cr,
+                        const DawatiRenderParams *params,
+                        const DawatiRenderOp     *op)
+{
+  DawatiRasterKey key = { 0, };
+  gint size = op->width > 0 ? op->width : EXPANDER_SIZE;
+
+  key.kind = DAWATI_RASTER_EXPANDER;
+  key.state_type = op->state;
+  key.flags = op->expander_style;
+  key.width = size + EXPANDER_BLEED * 2;
+  key.height = size + EXPANDER_BLEED * 2;
+
+  dawati_paint_cached (cr, params, &key,
+                       op->x - size / 2 - EXPANDER_BLEED,
+                       op->y - size / 2 - EXPANDER_BLEED, 0,
+                       dawati_paint_expander);
+}
+
+/* Draw an element. The state of cr is saved and restored around it. */
+void
+dawati_render (cairo_t                  *cr,
+               const DawatiRenderParams *params,
+               const DawatiRenderOp     *op)
+{
+  g_return_if_fail (op->detail < DAWATI_N_DETAILS);
+
+  cairo_save (cr);
+
+  switch (op->element)
+    {
+    case DAWATI_ELEMENT_BOX:
+      dawati_render_box (cr, params, op);
+      break;
+    case DAWATI_ELEMENT_SHADOW:
+      dawati_render_shadow (cr, params, op);
+      break;
+    case DAWATI_ELEMENT_CHECK:
+      dawati_render_check (cr, params, op);
+      break;
+    case DAWATI_ELEMENT_OPTION:
+      dawati_render_option (cr, params, op);
+      break;
+    case DAWATI_ELEMENT_BOX_GAP:
+      dawati_render_box_gap (cr, params, op);
+      break;
+    case DAWATI_ELEMENT_EXTENSION:
+      dawati_render_extension (cr, params, op);
+      break;
+    case DAWATI_ELEMENT_HLINE:
+      dawati_render_hline (cr, params, op);
+      break;
+    case DAWATI_ELEMENT_VLINE:
+      dawati_render_vline (cr, params, op);
+      break;
+    case DAWATI_ELEMENT_FOCUS:
+      DAWATI_RENDER_FUNCS (params)->render_focus (cr, params, op);
+      break;
+    case DAWATI_ELEMENT_ARROW:
+      dawati_render_arrow (cr, params, op);
+      break;
+    case DAWATI_ELEMENT_HANDLE:
+      dawati_render_handle (cr, params, op);
+      break;
+    case DAWATI_ELEMENT_RESIZE_GRIP:
+      dawati_render_resize_grip (cr, params, op);
+      break;
+    case DAWATI_ELEMENT_EXPANDER:
+      dawati_render_expander (cr, params, op);
+      break;
+    }
+
+  cairo_restore (cr);
+}
+
+/* Render an element into a new ARGB image surface covering the element's
+ * rectangle, or for expanders a rectangle of that size centred on the
+ * expander. */
+cairo_surface_t *
+dawati_render_element_to_surface (const DawatiRenderParams *params,
+                                  const DawatiRenderOp     *op)
+{
+  cairo_surface_t *surface;
+  cairo_t *cr;
+  gint x = op->x;
+  gint y = op->y;
+
+  g_return_val_if_fail (op->width > 0 && op->height > 0, NULL);
+
+  if (op->element == DAWATI_ELEMENT_EXPANDER)
+    {
+      x -= op->width / 2;
+      y -= op->height / 2;
+    }
+
+  surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
+                                        op->width, op->height);
+
+  cr = cairo_create (surface);
+  cairo_translate (cr, -x, -y);
+  dawati_render (cr, params, op);
+  cairo_destroy (cr);
+
+  return surface;
+}
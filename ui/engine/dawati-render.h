@@ -0,0 +1,137 @@
+/*
+ * dawati-gtk-engine - A GTK+ theme engine for Dawati
+ *
+ * Copyright (c) 2011, Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef _DAWATI_RENDER_H
+#define _DAWATI_RENDER_H
+
+#include <gtk/gtk.h>
+
+#include "dawati-detail.h"
+
+G_BEGIN_DECLS
+
+/* The drawing code of the engine. It only needs a cairo context and the
+ * parameters resolved from a style, so elements can be rendered without a
+ * GdkWindow or an X server, for example into an image surface. */
+
+typedef struct
+{
+  gdouble red;
+  gdouble green;
+  gdouble blue;
+} DawatiColor;
+
+typedef struct _DawatiRenderFuncs DawatiRenderFuncs;
+
+/* the parts of a style that the drawing code uses, indexed by state */
+typedef struct
+{
+  gint        radius;
+  gdouble     shadow;
+
+  DawatiColor fg[5];
+  DawatiColor bg[5];
+  DawatiColor mid[5];
+  DawatiColor text[5];
+  DawatiColor base[5];
+  DawatiColor border[5];
+
+  /* identifies these parameters in the raster cache, or 0 if renderings
+   * should not be cached */
+  guint       serial;
+
+  /* the drawing code specialised for radius and shadow */
+  const DawatiRenderFuncs *funcs;
+} DawatiRenderParams;
+
+typedef enum
+{
+  DAWATI_ELEMENT_BOX,
+  DAWATI_ELEMENT_SHADOW,
+  DAWATI_ELEMENT_CHECK,
+  DAWATI_ELEMENT_OPTION,
+  DAWATI_ELEMENT_BOX_GAP,
+  DAWATI_ELEMENT_EXTENSION,
+  DAWATI_ELEMENT_HLINE,
+  DAWATI_ELEMENT_VLINE,
+  DAWATI_ELEMENT_FOCUS,
+  DAWATI_ELEMENT_ARROW,
+  DAWATI_ELEMENT_HANDLE,
+  DAWATI_ELEMENT_RESIZE_GRIP,
+  DAWATI_ELEMENT_EXPANDER
+} DawatiElement;
+
+/* One element to draw. Lines go from (x, y) and are width or height long;
+ * expanders are centred on (x, y) and width wide, or a default size if it
+ * is 0. */
+typedef struct
+{
+  DawatiElement      element;
+  DawatiDetail       detail;
+  guint              role;          /* DawatiRole of the widget, if any */
+  GtkStateType       state;
+  GtkShadowType      shadow;
+
+  gint               x;
+  gint               y;
+  gint               width;
+  gint               height;
+
+  /* state of the widget itself, which spin buttons draw their buttons in */
+  GtkStateType       widget_state;
+
+  /* box gaps and extensions */
+  GtkPositionType    gap_side;
+  gint               gap_x;
+  gint               gap_width;
+
+  GtkArrowType       arrow_type;
+  GtkOrientation     orientation;
+  GdkWindowEdge      edge;
+  GtkExpanderStyle   expander_style;
+  gint               line_width;    /* focus rectangles */
+
+  /* Shadows drawn for a widget fill the corners outside their border with
+   * the widget's background in fill_state. fill_colors holds the widget's
+   * backgrounds when it has a different style from the one drawn with. */
+  gboolean           fill_corners;
+  GtkStateType       fill_state;
+  const DawatiColor *fill_colors;
+} DawatiRenderOp;
+
+void             dawati_render                    (cairo_t                  *cr,
+                                                   const DawatiRenderParams *params,
+                                                   const DawatiRenderOp     *op);
+cairo_surface_t *dawati_render_element_to_surface (const DawatiRenderParams *params,
+                                                   const DawatiRenderOp     *op);
+
+void             dawati_render_params_changed     (DawatiRenderParams       *params);
+guint            dawati_render_new_serial         (void);
+void             dawati_render_forget             (guint                     serial);
+void             dawati_render_print_stats        (void);
+
+void             dawati_render_set_overdraw       (cairo_surface_t          *target,
+                                                   cairo_surface_t          *counts,
+                                                   gdouble                   dx,
+                                                   gdouble                   dy);
+
+G_END_DECLS
+
+#endif /* _DAWATI_RENDER_H */
@@ -0,0 +1,275 @@
+/*
+ * dawati-gtk-engine - A GTK+ theme engine for Dawati
+ *
+ * Copyright (c) 2011, Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/* Replays a recording made with DAWATI_ENGINE_RECORD through the render
+ * core, into an image surface and as fast as it can, and prints how long
+ * that took as one line of JSON. Nothing needs an X server, so engine
+ * changes can be measured against real sessions on a build machine:
+ *
+ *   DAWATI_ENGINE_RECORD=session.rec some-application
+ *   ./dawati-replay session.rec
+ *
+ * The first pass over the recording starts with empty caches and is
+ * reported on its own; the others are averaged.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <string.h>
+
+#include "dawati-bench-utils.h"
+#include "dawati-record.h"
+
+/* larger recordings are clipped to this */
+#define MAX_SURFACE_SIZE 4096
+
+static const gchar *element_names[] = {
+  "box",
+  "shadow",
+  "check",
+  "option",
+  "box_gap",
+  "extension",
+  "hline",
+  "vline",
+  "focus",
+  "arrow",
+  "handle",
+  "resize_grip",
+  "expander"
+};
+
+typedef struct
+{
+  guint   draws;
+  guint64 ns;
+} ElementTimes;
+
+static gint n_repeats = 5;
+
+static GOptionEntry options[] = {
+  { "repeats", 'r', 0, G_OPTION_ARG_INT, &n_repeats,
+    "Passes over the recording", "N" },
+  { NULL }
+};
+
+/* the part of the recorded windows that was drawn on */
+static void
+get_extents (GArray       *draws,
+             GdkRectangle *extents)
+{
+  gint x1 = G_MAXINT, y1 = G_MAXINT, x2 = G_MININT, y2 = G_MININT;
+  guint i;
+
+  for (i = 0; i < draws->len; i++)
+    {
+      const DawatiRecordedDraw *d;
+      GdkRectangle rect;
+
+      d = &g_array_index (draws, DawatiRecordedDraw, i);
+
+      if (d->has_area)
+        {
+          rect = d->area;
+        }
+      else
+        {
+          rect.x = d->op.x;
+          rect.y = d->op.y;
+          rect.width = MAX (d->op.width, 1);
+          rect.height = MAX (d->op.height, 1);
+        }
+
+      x1 = MIN (x1, rect.x);
+      y1 = MIN (y1, rect.y);
+      x2 = MAX (x2, rect.x + rect.width);
+      y2 = MAX (y2, rect.y + rect.height);
+    }
+
+  if (draws->len == 0)
+    x1 = y1 = x2 = y2 = 0;
+
+  extents->x = x1;
+  extents->y = y1;
+  extents->width = CLAMP (x2 - x1, 1, MAX_SURFACE_SIZE);
+  extents->height = CLAMP (y2 - y1, 1, MAX_SURFACE_SIZE);
+}
+
+static guint64
+replay (GArray             *draws,
+        cairo_surface_t    *surface,
+        const GdkRectangle *extents,
+        ElementTimes       *times)
+{
+  guint64 start, total = 0;
+  guint i;
+
+  for (i = 0; i < draws->len; i++)
+    {
+      const DawatiRecordedDraw *d;
+      cairo_t *cr;
+      guint64 ns;
+
+      d = &g_array_index (draws, DawatiRecordedDraw, i);
+
+      start = dawati_bench_now_ns ();
+
+      /* a new context for every draw, as the engine does */
+      cr = cairo_create (surface);
+      cairo_translate (cr, -extents->x, -extents->y);
+
+      if (d->has_area)
+        {
+          cairo_rectangle (cr, d->area.x, d->area.y,
+                           d->area.width, d->area.height);
+          cairo_clip (cr);
+        }
+
+      dawati_render (cr, d->params, &d->op);
+
+      cairo_destroy (cr);
+
+      ns = dawati_bench_now_ns () - start;
+      total += ns;
+
+      if (times && (guint) d->op.element < G_N_ELEMENTS (element_names))
+        {
+          times[d->op.element].draws++;
+          times[d->op.element].ns += ns;
+        }
+    }
+
+  /* make sure the drawing has really happened */
+  cairo_surface_flush (surface);
+
+  return total;
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  ElementTimes times[G_N_ELEMENTS (element_names)];
+  DawatiRecordReader *reader;
+  GOptionContext *context;
+  GError *error = NULL;
+  cairo_surface_t *surface;
+  GdkRectangle extents;
+  GArray *draws = NULL;
+  GString *out;
+  guint64 cold_ns, warm_ns = 0, allocs;
+  gboolean first = TRUE;
+  guint n_warm;
+  guint i;
+  gint r;
+
+  context = g_option_context_new ("RECORDING - replay a recording of the "
+                                  "engine's drawing");
+  g_option_context_add_main_entries (context, options, NULL);
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      return 1;
+    }
+  g_option_context_free (context);
+
+  if (argc != 2 || n_repeats < 1)
+    {
+      g_printerr ("Usage: %s [-r REPEATS] RECORDING\n", argv[0]);
+      return 1;
+    }
+
+  reader = dawati_record_reader_new (argv[1], &error);
+  if (reader)
+    draws = dawati_record_reader_read_all (reader, &error);
+  if (!reader || !draws)
+    {
+      g_printerr ("%s\n", error->message);
+      return 1;
+    }
+
+  if (draws->len == 0)
+    {
+      g_printerr ("%s has nothing to replay\n", argv[1]);
+      return 1;
+    }
+
+  get_extents (draws, &extents);
+  surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
+                                        extents.width, extents.height);
+
+  memset (times, 0, sizeof (times));
+
+  /* the first pass fills the caches */
+  cold_ns = replay (draws, surface, &extents,
+                    n_repeats == 1 ? times : NULL);
+
+  allocs = dawati_bench_get_n_allocs ();
+
+  for (r = 1; r < n_repeats; r++)
+    warm_ns += replay (draws, surface, &extents, times);
+
+  allocs = dawati_bench_get_n_allocs () - allocs;
+  n_warm = MAX (n_repeats - 1, 1);
+
+  if (n_repeats == 1)
+    warm_ns = cold_ns;
+
+  out = g_string_new ("{\"recording\":");
+  dawati_bench_json_string (out, argv[1]);
+  g_string_append_printf (out,
+                          ",\"draws\":%u,\"repeats\":%d"
+                          ",\"width\":%d,\"height\":%d"
+                          ",\"cold_ms\":%.3f,\"warm_ms\":%.3f"
+                          ",\"ns_per_draw\":%.1f,\"allocs_per_draw\":%.2f"
+                          ",\"elements\":{",
+                          draws->len, n_repeats,
+                          extents.width, extents.height,
+                          cold_ns / 1e6, warm_ns / 1e6 / n_warm,
+                          (gdouble) warm_ns / n_warm / draws->len,
+                          n_repeats > 1
+                          ? (gdouble) allocs / n_warm / draws->len : 0.0);
+
+  for (i = 0; i < G_N_ELEMENTS (element_names); i++)
+    {
+      if (!times[i].draws)
+        continue;
+
+      g_string_append_printf (out, "%s\"%s\":{\"draws\":%u"
+                              ",\"ns_per_draw\":%.1f}",
+                              first ? "" : ",", element_names[i],
+                              times[i].draws / n_warm,
+                              (gdouble) times[i].ns / times[i].draws);
+      first = FALSE;
+    }
+
+  g_string_append (out, "}}");
+  puts (out->str);
+
+  g_string_free (out, TRUE);
+  cairo_surface_destroy (surface);
+  g_array_free (draws, TRUE);
+  dawati_record_reader_free (reader);
+
+  return 0;
+}
@@ -0,0 +1,89 @@
+/*
+ * dawati-gtk-engine - A GTK+ theme engine for Dawati
+ *
+ * Copyright (c) 2011, Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "dawati-role.h"
+
+/* set on every classified widget so that a role of zero can be told apart
+ * from a widget that has not been looked at yet */
+#define DAWATI_ROLE_CLASSIFIED (1u << 31)
+
+static GQuark role_quark = 0;
+
+static guint
+dawati_widget_classify (GtkWidget *widget)
+{
+  guint role = DAWATI_ROLE_CLASSIFIED;
+
+  if (GTK_IS_SCROLLBAR (widget))
+    role |= DAWATI_ROLE_SCROLLBAR;
+  if (GTK_IS_HSCROLLBAR (widget))
+    role |= DAWATI_ROLE_HSCROLLBAR;
+  if (GTK_IS_SCALE (widget))
+    role |= DAWATI_ROLE_SCALE;
+  if (GTK_IS_SPIN_BUTTON (widget))
+    role |= DAWATI_ROLE_SPIN_BUTTON;
+
+  if (widget->parent)
+    {
+      if (GTK_IS_TREE_VIEW (widget->parent))
+        role |= DAWATI_ROLE_PARENT_TREE_VIEW;
+      if (GTK_IS_COMBO_BOX_ENTRY (widget->parent))
+        role |= DAWATI_ROLE_PARENT_COMBO_BOX_ENTRY;
+    }
+
+  return role;
+}
+
+static void
+dawati_widget_parent_set (GtkWidget *widget,
+                          GtkWidget *old_parent,
+                          gpointer   user_data)
+{
+  /* widget->parent already points at the new parent */
+  g_object_set_qdata (G_OBJECT (widget), role_quark,
+                      GUINT_TO_POINTER (dawati_widget_classify (widget)));
+}
+
+guint
+dawati_widget_get_role (GtkWidget *widget)
+{
+  guint role;
+
+  if (!widget)
+    return 0;
+
+  if (G_UNLIKELY (!role_quark))
+    role_quark = g_quark_from_static_string ("dawati-widget-role");
+
+  role = GPOINTER_TO_UINT (g_object_get_qdata (G_OBJECT (widget), role_quark));
+
+  if (G_UNLIKELY (!role))
+    {
+      role = dawati_widget_classify (widget);
+      g_object_set_qdata (G_OBJECT (widget), role_quark,
+                          GUINT_TO_POINTER (role));
+
+      /* the handler is only connected once, it keeps the role up to date */
+      g_signal_connect (widget, "parent-set",
+                        G_CALLBACK (dawati_widget_parent_set), NULL);
+    }
+
+  return role & ~DAWATI_ROLE_CLASSIFIED;
+}
@@ -0,0 +1,44 @@
+/*
+ * dawati-gtk-engine - A GTK+ theme engine for Dawati
+ *
+ * Copyright (c) 2011, Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License,
+ * version 2.1, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef _DAWATI_ROLE_H
+#define _DAWATI_ROLE_H
+
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+/* The widget types the draw functions care about, worked out once per
+ * widget and kept in its qdata until it is reparented. */
+typedef enum
+{
+  DAWATI_ROLE_SCROLLBAR                = 1 << 0,
+  DAWATI_ROLE_HSCROLLBAR               = 1 << 1,
+  DAWATI_ROLE_SCALE                    = 1 << 2,
+  DAWATI_ROLE_SPIN_BUTTON              = 1 << 3,
+  DAWATI_ROLE_PARENT_TREE_VIEW         = 1 << 4,
+  DAWATI_ROLE_PARENT_COMBO_BOX_ENTRY   = 1 << 5
+} DawatiRole;
+
+guint dawati_widget_get_role (GtkWidget *widget);
+
+G_END_DECLS
+
+#endif /* _DAWATI_ROLE_H */
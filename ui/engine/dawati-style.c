@@ -18,11 +18,22 @@
  *
  */
 
+
 #include "config.h"
 
 #include "dawati-style.h"
 #include "dawati-utils.h"
 #include "dawati-rc-style.h"
+#include "dawati-render.h"
+#include "dawati-detail.h"
+#include "dawati-role.h"
+#include "dawati-debug.h"
+#include "dawati-probes.h"
+#include "dawati-record.h"
+#include "dawati-overdraw.h"
+#include "dawati-icon-cache.h"
+#include "dawati-pixbuf.h"
+#include "dawati-image.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -30,16 +41,14 @@
 #include <string.h>
 
 
-static int do_debug = 0;
+static DawatiDebugMode do_debug = DAWATI_DEBUG_NONE;
 static void print_widget_path (GtkWidget *widget);
 
 
 #define DEBUG \
-  if (do_debug == 1) \
+  if (do_debug == DAWATI_DEBUG_CALLS) \
     printf ("%s: detail = '%s'; state = %d; x:%d; y:%d; w:%d; h:%d;\n", __FUNCTION__, detail, state_type, x, y, width, height); \
-  else if (do_debug == 2 && widget) print_widget_path (widget);
-
-#define DETAIL(foo) (detail && strcmp (foo, detail) == 0)
+  else if (do_debug == DAWATI_DEBUG_WIDGET_PATHS && widget) print_widget_path (widget);
 
 #define LINE_WIDTH 1
 
@@ -72,6 +81,138 @@ print_widget_path (GtkWidget *widget)
   g_free (path);
 }
 
+static inline void
+dawati_color_from_gdk (DawatiColor    *color,
+                       const GdkColor *gdk_color)
+{
+  color->red = gdk_color->red / 65535.0;
+  color->green = gdk_color->green / 65535.0;
+  color->blue = gdk_color->blue / 65535.0;
+}
+
+/* the shades GtkStyle derives its light and dark colours with */
+static const gdouble light_dark_factors[] = { 1.3, 0.7 };
+
+/* Copy what the drawing code needs out of the style, so that the draw
+ * functions only read from the parameters. */
+static void
+dawati_style_fill_params (DawatiStyle        *mb_style,
+                          DawatiRenderParams *params)
+{
+  GtkStyle *style = GTK_STYLE (mb_style);
+  GdkColor light_dark[5 * G_N_ELEMENTS (light_dark_factors)];
+  gint i;
+
+  params->radius = mb_style->radius;
+  params->shadow = mb_style->shadow;
+
+  /* the mid colours are worked out as gtk_style_realize() does, so that
+   * they are right before the style is realized too */
+  dawati_shade_colours (style->bg, 5, light_dark_factors,
+                        G_N_ELEMENTS (light_dark_factors), light_dark);
+
+  for (i = 0; i < 5; i++)
+    {
+      GdkColor mid;
+
+      mid.red = (light_dark[i * 2].red + light_dark[i * 2 + 1].red) / 2;
+      mid.green = (light_dark[i * 2].green + light_dark[i * 2 + 1].green) / 2;
+      mid.blue = (light_dark[i * 2].blue + light_dark[i * 2 + 1].blue) / 2;
+
+      dawati_color_from_gdk (&params->fg[i], &style->fg[i]);
+      dawati_color_from_gdk (&params->bg[i], &style->bg[i]);
+      dawati_color_from_gdk (&params->mid[i], &mid);
+      dawati_color_from_gdk (&params->text[i], &style->text[i]);
+      dawati_color_from_gdk (&params->base[i], &style->base[i]);
+      dawati_color_from_gdk (&params->border[i], &mb_style->border_color[i]);
+    }
+}
+
+/* Fills in the parameters once the style is set up. The style gets a new
+ * serial, dropping anything cached for its old parameters, and the drawing
+ * code for its radius and shadow. */
+static void
+dawati_style_update_params (DawatiStyle *mb_style)
+{
+  dawati_style_fill_params (mb_style, &mb_style->params);
+  dawati_render_params_changed (&mb_style->params);
+}
+
+static gboolean
+dawati_palette_equal (const DawatiRenderParams *a,
+                      const DawatiRenderParams *b)
+{
+  return memcmp (a->fg, b->fg, sizeof (a->fg)) == 0
+    && memcmp (a->bg, b->bg, sizeof (a->bg)) == 0
+    && memcmp (a->mid, b->mid, sizeof (a->mid)) == 0
+    && memcmp (a->text, b->text, sizeof (a->text)) == 0
+    && memcmp (a->base, b->base, sizeof (a->base)) == 0
+    && memcmp (a->border, b->border, sizeof (a->border)) == 0;
+}
+
+static GQuark foreign_bg_quark = 0;
+
+static void
+dawati_foreign_style_realized (GtkStyle *style,
+                               gpointer  data)
+{
+  g_signal_handlers_disconnect_by_func (style, dawati_foreign_style_realized,
+                                        data);
+  g_object_set_qdata (G_OBJECT (style), foreign_bg_quark, NULL);
+}
+
+/* The bg colours of a style from another engine, converted once and kept
+ * in its qdata until it is realized again, as it is after its colours are
+ * changed. */
+static const DawatiColor *
+dawati_foreign_style_get_bg (GtkStyle *style)
+{
+  DawatiColor *bg;
+  gint i;
+
+  if (G_UNLIKELY (!foreign_bg_quark))
+    foreign_bg_quark = g_quark_from_static_string ("dawati-foreign-bg");
+
+  bg = g_object_get_qdata (G_OBJECT (style), foreign_bg_quark);
+  if (bg)
+    return bg;
+
+  bg = g_new (DawatiColor, 5);
+  for (i = 0; i < 5; i++)
+    dawati_color_from_gdk (&bg[i], &style->bg[i]);
+
+  g_object_set_qdata_full (G_OBJECT (style), foreign_bg_quark, bg, g_free);
+  g_signal_connect (style, "realize",
+                    G_CALLBACK (dawati_foreign_style_realized), NULL);
+
+  return bg;
+}
+
+static void
+dawati_render_op_init (DawatiRenderOp *op,
+                       DawatiElement   element,
+                       GtkWidget      *widget,
+                       const gchar    *detail,
+                       GtkStateType    state_type,
+                       GtkShadowType   shadow_type,
+                       gint            x,
+                       gint            y,
+                       gint            width,
+                       gint            height)
+{
+  memset (op, 0, sizeof (DawatiRenderOp));
+
+  op->element = element;
+  op->detail = dawati_detail_lookup (detail);
+  op->role = dawati_widget_get_role (widget);
+  op->state = state_type;
+  op->shadow = shadow_type;
+  op->x = x;
+  op->y = y;
+  op->width = width;
+  op->height = height;
+}
+
 static cairo_t*
 dawati_cairo_create (GdkWindow    *window,
                              GdkRectangle *area)
@@ -89,189 +230,154 @@ dawati_cairo_create (GdkWindow    *window,
   return cr;
 }
 
-static inline void
-dawati_set_border_color (cairo_t     *cr,
-                                 GtkStyle    *style,
-                                 GtkStateType state)
-{
-  if (DAWATI_STYLE (style)->border_color)
-    gdk_cairo_set_source_color (cr,
-                                &(DAWATI_STYLE (style)->border_color[
-                                    state]));
-}
-
-
 static void
-dawati_rounded_rectangle (cairo_t *cr,
-                                  gdouble  x,
-                                  gdouble  y,
-                                  gdouble  width,
-                                  gdouble  height,
-                                  gdouble  radius)
+dawati_draw_op (GtkStyle             *style,
+                GdkWindow            *window,
+                GdkRectangle         *area,
+                const DawatiRenderOp *op)
 {
-  if (width < 1 || height < 1)
-    return;
+  cairo_t *cr;
 
-  if (radius == 0)
-    {
-      cairo_rectangle (cr, x, y, width, height);
-      return;
-    }
+  dawati_record_op (&DAWATI_STYLE (style)->params, area, op);
 
-  if (width < radius * 2)
-    {
-      radius = width / 2;
-    }
-  else if (height < radius * 2)
-    {
-      radius = height / 2;
-    }
+  cr = dawati_cairo_create (window, area);
 
-  cairo_move_to (cr, x, y + height - radius);
-  cairo_arc (cr, x + radius, y + radius, radius, M_PI, M_PI * 1.5);
-  cairo_arc (cr, x + width - radius, y + radius, radius, M_PI * 1.5, 0);
-  cairo_arc (cr, x + width - radius, y + height - radius, radius, 0,
-             M_PI * 0.5);
-  cairo_arc (cr, x + radius, y + height - radius, radius, M_PI * 0.5, M_PI);
+  dawati_overdraw_begin (window, cr);
+  dawati_render (cr, &DAWATI_STYLE (style)->params, op);
+  dawati_overdraw_end ();
+
+  cairo_destroy (cr);
 }
 
 static void
-dawati_draw_grip (cairo_t *cr,
-                          gboolean vertical,
-                          gdouble  x,
-                          gdouble  y,
-                          gdouble  width,
-                          gdouble  height)
+dawati_image_match_init (DawatiImageMatch    *match,
+                         DawatiImageFunction  function,
+                         const gchar         *detail,
+                         GtkStateType         state_type,
+                         GtkShadowType        shadow_type)
 {
-  gdouble cx, cy;
-  gint n_strips = 3;
-  gint strip_w = 3;
-  gint strip_h = 8 - strip_w;
-  gint strip_padding = 2;
-  gint grip_w = (n_strips * strip_w) + ((n_strips - 1) * strip_padding);
-  gint i;
+  memset (match, 0, sizeof (DawatiImageMatch));
 
-  cairo_save (cr);
+  match->function = function;
+  match->flags = DAWATI_IMAGE_MATCH_STATE | DAWATI_IMAGE_MATCH_SHADOW;
+  match->detail = detail;
+  match->state = state_type;
+  match->shadow = shadow_type;
+}
 
-  cairo_set_line_width (cr, strip_w);
-  cairo_set_line_cap (cr, CAIRO_LINE_CAP_ROUND);
+/* Draw the first image of the style that matches, if there is one. Like
+ * the pixmap engine, the orientation is taken from the shape when the
+ * call doesn't have one. */
+static gboolean
+dawati_draw_image (GtkStyle         *style,
+                   GdkWindow        *window,
+                   GdkRectangle     *area,
+                   DawatiImageMatch *match,
+                   gboolean          draw_center,
+                   gint              x,
+                   gint              y,
+                   gint              width,
+                   gint              height)
+{
+  DawatiImage *image;
+  cairo_t *cr;
 
-  if (!vertical)
-    {
-      cx = x + (width / 2.0) - grip_w / 2.0 + strip_w / 2.0;
-      cy = y + (height / 2.0) - (strip_h / 2.0);
+  if (!DAWATI_STYLE (style)->images)
+    return FALSE;
 
-      for (i = 0; i < n_strips; i++)
-        {
-          gdouble position;
-
-          position = cx + (i * (strip_w + strip_padding));
+  if (!(match->flags & DAWATI_IMAGE_MATCH_ORIENTATION))
+    {
+      match->flags |= DAWATI_IMAGE_MATCH_ORIENTATION;
+      match->orientation = height > width ? GTK_ORIENTATION_VERTICAL
+                                          : GTK_ORIENTATION_HORIZONTAL;
+    }
 
-          cairo_move_to (cr, position, cy);
-          cairo_line_to (cr, position, cy + strip_h);
+  image = dawati_image_find (DAWATI_STYLE (style)->images, match);
+  if (!image)
+    return FALSE;
 
-          cairo_stroke (cr);
-        }
-    }
-  else
-    {
-      cy = y + (height / 2.0) - grip_w / 2.0 + strip_w / 2.0;
-      cx = x + (width / 2.0) - (strip_h / 2.0);
+  cr = dawati_cairo_create (window, area);
+  dawati_image_render (cr, image, draw_center, x, y, width, height);
+  cairo_destroy (cr);
 
-      for (i = 0; i < n_strips; i++)
-        {
-          gdouble position;
+  dawati_overdraw_add_rectangle (window, area, x, y, width, height);
 
-          position = cy + (i * (strip_w + strip_padding));
+  return TRUE;
+}
 
-          cairo_move_to (cr, cx, position);
-          cairo_line_to (cr, cx + strip_h, position);
+/* A style with images is drawn the way the pixmap engine drew it: what
+ * none of them matches is left to GtkStyle, not the render core. */
+#define HAS_IMAGES(style) (DAWATI_STYLE (style)->images != NULL)
 
-          cairo_stroke (cr);
-        }
-    }
+/* scrollbar buttons are drawn whole by draw_arrow when there are STEPPER
+ * images, which needs the widget for their size */
+static gboolean
+dawati_has_steppers (GtkStyle    *style,
+                     GtkWidget   *widget,
+                     const gchar *detail)
+{
+  DawatiDetail d = dawati_detail_lookup (detail);
 
-  cairo_restore (cr);
+  return widget
+    && (d == DAWATI_DETAIL_HSCROLLBAR || d == DAWATI_DETAIL_VSCROLLBAR)
+    && dawati_image_list_has (DAWATI_STYLE (style)->images,
+                              DAWATI_IMAGE_STEPPER);
 }
 
 static void
 dawati_draw_box (GtkStyle     *style,
-                         GdkWindow    *window,
-                         GtkStateType  state_type,
-                         GtkShadowType shadow_type,
-                         GdkRectangle *area,
-                         GtkWidget    *widget,
-                         const gchar  *detail,
-                         gint          x,
-                         gint          y,
-                         gint          width,
-                         gint          height)
+                 GdkWindow    *window,
+                 GtkStateType  state_type,
+                 GtkShadowType shadow_type,
+                 GdkRectangle *area,
+                 GtkWidget    *widget,
+                 const gchar  *detail,
+                 gint          x,
+                 gint          y,
+                 gint          width,
+                 gint          height)
 {
-  cairo_t *cr;
-  DawatiStyle *mb_style = DAWATI_STYLE (style);
-  gint radius = mb_style->radius;
+  DawatiRenderOp op;
+  DawatiImageMatch match;
 
   DEBUG;
 
-  if (DETAIL ("paned") || DETAIL ("buttondefault"))
-    return;
-
-
-  /* we want hover and focused widgets to look the same */
-  if (widget && GTK_WIDGET_HAS_FOCUS (widget))
-    state_type = GTK_STATE_PRELIGHT;
+  DAWATI_PROBE (draw_box_entry, detail, state_type, width, height);
 
+  SANITIZE_SIZE;
 
-  /* scrollbar troughs are a plain rectangle */
-  if (widget && GTK_IS_SCROLLBAR (widget) && DETAIL ("trough"))
+  dawati_image_match_init (&match, DAWATI_IMAGE_BOX, detail, state_type,
+                           shadow_type);
+  if (dawati_has_steppers (style, widget, detail)
+      || dawati_draw_image (style, window, area, &match, TRUE,
+                            x, y, width, height))
     {
-      cr = dawati_cairo_create (window, area);
-
-      cairo_rectangle (cr, x, y, width, height);
-      gdk_cairo_set_source_color (cr, &style->base[state_type]);
-      cairo_fill (cr);
-
-      cairo_destroy (cr);
-
+      DAWATI_PROBE (draw_box_return, detail, state_type, width, height);
       return;
     }
 
-  SANITIZE_SIZE;
-
-  /*** treeview headers ***/
-  if (widget && GTK_IS_TREE_VIEW (widget->parent))
+  if (HAS_IMAGES (style))
     {
-      cr = dawati_cairo_create (window, area);
-
-      cairo_rectangle (cr, x, y, width, height);
-      gdk_cairo_set_source_color (cr, &style->bg[state_type]);
-      cairo_fill (cr);
-      cairo_destroy (cr);
-
-      gtk_paint_vline (style, window, state_type, area, widget, detail,
-                       y + 5, y + height - 5, x + width - 1);
+      GTK_STYLE_CLASS (dawati_style_parent_class)->draw_box
+        (style, window, state_type, shadow_type, area, widget, detail, x, y,
+         width, height);
+      DAWATI_PROBE (draw_box_return, detail, state_type, width, height);
       return;
     }
 
-  /*** spin buttons ***/
-  if (DETAIL ("spinbutton_down") || DETAIL ("spinbutton_up"))
-    return;
-
-  if (DETAIL ("spinbutton"))
-    {
-      /* FIXME: for RTL */
-      width += 10;
-      x -= 10;
+  /* we want hover and focused widgets to look the same */
+  if (widget && GTK_WIDGET_HAS_FOCUS (widget))
+    state_type = GTK_STATE_PRELIGHT;
 
-      /* always draw button as shadow out to match the entry */
-      shadow_type = GTK_SHADOW_OUT;
+  dawati_render_op_init (&op, DAWATI_ELEMENT_BOX, widget, detail,
+                         state_type, shadow_type, x, y, width, height);
 
-      /* draw the buttons with the same state type as the entry */
-      state_type = widget->state;
-    }
+  if (widget)
+    op.widget_state = widget->state;
 
   /*** combo boxes ***/
-  if (DETAIL ("button") && widget && GTK_IS_COMBO_BOX_ENTRY (widget->parent))
+  if (op.detail == DAWATI_DETAIL_BUTTON
+      && (op.role & DAWATI_ROLE_PARENT_COMBO_BOX_ENTRY))
     {
       GtkWidget *entry;
 
@@ -280,226 +386,75 @@ dawati_draw_box (GtkStyle     *style,
       g_object_set_data (G_OBJECT (widget->parent),
                          "dawati-combo-button", widget);
 
-      /* always draw combo box entry buttons as shadow out to match the entry */
-      shadow_type = GTK_SHADOW_OUT;
-
       if (GTK_IS_ENTRY (entry))
         {
           gtk_widget_queue_draw (entry);
         }
-
-      /* FIXME: RTL */
-      width += 10;
-      x -= 10;
     }
 
-  if (widget
-      && (DETAIL ("trough")
-          || DETAIL ("trough-fill-level")
-          || DETAIL ("trough-fill-level-full"))
-      && GTK_IS_SCALE (widget))
-    {
-      if (mb_style->shadow)
-        {
-          width--;
-          height--;
-        }
-      if (width > height)
-        {
-          y = y + (height / 2.0 - 2);
-          height = 4;
-        }
-      else
-        {
-          x = x + (width / 2.0 - 2);
-          width = 4;
-        }
-    }
-
-
-  /* scrollbar buttons */
-  if (DETAIL ("hscrollbar") || DETAIL ("vscrollbar"))
-    {
-      x += 2;
-      y += 2;
-      width -= 4;
-      height -= 4;
-    }
+  dawati_draw_op (style, window, area, &op);
 
-  /* scrollbar slider */
-  if (DETAIL ("slider"))
-    {
-      if (widget && GTK_IS_HSCROLLBAR (widget))
-        {
-          y += 2;
-          height -= 4;
-        }
-      else
-        {
-          x += 2;
-          width -= 4;
-        }
-    }
+  DAWATI_PROBE (draw_box_return, detail, state_type, width, height);
+}
 
-  cr = dawati_cairo_create (window, area);
+static void
+dawati_draw_shadow (GtkStyle     *style,
+                    GdkWindow    *window,
+                    GtkStateType  state_type,
+                    GtkShadowType shadow_type,
+                    GdkRectangle *area,
+                    GtkWidget    *widget,
+                    const gchar  *detail,
+                    gint          x,
+                    gint          y,
+                    gint          width,
+                    gint          height)
+{
+  DawatiRenderOp op;
+  DawatiImageMatch match;
 
-  cairo_set_line_width (cr, LINE_WIDTH);
+  DEBUG;
 
+  DAWATI_PROBE (draw_shadow_entry, detail, state_type, width, height);
 
-  /* special "fill" indicator */
-  if (DETAIL ("trough-fill-level-full")
-      || DETAIL ("trough-fill-level"))
+  if (shadow_type == GTK_SHADOW_NONE)
     {
-      gdk_cairo_set_source_color (cr, &style->base[GTK_STATE_SELECTED]);
-
-      if (width > height)
-        cairo_rectangle (cr, x, y + 1, width, height - 2);
-      else
-        cairo_rectangle (cr, x + 1, y, width - 2, height);
-
-      cairo_fill (cr);
-      cairo_destroy (cr);
+      DAWATI_PROBE (draw_shadow_return, detail, state_type, width, height);
       return;
     }
 
-  if (mb_style->shadow)
-    {
-      if (shadow_type == GTK_SHADOW_OUT)
-        {
-          /* outer shadow */
-          dawati_rounded_rectangle (cr, x, y, width, height,
-                                            radius + 1);
-          cairo_set_source_rgba (cr, 0, 0, 0, mb_style->shadow);
-          cairo_fill (cr);
-
-          /* reduce size for outer shadow */
-          height--;
-          width--;
-        }
-      else if (shadow_type == GTK_SHADOW_IN)
-        {
-          x++;
-          y++;
-          width--;
-          height--;
-        }
-    }
-
-
-  /* fill */
-  dawati_rounded_rectangle (cr, x, y, width, height, radius);
-
-  if (DETAIL ("light-switch-trough"))
-    {
-      cairo_pattern_t *crp;
-
-      crp = cairo_pattern_create_linear (x, y, x, height);
-
-      /* FIXME: these colours really should not be defined here */
-
-      if (state_type == GTK_STATE_SELECTED)
-        {
-          cairo_pattern_add_color_stop_rgb (crp, 0, 0.365, 0.820, 0.953);
-          cairo_pattern_add_color_stop_rgb (crp, 1, 0.627, 0.894, 0.973);
-        }
-      else
-        {
-          cairo_pattern_add_color_stop_rgb (crp, 0, 0.937, 0.941, 0.929);
-          cairo_pattern_add_color_stop_rgb (crp, 1, 1.0, 1.0, 1.0);
-        }
-
-      cairo_set_source (cr, crp);
-    }
-  else
-    gdk_cairo_set_source_color (cr, &style->bg[state_type]);
-
-  cairo_fill (cr);
-
-  /* extra hilight for "button" widgets, also used as focus rectangle since
-   * state_type is set to prelight for focused widgets (see above) */
-  if (state_type == GTK_STATE_PRELIGHT && DETAIL ("button")
-      && !(widget && GTK_IS_COMBO_BOX_ENTRY (widget->parent)))
-    {
-      cairo_set_line_width (cr, 2.0);
-      dawati_rounded_rectangle (cr, x + 2, y + 2, width - 4,
-                                        height - 4, radius - 1);
-      gdk_cairo_set_source_color (cr, &style->bg[GTK_STATE_SELECTED]);
-      cairo_stroke (cr);
-      cairo_set_line_width (cr, 1.0);
-    }
+  SANITIZE_SIZE;
 
-  if (shadow_type != GTK_SHADOW_NONE)
+  /* only the frame of shadow images is drawn */
+  dawati_image_match_init (&match, DAWATI_IMAGE_SHADOW, detail, state_type,
+                           shadow_type);
+  if (dawati_draw_image (style, window, area, &match, FALSE,
+                         x, y, width, height))
     {
-      /* border */
-      dawati_rounded_rectangle (cr, x + 0.5, y + 0.5,
-                                        width - 1, height - 1, radius);
-      dawati_set_border_color (cr, style, state_type);
-      cairo_stroke (cr);
+      DAWATI_PROBE (draw_shadow_return, detail, state_type, width, height);
+      return;
     }
 
-  /* add a grip to handles */
-  if (DETAIL ("light-switch-handle") || DETAIL ("hscale"))
-    {
-      gdk_cairo_set_source_color (cr, &style->mid[state_type]);
-      dawati_draw_grip (cr, FALSE, x, y, width, height);
-    }
-  else if (DETAIL ("vscale"))
+  if (HAS_IMAGES (style))
     {
-      gdk_cairo_set_source_color (cr, &style->mid[state_type]);
-      dawati_draw_grip (cr, TRUE, x, y, width, height);
+      GTK_STYLE_CLASS (dawati_style_parent_class)->draw_shadow
+        (style, window, state_type, shadow_type, area, widget, detail, x, y,
+         width, height);
+      DAWATI_PROBE (draw_shadow_return, detail, state_type, width, height);
+      return;
     }
-  cairo_destroy (cr);
 
-}
+  dawati_render_op_init (&op, DAWATI_ELEMENT_SHADOW, widget, detail,
+                         state_type, shadow_type, x, y, width, height);
 
-static void
-dawati_draw_shadow (GtkStyle     *style,
-                            GdkWindow    *window,
-                            GtkStateType  state_type,
-                            GtkShadowType shadow_type,
-                            GdkRectangle *area,
-                            GtkWidget    *widget,
-                            const gchar  *detail,
-                            gint          x,
-                            gint          y,
-                            gint          width,
-                            gint          height)
-{
-  cairo_t *cr;
-  DawatiStyle *mb_style = DAWATI_STYLE (style);
-  gdouble radius = mb_style->radius;
-
-  DEBUG;
-
-  if (shadow_type == GTK_SHADOW_NONE)
-    return;
-
-  SANITIZE_SIZE;
-
-  cr = dawati_cairo_create (window, area);
-
-  /* initilise the background in the corners to the colour of the widget */
   if (widget)
     {
-      cairo_rectangle (cr, x, y, width, height);
-      if (mb_style->shadow)
-        dawati_rounded_rectangle (cr, x, y, width - 1, height - 1,
-                                          radius);
-      else
-        dawati_rounded_rectangle (cr, x, y, width, height, radius);
-
-      gdk_cairo_set_source_color (cr, &widget->style->bg[state_type]);
-      cairo_set_fill_rule (cr, CAIRO_FILL_RULE_EVEN_ODD);
-      cairo_fill (cr);
+      op.fill_corners = TRUE;
+      op.fill_state = state_type;
     }
 
-  /* FIXME: for RTL */
-  if (widget && DETAIL ("entry")
-      && (GTK_IS_SPIN_BUTTON (widget)
-          || GTK_IS_COMBO_BOX_ENTRY (widget->parent)))
-    width += 10;
-
-  if (widget && DETAIL ("entry") && GTK_IS_COMBO_BOX_ENTRY (widget->parent))
+  if (op.detail == DAWATI_DETAIL_ENTRY
+      && (op.role & DAWATI_ROLE_PARENT_COMBO_BOX_ENTRY))
     {
       GtkWidget *button;
 
@@ -513,196 +468,161 @@ dawati_draw_shadow (GtkStyle     *style,
       if (button)
         {
           if (GTK_WIDGET_HAS_FOCUS (button))
-            state_type = GTK_STATE_PRELIGHT;
+            op.state = GTK_STATE_PRELIGHT;
           else
             /* try and keep the button and entry in the same state */
             gtk_widget_set_state (button, state_type);
         }
-
-
-      width += 10;
     }
 
-  cairo_translate (cr, 0.5, 0.5);
-  width--;
-  height--;
-
-  cairo_set_line_width (cr, 1.0);
-  if (mb_style->shadow != 0.0)
+  /* the corners are filled from the widget's own style */
+  if (widget && widget->style != style)
     {
-      /* outer shadow */
-      dawati_rounded_rectangle (cr, x, y, width, height,
-                                        radius + 1.0);
-      cairo_set_source_rgba (cr, 0, 0, 0, mb_style->shadow);
-      cairo_stroke (cr);
-
-
-      /* reduce size for outer shadow */
-      height--;
-      width--;
+      if (DAWATI_IS_STYLE (widget->style))
+        op.fill_colors = DAWATI_STYLE (widget->style)->params.bg;
+      else
+        op.fill_colors = dawati_foreign_style_get_bg (widget->style);
     }
 
-  /* border */
-  dawati_rounded_rectangle (cr, x, y, width, height, radius);
-  dawati_set_border_color (cr, style, state_type);
-  cairo_stroke (cr);
+  dawati_draw_op (style, window, area, &op);
 
-  cairo_destroy (cr);
+  DAWATI_PROBE (draw_shadow_return, detail, state_type, width, height);
 }
 
 static void
 dawati_draw_check (GtkStyle     *style,
-                           GdkWindow    *window,
-                           GtkStateType  state_type,
-                           GtkShadowType shadow_type,
-                           GdkRectangle *area,
-                           GtkWidget    *widget,
-                           const gchar  *detail,
-                           gint          x,
-                           gint          y,
-                           gint          width,
-                           gint          height)
+                   GdkWindow    *window,
+                   GtkStateType  state_type,
+                   GtkShadowType shadow_type,
+                   GdkRectangle *area,
+                   GtkWidget    *widget,
+                   const gchar  *detail,
+                   gint          x,
+                   gint          y,
+                   gint          width,
+                   gint          height)
 {
-  cairo_t *cr;
-  gint radius = DAWATI_STYLE (style)->radius;
+  DawatiRenderOp op;
+  DawatiImageMatch match;
 
   DEBUG;
 
-  cr = dawati_cairo_create (window, area);
-
-  cairo_set_line_width (cr, 1.0);
+  DAWATI_PROBE (draw_check_entry, detail, state_type, width, height);
 
-  if (shadow_type == GTK_SHADOW_IN && state_type != GTK_STATE_INSENSITIVE)
+  dawati_image_match_init (&match, DAWATI_IMAGE_CHECK, detail, state_type,
+                           shadow_type);
+  if (dawati_draw_image (style, window, area, &match, TRUE,
+                         x, y, width, height))
     {
-      state_type = GTK_STATE_SELECTED;
+      DAWATI_PROBE (draw_check_return, detail, state_type, width, height);
+      return;
     }
 
-  /* we don't support anything other than 15x15 */
-  width = 15;
-  height = 15;
-
-  dawati_rounded_rectangle (cr, x + 0.5, y + 0.5,
-                                    width - 1, height - 1, radius);
-
-  /* fill the background */
-  gdk_cairo_set_source_color (cr, &style->base[state_type]);
-  cairo_fill_preserve (cr);
-
-  /* draw the border */
-  dawati_set_border_color (cr, style, state_type);
-  cairo_stroke (cr);
-
-  gdk_cairo_set_source_color (cr, &style->text[state_type]);
-
-  /* draw a tick when checked */
-  if (shadow_type == GTK_SHADOW_IN)
+  if (HAS_IMAGES (style))
     {
-      cairo_translate (cr, x, y);
-
-      cairo_move_to (cr, 3, 6);
-      cairo_line_to (cr, 6, 9);
-      cairo_line_to (cr, 12, 3);
-      cairo_line_to (cr, 12, 6);
-      cairo_line_to (cr, 6, 12);
-      cairo_line_to (cr, 3, 9);
-      cairo_line_to (cr, 3, 6);
-
-      cairo_fill (cr);
+      GTK_STYLE_CLASS (dawati_style_parent_class)->draw_check
+        (style, window, state_type, shadow_type, area, widget, detail, x, y,
+         width, height);
+      DAWATI_PROBE (draw_check_return, detail, state_type, width, height);
+      return;
     }
-  cairo_destroy (cr);
 
+  dawati_render_op_init (&op, DAWATI_ELEMENT_CHECK, widget, detail,
+                         state_type, shadow_type, x, y, width, height);
+  dawati_draw_op (style, window, area, &op);
+
+  DAWATI_PROBE (draw_check_return, detail, state_type, width, height);
 }
 
 
 static void
 dawati_draw_option (GtkStyle     *style,
-                            GdkWindow    *window,
-                            GtkStateType  state_type,
-                            GtkShadowType shadow_type,
-                            GdkRectangle *area,
-                            GtkWidget    *widget,
-                            const gchar  *detail,
-                            gint          x,
-                            gint          y,
-                            gint          width,
-                            gint          height)
+                    GdkWindow    *window,
+                    GtkStateType  state_type,
+                    GtkShadowType shadow_type,
+                    GdkRectangle *area,
+                    GtkWidget    *widget,
+                    const gchar  *detail,
+                    gint          x,
+                    gint          y,
+                    gint          width,
+                    gint          height)
 {
-  cairo_t *cr;
-  gint cx, cy, radius;
+  DawatiRenderOp op;
+  DawatiImageMatch match;
 
   DEBUG;
 
-  cr = dawati_cairo_create (window, area);
+  DAWATI_PROBE (draw_option_entry, detail, state_type, width, height);
 
-  cairo_set_line_width (cr, 1);
-  cairo_translate (cr, 0.5, 0.5);
-  width--;
-  height--;
-
-  if (shadow_type == GTK_SHADOW_IN && state_type != GTK_STATE_INSENSITIVE)
+  dawati_image_match_init (&match, DAWATI_IMAGE_OPTION, detail, state_type,
+                           shadow_type);
+  if (dawati_draw_image (style, window, area, &match, TRUE,
+                         x, y, width, height))
     {
-      state_type = GTK_STATE_SELECTED;
+      DAWATI_PROBE (draw_option_return, detail, state_type, width, height);
+      return;
     }
 
-  /* define radius and centre coordinates */
-  if (width % 2) width--;
-  radius = width / 2;
-  cx = x + radius;
-  cy = y + radius;
-
-  /* fill the background */
-  gdk_cairo_set_source_color (cr, &style->base[state_type]);
-  cairo_arc (cr, cx, cy, radius, 0, M_PI * 2);
-  cairo_fill (cr);
-
-  /* draw the border */
-  cairo_arc (cr, cx, cy, radius, 0, M_PI * 2);
-  dawati_set_border_color (cr, style, state_type);
-  cairo_stroke (cr);
-
-  /*** draw check mark ***/
-  if (shadow_type == GTK_SHADOW_IN)
+  if (HAS_IMAGES (style))
     {
-      cairo_arc (cr, cx, cy, radius - 4,  0, M_PI * 2);
-      gdk_cairo_set_source_color (cr, &style->text[state_type]);
-      cairo_fill (cr);
+      GTK_STYLE_CLASS (dawati_style_parent_class)->draw_option
+        (style, window, state_type, shadow_type, area, widget, detail, x, y,
+         width, height);
+      DAWATI_PROBE (draw_option_return, detail, state_type, width, height);
+      return;
     }
-  cairo_destroy (cr);
+
+  dawati_render_op_init (&op, DAWATI_ELEMENT_OPTION, widget, detail,
+                         state_type, shadow_type, x, y, width, height);
+  dawati_draw_op (style, window, area, &op);
+
+  DAWATI_PROBE (draw_option_return, detail, state_type, width, height);
 }
 
 static void
 dawati_draw_box_gap (GtkStyle       *style,
-                             GdkWindow      *window,
-                             GtkStateType    state_type,
-                             GtkShadowType   shadow_type,
-                             GdkRectangle   *area,
-                             GtkWidget      *widget,
-                             const gchar    *detail,
-                             gint            x,
-                             gint            y,
-                             gint            width,
-                             gint            height,
-                             GtkPositionType gap_side,
-                             gint            gap_x,
-                             gint            gap_width)
+                     GdkWindow      *window,
+                     GtkStateType    state_type,
+                     GtkShadowType   shadow_type,
+                     GdkRectangle   *area,
+                     GtkWidget      *widget,
+                     const gchar    *detail,
+                     gint            x,
+                     gint            y,
+                     gint            width,
+                     gint            height,
+                     GtkPositionType gap_side,
+                     gint            gap_x,
+                     gint            gap_width)
 {
-  cairo_t *cr;
+  DawatiRenderOp op;
   GdkRectangle rect = { 0, };
 
-  if (shadow_type == GTK_SHADOW_NONE)
-    return;
-
-  cr = dawati_cairo_create (window, area);
+  DAWATI_PROBE (draw_box_gap_entry, detail, state_type, width, height);
 
-  cairo_set_line_width (cr, LINE_WIDTH);
-  cairo_translate (cr, 0.5, 0.5);
+  if (HAS_IMAGES (style))
+    {
+      GTK_STYLE_CLASS (dawati_style_parent_class)->draw_box_gap
+        (style, window, state_type, shadow_type, area, widget, detail, x, y,
+         width, height, gap_side, gap_x, gap_width);
+      DAWATI_PROBE (draw_box_gap_return, detail, state_type, width, height);
+      return;
+    }
 
-  dawati_set_border_color (cr, style, state_type);
+  if (shadow_type == GTK_SHADOW_NONE)
+    {
+      DAWATI_PROBE (draw_box_gap_return, detail, state_type, width, height);
+      return;
+    }
 
   /* start off with a rectangle... */
-  cairo_rectangle (cr, x, y, width -1, height -1);
-  cairo_stroke (cr);
-  cairo_destroy (cr);
+  dawati_render_op_init (&op, DAWATI_ELEMENT_BOX_GAP, widget, detail,
+                         state_type, shadow_type, x, y, width, height);
+  op.gap_side = gap_side;
+  op.gap_x = gap_x;
+  op.gap_width = gap_width;
+  dawati_draw_op (style, window, area, &op);
 
   switch (gap_side)
     {
@@ -736,385 +656,420 @@ dawati_draw_box_gap (GtkStyle       *style,
   gtk_style_apply_default_background (style, window, TRUE, state_type, area,
                                       rect.x, rect.y, rect.width,
                                       rect.height);
+  dawati_overdraw_add_rectangle (window, area, rect.x, rect.y, rect.width,
+                                 rect.height);
 
+  DAWATI_PROBE (draw_box_gap_return, detail, state_type, width, height);
+}
 
+/* the same as a box gap, except for styles with images */
+static void
+dawati_draw_shadow_gap (GtkStyle       *style,
+                        GdkWindow      *window,
+                        GtkStateType    state_type,
+                        GtkShadowType   shadow_type,
+                        GdkRectangle   *area,
+                        GtkWidget      *widget,
+                        const gchar    *detail,
+                        gint            x,
+                        gint            y,
+                        gint            width,
+                        gint            height,
+                        GtkPositionType gap_side,
+                        gint            gap_x,
+                        gint            gap_width)
+{
+  if (HAS_IMAGES (style))
+    GTK_STYLE_CLASS (dawati_style_parent_class)->draw_shadow_gap
+      (style, window, state_type, shadow_type, area, widget, detail, x, y,
+       width, height, gap_side, gap_x, gap_width);
+  else
+    dawati_draw_box_gap (style, window, state_type, shadow_type, area, widget,
+                         detail, x, y, width, height,
+                         gap_side, gap_x, gap_width);
 }
 
 
 static void
 dawati_draw_extension (GtkStyle       *style,
-                               GdkWindow      *window,
-                               GtkStateType    state_type,
-                               GtkShadowType   shadow_type,
-                               GdkRectangle   *area,
-                               GtkWidget      *widget,
-                               const gchar    *detail,
-                               gint            x,
-                               gint            y,
-                               gint            width,
-                               gint            height,
-                               GtkPositionType gap_side)
+                       GdkWindow      *window,
+                       GtkStateType    state_type,
+                       GtkShadowType   shadow_type,
+                       GdkRectangle   *area,
+                       GtkWidget      *widget,
+                       const gchar    *detail,
+                       gint            x,
+                       gint            y,
+                       gint            width,
+                       gint            height,
+                       GtkPositionType gap_side)
 {
-  cairo_t *cr;
-  cairo_pattern_t *pattern;
-  gint radius = DAWATI_STYLE (style)->radius;
-
-  /* initialise the background */
-  gtk_style_apply_default_background (style, window, TRUE, state_type, area,
-                                      x, y, width, height);
-
-  cr = dawati_cairo_create (window, area);
-
-  /* set up for line drawing */
-  cairo_set_line_width (cr, LINE_WIDTH);
-  cairo_set_line_cap (cr, CAIRO_LINE_CAP_SQUARE);
-  cairo_translate (cr, 0.5, 0.5);
+  DawatiRenderOp op;
 
-  /* reduce with and height since we are using them for co-ordinate values */
-  width--; height--;
+  DAWATI_PROBE (draw_extension_entry, detail, state_type, width, height);
 
-  /* tab border */
-  switch (gap_side)
+  if (HAS_IMAGES (style))
     {
-    case GTK_POS_TOP:     /* bottom tab */
-      cairo_move_to (cr, x, y);
-      cairo_arc_negative (cr, x + radius, y + height - radius, radius, M_PI,
-                          M_PI * 0.5);
-      cairo_arc_negative (cr, x + width - radius, y + height - radius, radius,
-                          M_PI * 0.5, 0);
-      cairo_line_to (cr, x + width, y);
-      break;
-    case GTK_POS_BOTTOM: /* top tab */
-      height++; /* add overlap */
-      if (state_type == GTK_STATE_NORMAL)
-        cairo_arc_negative (cr, x, y + height - radius, radius, M_PI / 2.0, 0);
-      else
-        cairo_move_to (cr, x + radius, y + height);
-      cairo_arc (cr, x + radius * 2, y + radius, radius, M_PI, M_PI * 1.5);
-      cairo_arc (cr, x + width - radius * 2, y + radius, radius, M_PI * 1.5, 0);
-      if (state_type == GTK_STATE_NORMAL)
-        cairo_arc_negative (cr, x + width, y + height - radius, radius, M_PI, M_PI / 2.0);
-      else
-        cairo_line_to (cr, x + width - radius, y + height);
-      break;
-    case GTK_POS_LEFT:  /* right tab */
-      cairo_move_to (cr, x, y);
-      cairo_arc (cr, x + width - radius, y + radius, radius, M_PI * 1.5, 0);
-      cairo_arc (cr, x + width - radius, y + height - radius, radius, 0,
-                 M_PI * 0.5);
-      cairo_line_to (cr, x, y + height);
-      break;
-    case GTK_POS_RIGHT: /* left tab */
-      cairo_move_to (cr, x + width, y);
-      cairo_arc_negative (cr, x + radius, y + radius, radius, M_PI * 1.5, M_PI);
-      cairo_arc_negative (cr, x + radius, y + height - radius, radius, M_PI,
-                          M_PI * 0.5);
-      cairo_line_to (cr, x + width, y + height);
-      break;
-    }
-
-  if (state_type == GTK_STATE_NORMAL)
-    {
-      pattern = cairo_pattern_create_linear (x, y, x, y +height);
-      cairo_pattern_add_color_stop_rgb (pattern, 0,
-                                        0xf9/255.0, 0xf9/255.0,0xf9/255.0);
-      cairo_pattern_add_color_stop_rgb (pattern, 1,
-                                        0xe6/255.0, 0xe6/255.0,0xe6/255.0);
-      cairo_set_source (cr, pattern);
-      cairo_fill_preserve (cr);
-      cairo_pattern_destroy (pattern);
+      GTK_STYLE_CLASS (dawati_style_parent_class)->draw_extension
+        (style, window, state_type, shadow_type, area, widget, detail, x, y,
+         width, height, gap_side);
+      DAWATI_PROBE (draw_extension_return, detail, state_type, width,
+                    height);
+      return;
     }
 
-  dawati_set_border_color (cr, style, state_type);
-  cairo_stroke (cr);
+  /* initialise the background */
+  gtk_style_apply_default_background (style, window, TRUE, state_type, area,
+                                      x, y, width, height);
+  dawati_overdraw_add_rectangle (window, area, x, y, width, height);
 
-  cairo_destroy (cr);
+  dawati_render_op_init (&op, DAWATI_ELEMENT_EXTENSION, widget, detail,
+                         state_type, shadow_type, x, y, width, height);
+  op.gap_side = gap_side;
+  dawati_draw_op (style, window, area, &op);
 
+  DAWATI_PROBE (draw_extension_return, detail, state_type, width, height);
 }
 
 static void
 dawati_draw_vline (GtkStyle     *style,
-                           GdkWindow    *window,
-                           GtkStateType  state_type,
-                           GdkRectangle *area,
-                           GtkWidget    *widget,
-                           const gchar  *detail,
-                           gint          y1,
-                           gint          y2,
-                           gint          x)
+                   GdkWindow    *window,
+                   GtkStateType  state_type,
+                   GdkRectangle *area,
+                   GtkWidget    *widget,
+                   const gchar  *detail,
+                   gint          y1,
+                   gint          y2,
+                   gint          x)
 {
-  cairo_t *cr;
-
-  if (DETAIL ("vscale") || DETAIL ("hscale"))
-    return;
+  DawatiRenderOp op;
 
-  if (DETAIL ("vseparator"))
-    return;
+  DAWATI_PROBE (draw_vline_entry, detail, state_type, 1, y2 - y1);
 
-  cr = gdk_cairo_create (window);
-
-  cairo_set_line_width (cr, LINE_WIDTH);
-  cairo_set_line_cap (cr, CAIRO_LINE_CAP_ROUND);
-
-  cairo_move_to (cr, x + LINE_WIDTH / 2.0, y1);
-  cairo_line_to (cr, x + LINE_WIDTH / 2.0, y2);
+  if (HAS_IMAGES (style))
+    {
+      GTK_STYLE_CLASS (dawati_style_parent_class)->draw_vline
+        (style, window, state_type, area, widget, detail, y1, y2, x);
+      DAWATI_PROBE (draw_vline_return, detail, state_type, 1, y2 - y1);
+      return;
+    }
 
-  dawati_set_border_color (cr, style, state_type);
-  cairo_stroke (cr);
+  dawati_render_op_init (&op, DAWATI_ELEMENT_VLINE, widget, detail,
+                         state_type, GTK_SHADOW_NONE, x, y1, 0, y2 - y1);
+  dawati_draw_op (style, window, NULL, &op);
 
-  cairo_destroy (cr);
+  DAWATI_PROBE (draw_vline_return, detail, state_type, 1, y2 - y1);
 }
 
 static void
 dawati_draw_hline (GtkStyle     *style,
-                           GdkWindow    *window,
-                           GtkStateType  state_type,
-                           GdkRectangle *area,
-                           GtkWidget    *widget,
-                           const gchar  *detail,
-                           gint          x1,
-                           gint          x2,
-                           gint          y)
+                   GdkWindow    *window,
+                   GtkStateType  state_type,
+                   GdkRectangle *area,
+                   GtkWidget    *widget,
+                   const gchar  *detail,
+                   gint          x1,
+                   gint          x2,
+                   gint          y)
 {
-  cairo_t *cr;
-
-  if (DETAIL ("vscale") || DETAIL ("hscale"))
-    return;
+  DawatiRenderOp op;
 
-  cr = gdk_cairo_create (window);
+  DAWATI_PROBE (draw_hline_entry, detail, state_type, x2 - x1, 1);
 
-  cairo_set_line_width (cr, LINE_WIDTH);
-  cairo_set_line_cap (cr, CAIRO_LINE_CAP_ROUND);
+  if (HAS_IMAGES (style))
+    {
+      GTK_STYLE_CLASS (dawati_style_parent_class)->draw_hline
+        (style, window, state_type, area, widget, detail, x1, x2, y);
+      DAWATI_PROBE (draw_hline_return, detail, state_type, x2 - x1, 1);
+      return;
+    }
 
-  dawati_set_border_color (cr, style, state_type);
-  cairo_move_to (cr, x1, y + LINE_WIDTH / 2.0);
-  cairo_line_to (cr, x2, y + LINE_WIDTH / 2.0);
-  cairo_stroke (cr);
+  dawati_render_op_init (&op, DAWATI_ELEMENT_HLINE, widget, detail,
+                         state_type, GTK_SHADOW_NONE, x1, y, x2 - x1, 0);
+  dawati_draw_op (style, window, NULL, &op);
 
-  cairo_destroy (cr);
+  DAWATI_PROBE (draw_hline_return, detail, state_type, x2 - x1, 1);
 }
 
 static void
 dawati_draw_focus (GtkStyle     *style,
-                           GdkWindow    *window,
-                           GtkStateType  state_type,
-                           GdkRectangle *area,
-                           GtkWidget    *widget,
-                           const gchar  *detail,
-                           gint          x,
-                           gint          y,
-                           gint          width,
-                           gint          height)
+                   GdkWindow    *window,
+                   GtkStateType  state_type,
+                   GdkRectangle *area,
+                   GtkWidget    *widget,
+                   const gchar  *detail,
+                   gint          x,
+                   gint          y,
+                   gint          width,
+                   gint          height)
 {
-  cairo_t *cr;
-  gint line_width;
-  DawatiStyle *mb_style = DAWATI_STYLE (style);
+  DawatiRenderOp op;
 
-  /* button draws it's own focus */
-  if (DETAIL ("button"))
-      return;
-
-  cr = gdk_cairo_create (window);
+  DAWATI_PROBE (draw_focus_entry, detail, state_type, width, height);
 
-  if (widget)
-    gtk_widget_style_get (widget, "focus-line-width", &line_width, NULL);
-  else
-    line_width = 1;
+  if (HAS_IMAGES (style))
+    {
+      GTK_STYLE_CLASS (dawati_style_parent_class)->draw_focus
+        (style, window, state_type, area, widget, detail, x, y, width, height);
+      DAWATI_PROBE (draw_focus_return, detail, state_type, width, height);
+      return;
+    }
 
-  cairo_translate (cr, line_width / 2.0, line_width / 2.0);
-  width -= line_width;
-  height -= line_width;
+  dawati_render_op_init (&op, DAWATI_ELEMENT_FOCUS, widget, detail,
+                         state_type, GTK_SHADOW_NONE, x, y, width, height);
 
-  if (mb_style->shadow)
+  /* button draws it's own focus */
+  if (op.detail == DAWATI_DETAIL_BUTTON)
     {
-      width -= 1;
-      height -= 1;
+      DAWATI_PROBE (draw_focus_return, detail, state_type, width, height);
+      return;
     }
 
-  dawati_rounded_rectangle (cr, x, y, width, height, line_width);
-  cairo_set_line_width (cr, line_width);
-  gdk_cairo_set_source_color (cr, &style->bg[GTK_STATE_SELECTED]);
-  cairo_stroke (cr);
+  if (widget)
+    gtk_widget_style_get (widget, "focus-line-width", &op.line_width, NULL);
+  else
+    op.line_width = 1;
 
-  cairo_destroy (cr);
+  dawati_draw_op (style, window, NULL, &op);
+
+  DAWATI_PROBE (draw_focus_return, detail, state_type, width, height);
 }
 
 static void
 dawati_draw_arrow (GtkStyle     *style,
-                           GdkWindow    *window,
-                           GtkStateType  state_type,
-                           GtkShadowType shadow_type,
-                           GdkRectangle *area,
-                           GtkWidget    *widget,
-                           const gchar  *detail,
-                           GtkArrowType  arrow_type,
-                           gboolean      fill,
-                           gint          x,
-                           gint          y,
-                           gint          width,
-                           gint          height)
+                   GdkWindow    *window,
+                   GtkStateType  state_type,
+                   GtkShadowType shadow_type,
+                   GdkRectangle *area,
+                   GtkWidget    *widget,
+                   const gchar  *detail,
+                   GtkArrowType  arrow_type,
+                   gboolean      fill,
+                   gint          x,
+                   gint          y,
+                   gint          width,
+                   gint          height)
 {
-  cairo_t *cr;
+  DawatiRenderOp op;
+  DawatiImageMatch match;
 
   DEBUG;
 
-  cr = dawati_cairo_create (window, area);
+  DAWATI_PROBE (draw_arrow_entry, detail, state_type, width, height);
+
+  if (dawati_has_steppers (style, widget, detail))
+    {
+      gint slider_width, stepper_size;
+      gint box_x, box_y, box_width, box_height;
 
-  cairo_set_line_width (cr, 2);
+      /* draw_box left the button out, its size is worked back from the
+       * arrow the way the pixmap engine does */
+      gtk_widget_style_get (widget, "slider-width", &slider_width,
+                            "stepper-size", &stepper_size, NULL);
 
-  cairo_set_line_cap (cr, CAIRO_LINE_CAP_ROUND);
+      if (dawati_detail_lookup (detail) == DAWATI_DETAIL_HSCROLLBAR)
+        {
+          box_width = stepper_size;
+          box_height = slider_width;
+        }
+      else
+        {
+          box_width = slider_width;
+          box_height = stepper_size;
+        }
 
-  gdk_cairo_set_source_color (cr, &style->fg[state_type]);
+      box_x = x + (width - box_width) / 2;
+      box_y = y + (height - box_height) / 2;
 
-  /* add padding around scrollbar buttons */
-  if (DETAIL ("vscrollbar") || DETAIL ("hscrollbar"))
-    {
-      x += 3;
-      width -= 4;
-      y += 3;
-      height -= 4;
-    }
+      dawati_image_match_init (&match, DAWATI_IMAGE_STEPPER, detail,
+                               state_type, shadow_type);
+      match.flags |= DAWATI_IMAGE_MATCH_ARROW_DIRECTION;
+      match.arrow_direction = arrow_type;
 
-  /* ensure we have odd number of pixels for width or height to allow for
-   * correct centering
-   */
-  if (width % 2) width--;
-  if (height % 2) height--;
+      if (dawati_draw_image (style, window, area, &match, TRUE,
+                             box_x, box_y, box_width, box_height))
+        {
+          DAWATI_PROBE (draw_arrow_return, detail, state_type, width, height);
+          return;
+        }
 
+      /* no stepper for this state, so the box and then the arrow */
+      dawati_image_match_init (&match, DAWATI_IMAGE_BOX, detail, state_type,
+                               shadow_type);
+      if (!dawati_draw_image (style, window, area, &match, TRUE,
+                              box_x, box_y, box_width, box_height))
+        GTK_STYLE_CLASS (dawati_style_parent_class)->draw_box
+          (style, window, state_type, shadow_type, area, widget, detail, box_x,
+           box_y, box_width, box_height);
+    }
 
-  switch (arrow_type)
+  dawati_image_match_init (&match, DAWATI_IMAGE_ARROW, detail, state_type,
+                           shadow_type);
+  match.flags |= DAWATI_IMAGE_MATCH_ARROW_DIRECTION;
+  match.arrow_direction = arrow_type;
+  if (dawati_draw_image (style, window, area, &match, TRUE,
+                         x, y, width, height))
     {
-    case GTK_ARROW_UP:
-      y = y + height / 2 - (width * 0.12) - 1;
-      height = width * 0.6;
-      cairo_move_to (cr, x, y + height);
-      cairo_line_to (cr, x + width / 2, y);
-      cairo_line_to (cr, x + width, y + height);
-      break;
-    case GTK_ARROW_DOWN:
-      y = y + height / 2 - (width * 0.12);
-      height = width * 0.6;
-      cairo_move_to (cr, x, y);
-      cairo_line_to (cr, x + width / 2, y + height);
-      cairo_line_to (cr, x + width, y);
-      break;
-    case GTK_ARROW_LEFT:
-      x = x + width / 2 - (height * 0.12) - 1;
-      width = height * 0.6;
-      cairo_move_to (cr, x + width, y);
-      cairo_line_to (cr, x, y + height / 2);
-      cairo_line_to (cr, x + width, y + height);
-      break;
-    case GTK_ARROW_RIGHT:
-      x = x + width / 2 - (height * 0.12);
-      width = height * 0.6;
-      cairo_move_to (cr, x, y);
-      cairo_line_to (cr, x + width, y + height / 2);
-      cairo_line_to (cr, x, y + height);
-      break;
-    case GTK_ARROW_NONE:
-      break;
+      DAWATI_PROBE (draw_arrow_return, detail, state_type, width, height);
+      return;
     }
-  cairo_stroke (cr);
-  cairo_destroy (cr);
+
+  if (HAS_IMAGES (style))
+    {
+      GTK_STYLE_CLASS (dawati_style_parent_class)->draw_arrow
+        (style, window, state_type, shadow_type, area, widget, detail,
+         arrow_type, fill, x, y, width, height);
+      DAWATI_PROBE (draw_arrow_return, detail, state_type, width, height);
+      return;
+    }
+
+  dawati_render_op_init (&op, DAWATI_ELEMENT_ARROW, widget, detail,
+                         state_type, shadow_type, x, y, width, height);
+  op.arrow_type = arrow_type;
+  dawati_draw_op (style, window, area, &op);
+
+  DAWATI_PROBE (draw_arrow_return, detail, state_type, width, height);
 }
 
 static void
 dawati_draw_handle (GtkStyle           *style,
-                            GdkWindow          *window,
-                            GtkStateType        state_type,
-                            GtkShadowType       shadow_type,
-                            GdkRectangle       *area,
-                            GtkWidget          *widget,
-                            const gchar        *detail,
-                            gint                x,
-                            gint                y,
-                            gint                width,
-                            gint                height,
-                            GtkOrientation      orientation)
+                    GdkWindow          *window,
+                    GtkStateType        state_type,
+                    GtkShadowType       shadow_type,
+                    GdkRectangle       *area,
+                    GtkWidget          *widget,
+                    const gchar        *detail,
+                    gint                x,
+                    gint                y,
+                    gint                width,
+                    gint                height,
+                    GtkOrientation      orientation)
 {
-  cairo_t *cr;
-  gdouble cx, cy, radius;
+  DawatiRenderOp op;
 
   DEBUG;
 
-  cr = dawati_cairo_create (window, area);
-
-  cx = x + width / 2;
-  cy = y + height / 2;
+  DAWATI_PROBE (draw_handle_entry, detail, state_type, width, height);
 
-  if (orientation == GTK_ORIENTATION_HORIZONTAL)
+  if (HAS_IMAGES (style))
     {
-      radius = height / 2 - 2;
-
-      cairo_arc (cr, cx, cy, radius, 0, M_PI * 360);
-      cairo_arc (cr, cx - radius * 3, cy, radius, 0, M_PI * 360);
-      cairo_arc (cr, cx + radius * 3, cy, radius, 0, M_PI * 360);
+      GTK_STYLE_CLASS (dawati_style_parent_class)->draw_handle
+        (style, window, state_type, shadow_type, area, widget, detail, x, y,
+         width, height, orientation);
+      DAWATI_PROBE (draw_handle_return, detail, state_type, width, height);
+      return;
     }
-  else
-    {
-      radius = width / 2 - 2;
 
-      cairo_arc (cr, cx, cy, radius, 0, M_PI * 360);
-      cairo_arc (cr, cx, cy - radius * 3, radius, 0, M_PI * 360);
-      cairo_arc (cr, cx, cy + radius * 3, radius, 0, M_PI * 360);
-    }
+  dawati_render_op_init (&op, DAWATI_ELEMENT_HANDLE, widget, detail,
+                         state_type, shadow_type, x, y, width, height);
+  op.orientation = orientation;
+  dawati_draw_op (style, window, area, &op);
 
-  dawati_set_border_color (cr, style, state_type);
-  cairo_fill (cr);
-  cairo_destroy (cr);
+  DAWATI_PROBE (draw_handle_return, detail, state_type, width, height);
 }
 
 static void
 dawati_draw_resize_grip (GtkStyle           *style,
-                                 GdkWindow          *window,
-                                 GtkStateType        state_type,
-                                 GdkRectangle       *area,
-                                 GtkWidget          *widget,
-                                 const gchar        *detail,
-                                 GdkWindowEdge       edge,
-                                 gint                x,
-                                 gint                y,
-                                 gint                width,
-                                 gint                height)
+                         GdkWindow          *window,
+                         GtkStateType        state_type,
+                         GdkRectangle       *area,
+                         GtkWidget          *widget,
+                         const gchar        *detail,
+                         GdkWindowEdge       edge,
+                         gint                x,
+                         gint                y,
+                         gint                width,
+                         gint                height)
 {
-  cairo_t *cr;
-  gdouble cx, cy, radius, spacing;
+  DawatiRenderOp op;
 
   DEBUG;
 
-  /* FIXME: fix other window edge types */
+  DAWATI_PROBE (draw_resize_grip_entry, detail, state_type, width, height);
 
-  cr = dawati_cairo_create (window, area);
+  if (HAS_IMAGES (style))
+    {
+      GTK_STYLE_CLASS (dawati_style_parent_class)->draw_resize_grip
+        (style, window, state_type, area, widget, detail, edge, x, y, width,
+         height);
+      DAWATI_PROBE (draw_resize_grip_return, detail, state_type, width,
+                    height);
+      return;
+    }
 
-  radius = 2;
+  dawati_render_op_init (&op, DAWATI_ELEMENT_RESIZE_GRIP, widget, detail,
+                         state_type, GTK_SHADOW_NONE, x, y, width, height);
+  op.edge = edge;
+  dawati_draw_op (style, window, area, &op);
 
-  /* bottom right */
-  cx = x + width - radius;
-  cy = y + height - radius;
+  DAWATI_PROBE (draw_resize_grip_return, detail, state_type, width, height);
+}
 
-  spacing = radius * 2 + 2;
-  gdk_cairo_set_source_color (cr, &style->bg[GTK_STATE_ACTIVE]);
+static void
+dawati_draw_flat_box (GtkStyle     *style,
+                      GdkWindow    *window,
+                      GtkStateType  state_type,
+                      GtkShadowType shadow_type,
+                      GdkRectangle *area,
+                      GtkWidget    *widget,
+                      const gchar  *detail,
+                      gint          x,
+                      gint          y,
+                      gint          width,
+                      gint          height)
+{
+  DawatiImageMatch match;
 
-  cairo_arc (cr, cx, cy - spacing * 2, radius, 0, M_PI * 360);
-  cairo_fill (cr);
+  DEBUG;
 
-  cairo_arc (cr, cx, cy - spacing, radius, 0, M_PI * 360);
-  cairo_fill (cr);
+  DAWATI_PROBE (draw_flat_box_entry, detail, state_type, width, height);
 
-  cairo_arc (cr, cx, cy, radius, 0, M_PI * 360);
-  cairo_fill (cr);
+  SANITIZE_SIZE;
+
+  dawati_image_match_init (&match, DAWATI_IMAGE_FLAT_BOX, detail, state_type,
+                           shadow_type);
+  if (!dawati_draw_image (style, window, area, &match, TRUE,
+                          x, y, width, height))
+    GTK_STYLE_CLASS (dawati_style_parent_class)->draw_flat_box
+      (style, window, state_type, shadow_type, area, widget, detail,
+       x, y, width, height);
+
+  DAWATI_PROBE (draw_flat_box_return, detail, state_type, width, height);
+}
 
-  cairo_arc (cr, cx - spacing, cy - spacing, radius, 0, M_PI * 360);
-  cairo_fill (cr);
+static void
+dawati_draw_slider (GtkStyle       *style,
+                    GdkWindow      *window,
+                    GtkStateType    state_type,
+                    GtkShadowType   shadow_type,
+                    GdkRectangle   *area,
+                    GtkWidget      *widget,
+                    const gchar    *detail,
+                    gint            x,
+                    gint            y,
+                    gint            width,
+                    gint            height,
+                    GtkOrientation  orientation)
+{
+  DawatiImageMatch match;
 
-  cairo_arc (cr, cx - spacing, cy, radius, 0, M_PI * 360);
-  cairo_fill (cr);
+  DEBUG;
 
-  cairo_arc (cr, cx - spacing * 2, cy, radius, 0, M_PI * 360);
-  cairo_fill (cr);
+  DAWATI_PROBE (draw_slider_entry, detail, state_type, width, height);
 
-  cairo_destroy (cr);
+  SANITIZE_SIZE;
+
+  dawati_image_match_init (&match, DAWATI_IMAGE_SLIDER, detail, state_type,
+                           shadow_type);
+  match.flags |= DAWATI_IMAGE_MATCH_ORIENTATION;
+  match.orientation = orientation;
+  if (!dawati_draw_image (style, window, area, &match, TRUE,
+                          x, y, width, height))
+    GTK_STYLE_CLASS (dawati_style_parent_class)->draw_slider
+      (style, window, state_type, shadow_type, area, widget, detail,
+       x, y, width, height, orientation);
+
+  DAWATI_PROBE (draw_slider_return, detail, state_type, width, height);
 }
 
 /* this function is copied from the mist gtk engine */
@@ -1132,6 +1087,18 @@ dawati_draw_layout (GtkStyle        *style,
 {
   GdkGC *gc;
 
+  /* the size of the layout isn't worked out just for the probes */
+  DAWATI_PROBE (draw_layout_entry, detail, state_type, -1, -1);
+
+  if (HAS_IMAGES (style))
+    {
+      GTK_STYLE_CLASS (dawati_style_parent_class)->draw_layout
+        (style, window, state_type, use_text, area, widget, detail, x, y,
+         layout);
+      DAWATI_PROBE (draw_layout_return, detail, state_type, -1, -1);
+      return;
+    }
+
   gc = use_text ? style->text_gc[state_type] : style->fg_gc[state_type];
 
   if (area)
@@ -1139,17 +1106,15 @@ dawati_draw_layout (GtkStyle        *style,
       gdk_gc_set_clip_rectangle (gc, area);
     }
 
-  if (DETAIL ("accellabel") && state_type == GTK_STATE_NORMAL)
+  if (dawati_detail_lookup (detail) == DAWATI_DETAIL_ACCELLABEL
+      && state_type == GTK_STATE_NORMAL)
     {
+      const DawatiColor *fg = &DAWATI_STYLE (style)->params.fg[state_type];
       cairo_t *cr;
 
       cr = dawati_cairo_create (window, area);
 
-      cairo_set_source_rgba (cr,
-                             style->fg[state_type].red / 65535.0,
-                             style->fg[state_type].green / 65535.0,
-                             style->fg[state_type].blue / 65535.0,
-                             0.5);
+      cairo_set_source_rgba (cr, fg->red, fg->green, fg->blue, 0.5);
       cairo_move_to (cr, x, y);
       pango_cairo_show_layout (cr, layout);
       cairo_stroke (cr);
@@ -1164,62 +1129,58 @@ dawati_draw_layout (GtkStyle        *style,
     {
       gdk_gc_set_clip_rectangle (gc, NULL);
     }
-}
-
-/* this function is copied from the mist gtk engine */
-static GdkPixbuf *
-set_transparency (const GdkPixbuf *pixbuf, gdouble alpha_percent)
-{
-  GdkPixbuf *target;
-  guchar *data, *current;
-  guint x, y, rowstride, height, width;
-
-  g_return_val_if_fail (pixbuf != NULL, NULL);
-  g_return_val_if_fail (GDK_IS_PIXBUF (pixbuf), NULL);
-
-  /* Returns a copy of pixbuf with it's non-completely-transparent pixels to
-     have an alpha level "alpha_percent" of their original value. */
-
-  target = gdk_pixbuf_add_alpha (pixbuf, FALSE, 0, 0, 0);
 
-  if (alpha_percent == 1.0)
-    return target;
-  width = gdk_pixbuf_get_width (target);
-  height = gdk_pixbuf_get_height (target);
-  rowstride = gdk_pixbuf_get_rowstride (target);
-  data = gdk_pixbuf_get_pixels (target);
-
-  for (y = 0; y < height; y++)
-    {
-      for (x = 0; x < width; x++)
-        {
-          /* The "4" is the number of chars per pixel, in this case, RGBA,
-             the 3 means "skip to the alpha" */
-          current = data + (y * rowstride) + (x * 4) + 3;
-          *(current) = (guchar) (*(current) * alpha_percent);
-        }
-    }
-
-  return target;
+  DAWATI_PROBE (draw_layout_return, detail, state_type, -1, -1);
 }
 
-/* this function is copied from the mist gtk engine */
+/* Scaling down goes through a pyramid of halved copies of the source, made
+ * when first needed and kept in the icon cache, so that the last step is
+ * never more than a halving and large icons don't alias in menus. */
 static GdkPixbuf*
 scale_or_ref (GdkPixbuf *src,
               int width,
               int height)
 {
+  GdkPixbuf *level;
+  GdkPixbuf *scaled;
+
   if (width == gdk_pixbuf_get_width (src) &&
       height == gdk_pixbuf_get_height (src))
     {
       return g_object_ref (src);
     }
-  else
+
+  level = g_object_ref (src);
+
+  while (gdk_pixbuf_get_width (level) / 2 >= width
+         && gdk_pixbuf_get_height (level) / 2 >= height)
     {
-      return gdk_pixbuf_scale_simple (src,
-                                      width, height,
-                                      GDK_INTERP_BILINEAR);
+      gint level_width = gdk_pixbuf_get_width (level) / 2;
+      gint level_height = gdk_pixbuf_get_height (level) / 2;
+      GdkPixbuf *next;
+
+      next = dawati_icon_cache_lookup (src, level_width, level_height,
+                                       DAWATI_ICON_CACHE_MIP);
+      if (!next)
+        {
+          next = dawati_pixbuf_halve (level);
+          dawati_icon_cache_insert (src, level_width, level_height,
+                                    DAWATI_ICON_CACHE_MIP, next);
+        }
+
+      g_object_unref (level);
+      level = next;
     }
+
+  if (width == gdk_pixbuf_get_width (level) &&
+      height == gdk_pixbuf_get_height (level))
+    return level;
+
+  scaled = gdk_pixbuf_scale_simple (level, width, height,
+                                    GDK_INTERP_BILINEAR);
+  g_object_unref (level);
+
+  return scaled;
 }
 
 /* this function is copied from the mist gtk engine */
@@ -1239,12 +1200,28 @@ dawati_render_icon (GtkStyle            *style,
   GdkPixbuf *base_pixbuf;
   GdkScreen *screen;
   GtkSettings *settings;
+  gboolean scale;
+  gboolean restate;
+  GtkStateType cache_state;
 
   /* Oddly, style can be NULL in this function, because
    * GtkIconSet can be used without a style and if so
    * it uses this function.
    */
 
+  /* the size is only known once it has been looked up */
+  DAWATI_PROBE (render_icon_entry, detail, state, -1, -1);
+
+  if (style && HAS_IMAGES (style))
+    {
+      GdkPixbuf *pixbuf;
+
+      pixbuf = GTK_STYLE_CLASS (dawati_style_parent_class)->render_icon
+        (style, source, direction, state, size, widget, detail);
+      DAWATI_PROBE (render_icon_return, detail, state, -1, -1);
+      return pixbuf;
+    }
+
   base_pixbuf = gtk_icon_source_get_pixbuf (source);
 
   g_return_val_if_fail (base_pixbuf != NULL, NULL);
@@ -1271,120 +1248,124 @@ dawati_render_icon (GtkStyle            *style,
       && !gtk_icon_size_lookup_for_settings (settings, size, &width, &height))
     {
       g_warning (G_STRLOC ": invalid icon size '%d'", size);
+      DAWATI_PROBE (render_icon_return, detail, state, -1, -1);
       return NULL;
     }
 
   /* If the size was wildcarded, and we're allowed to scale, then scale;
    * otherwise, leave it alone.
    */
-  if (size != (GtkIconSize)-1 && gtk_icon_source_get_size_wildcarded (source))
+  scale = size != (GtkIconSize)-1
+    && gtk_icon_source_get_size_wildcarded (source);
+  if (!scale)
+    {
+      width = gdk_pixbuf_get_width (base_pixbuf);
+      height = gdk_pixbuf_get_height (base_pixbuf);
+    }
+
+  /* If the state was wildcarded, then generate a state. */
+  restate = gtk_icon_source_get_state_wildcarded (source)
+    && (state == GTK_STATE_INSENSITIVE || state == GTK_STATE_PRELIGHT);
+  cache_state = restate ? state : GTK_STATE_NORMAL;
+
+  /* the same icons are asked for again every time a widget changes state */
+  stated = dawati_icon_cache_lookup (base_pixbuf, width, height, cache_state);
+  if (stated)
+    {
+      DAWATI_PROBE (render_icon_return, detail, state, width, height);
+      return stated;
+    }
+
+  if (scale)
     scaled = scale_or_ref (base_pixbuf, width, height);
   else
     scaled = g_object_ref (base_pixbuf);
 
-  /* If the state was wildcarded, then generate a state. */
-  if (gtk_icon_source_get_state_wildcarded (source))
+  /* faded and desaturated, or saturated, in one pass */
+  if (restate)
     {
       if (state == GTK_STATE_INSENSITIVE)
-        {
-          stated = set_transparency (scaled, 0.3);
-          gdk_pixbuf_saturate_and_pixelate (stated, stated,
-                                            0.1, FALSE);
-
-          g_object_unref (scaled);
-        }
-      else if (state == GTK_STATE_PRELIGHT)
-        {
-          stated = gdk_pixbuf_copy (scaled);
-
-          gdk_pixbuf_saturate_and_pixelate (scaled, stated,
-                                            1.2, FALSE);
-
-          g_object_unref (scaled);
-        }
+        stated = dawati_pixbuf_transform (scaled, 0.3, 0.1, TRUE);
       else
-        {
-          stated = scaled;
-        }
+        stated = dawati_pixbuf_transform (scaled, 1.0, 1.2, FALSE);
+
+      g_object_unref (scaled);
     }
   else
     stated = scaled;
 
+  dawati_icon_cache_insert (base_pixbuf, width, height, cache_state, stated);
+
+  DAWATI_PROBE (render_icon_return, detail, state,
+                gdk_pixbuf_get_width (stated),
+                gdk_pixbuf_get_height (stated));
+
   return stated;
 }
 
+
 static void
 dawati_draw_expander (GtkStyle         *style,
-                              GdkWindow        *window,
-                              GtkStateType      state_type,
-                              GdkRectangle     *area,
-                              GtkWidget        *widget,
-                              const gchar      *detail,
-                              gint              x,
-                              gint              y,
-                              GtkExpanderStyle  expander_style)
+                      GdkWindow        *window,
+                      GtkStateType      state_type,
+                      GdkRectangle     *area,
+                      GtkWidget        *widget,
+                      const gchar      *detail,
+                      gint              x,
+                      gint              y,
+                      GtkExpanderStyle  expander_style)
 {
-  cairo_t *cr;
-
-  cr = dawati_cairo_create (window, area);
-
-  x -= 6;
-  y -= 6;
-
-
-  cairo_set_source_rgb (cr, 0.6, 0.6, 0.6);
-  cairo_set_line_width (cr, 1.0);
-  dawati_rounded_rectangle (cr, x, y, 12, 12, 2 );
-  cairo_stroke_preserve (cr);
-
-  if (state_type == GTK_STATE_PRELIGHT || state_type == GTK_STATE_ACTIVE)
-    cairo_set_source_rgba (cr, 0, 0.6, 0.8, 1);
-  else
-    cairo_set_source_rgba (cr, 1, 1, 1, 1);
-
-  cairo_fill (cr);
-
-  if (state_type == GTK_STATE_PRELIGHT || state_type == GTK_STATE_ACTIVE)
-    cairo_set_source_rgba (cr, 1, 1, 1, 1);
-  else
-    cairo_set_source_rgba (cr, 0, 0.6, 0.8, 1);
-
-  cairo_set_line_width (cr, 2.0);
-  cairo_move_to (cr, x + 2, y + 6);
-  cairo_line_to (cr, x + 10, y + 6);
-  cairo_stroke (cr);
-
-  if (expander_style != GTK_EXPANDER_EXPANDED)
+  DawatiRenderOp op;
+  DawatiImageMatch match;
+  gint size = 0;
+
+  /* x and y are the centre, the size is a style property of the widget */
+  DAWATI_PROBE (draw_expander_entry, detail, state_type, -1, -1);
+
+  if (widget && gtk_widget_class_find_style_property
+      (GTK_WIDGET_GET_CLASS (widget), "expander-size"))
+    gtk_widget_style_get (widget, "expander-size", &size, NULL);
+
+  dawati_image_match_init (&match, DAWATI_IMAGE_EXPANDER, detail, state_type,
+                           GTK_SHADOW_NONE);
+  match.flags = DAWATI_IMAGE_MATCH_STATE | DAWATI_IMAGE_MATCH_EXPANDER_STYLE;
+  match.expander_style = expander_style;
+  if (size > 0
+      && dawati_draw_image (style, window, area, &match, TRUE,
+                            x - size / 2, y - size / 2, size, size))
     {
-      if (expander_style == GTK_EXPANDER_SEMI_COLLAPSED
-          || expander_style == GTK_EXPANDER_SEMI_EXPANDED)
-        {
-          if (state_type == GTK_STATE_PRELIGHT
-              || state_type == GTK_STATE_ACTIVE)
-            cairo_set_source_rgba (cr, 1, 1, 1, 0.5);
-          else
-            cairo_set_source_rgba (cr, 0, 0.6, 0.8, 0.5);
-        }
+      DAWATI_PROBE (draw_expander_return, detail, state_type, -1, -1);
+      return;
+    }
 
-      cairo_move_to (cr, x + 6, y + 2);
-      cairo_line_to (cr, x + 6, y + 10);
-      cairo_stroke (cr);
+  if (HAS_IMAGES (style))
+    {
+      GTK_STYLE_CLASS (dawati_style_parent_class)->draw_expander
+        (style, window, state_type, area, widget, detail, x, y,
+         expander_style);
+      DAWATI_PROBE (draw_expander_return, detail, state_type, -1, -1);
+      return;
     }
 
-  cairo_destroy (cr);
+  dawati_render_op_init (&op, DAWATI_ELEMENT_EXPANDER, widget, detail,
+                         state_type, GTK_SHADOW_NONE, x, y, size, size);
+  op.expander_style = expander_style;
+  dawati_draw_op (style, window, area, &op);
+
+  DAWATI_PROBE (draw_expander_return, detail, state_type, -1, -1);
 }
 
 
 static void
 dawati_init_from_rc (GtkStyle   *style,
-                             GtkRcStyle *rc_style)
+                     GtkRcStyle *rc_style)
 {
   int i;
   DawatiStyle *mb_style;
   DawatiRcStyle *mb_rc_style;
 
   GTK_STYLE_CLASS (dawati_style_parent_class)->init_from_rc (style,
-                                                                     rc_style);
+                                                             rc_style);
 
   mb_rc_style = DAWATI_RC_STYLE (rc_style);
   mb_style = DAWATI_STYLE (style);
@@ -1395,16 +1376,23 @@ dawati_init_from_rc (GtkStyle   *style,
     mb_style->border_color[i] = mb_rc_style->border_color[i];
 
   mb_style->shadow = mb_rc_style->shadow;
+
+  dawati_image_list_free (mb_style->images);
+  mb_style->images = dawati_image_list_copy (mb_rc_style->images);
+
+  dawati_style_update_params (mb_style);
 }
 
 static void
 dawati_style_copy (GtkStyle *dest,
-                           GtkStyle *src)
+                   GtkStyle *src)
 {
   int i;
   DawatiStyle *mb_dest = DAWATI_STYLE (dest);
   DawatiStyle *mb_src = DAWATI_STYLE (src);
 
+  GTK_STYLE_CLASS (dawati_style_parent_class)->copy (dest, src);
+
   mb_dest->radius = mb_src->radius;
 
   for (i = 0; i < 5; i++)
@@ -1412,14 +1400,47 @@ dawati_style_copy (GtkStyle *dest,
 
   mb_dest->shadow = mb_src->shadow;
 
-  GTK_STYLE_CLASS (dawati_style_parent_class)->copy (dest, src);
+  dawati_image_list_free (mb_dest->images);
+  mb_dest->images = dawati_image_list_copy (mb_src->images);
+
+  dawati_style_update_params (mb_dest);
+}
+
+/* Styles are often copied and given new colours before they are set on a
+ * widget, which realizes them. Only a change of colours takes a new serial,
+ * so that the cached renderings survive realizing an unchanged style. */
+static void
+dawati_style_realize (GtkStyle *style)
+{
+  DawatiStyle *mb_style = DAWATI_STYLE (style);
+  DawatiRenderParams params = mb_style->params;
+
+  GTK_STYLE_CLASS (dawati_style_parent_class)->realize (style);
+
+  dawati_style_fill_params (mb_style, &params);
+  if (!dawati_palette_equal (&params, &mb_style->params))
+    dawati_style_update_params (mb_style);
+}
+
+static void
+dawati_style_finalize (GObject *object)
+{
+  DawatiStyle *mb_style = DAWATI_STYLE (object);
+
+  dawati_render_forget (mb_style->params.serial);
+  dawati_image_list_free (mb_style->images);
+
+  G_OBJECT_CLASS (dawati_style_parent_class)->finalize (object);
 }
 
 static void
 dawati_style_class_init (DawatiStyleClass *klass)
 {
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
   GtkStyleClass *style_class = GTK_STYLE_CLASS (klass);
   const gchar *debug;
+  const gchar *record;
+  const gchar *overdraw;
 
   /* Set debugging if required. We only need to do this once per instance, so
    * it is safe to do in the class-init */
@@ -1427,26 +1448,51 @@ dawati_style_class_init (DawatiStyleClass *klass)
   if (debug)
     do_debug = atoi (debug);
 
+  /* report the cache usage so that its size can be tuned, on stderr so
+   * that it stays apart from the JSON statistics */
+  if (do_debug)
+    {
+      atexit (dawati_render_print_stats);
+      atexit (dawati_icon_cache_print_stats);
+      atexit (dawati_image_print_stats);
+    }
+
+  /* keep what is drawn, to be replayed with dawati-replay */
+  record = getenv ("DAWATI_ENGINE_RECORD");
+  if (record)
+    dawati_record_open (record);
 
+  /* count how many times each pixel is painted */
+  overdraw = getenv ("DAWATI_ENGINE_OVERDRAW");
+  if (overdraw)
+    dawati_overdraw_open (overdraw);
+
+  object_class->finalize = dawati_style_finalize;
+
+  style_class->realize = dawati_style_realize;
   style_class->init_from_rc = dawati_init_from_rc;
   style_class->copy = dawati_style_copy;
 
   style_class->draw_shadow = dawati_draw_shadow;
   style_class->draw_box = dawati_draw_box;
+  style_class->draw_flat_box = dawati_draw_flat_box;
   style_class->draw_check = dawati_draw_check;
   style_class->draw_option = dawati_draw_option;
   style_class->draw_box_gap = dawati_draw_box_gap;
-  style_class->draw_shadow_gap = dawati_draw_box_gap;
+  style_class->draw_shadow_gap = dawati_draw_shadow_gap;
   style_class->draw_extension = dawati_draw_extension;
   style_class->draw_hline = dawati_draw_hline;
   style_class->draw_vline = dawati_draw_vline;
   style_class->draw_focus = dawati_draw_focus;
   style_class->draw_arrow = dawati_draw_arrow;
   style_class->draw_handle = dawati_draw_handle;
+  style_class->draw_slider = dawati_draw_slider;
   style_class->draw_resize_grip = dawati_draw_resize_grip;
   style_class->draw_layout = dawati_draw_layout;
   style_class->render_icon = dawati_render_icon;
   style_class->draw_expander = dawati_draw_expander;
+
+  dawati_debug_install (style_class, do_debug);
 }
 
 static void
@@ -1457,4 +1503,5 @@ dawati_style_class_finalize (DawatiStyleClass *klass)
 static void
 dawati_style_init (DawatiStyle *style)
 {
+  dawati_style_update_params (style);
 }
@@ -23,6 +23,9 @@
 
 #include <gtk/gtk.h>
 
+#include "dawati-render.h"
+#include "dawati-image.h"
+
 #define DRAW_ARGS    GtkStyle       *style, \
   GdkWindow      *window, \
   GtkStateType state_type, \
@@ -76,7 +79,11 @@ struct _DawatiStyle
   gint radius;
   GdkColor border_color[5];
   gdouble shadow;
+  GSList *images;   /* of DawatiImage, from the rc style */
 
+  /* the style resolved for the drawing code, renewed whenever the style is
+   * initialised, copied or realized */
+  DawatiRenderParams params;
 };
 
 struct _DawatiStyleClass
@@ -18,7 +18,7 @@
  *
  */
 
-#include <gtk/gtk.h>
+#include "dawati-utils.h"
 
 /*
    Shading routines taken from gtkstyle.c
@@ -36,33 +36,47 @@ dawati_shade_colour (GdkColor *a,
                      GdkColor *b,
                      gdouble   k)
 {
-  gdouble red;
-  gdouble green;
-  gdouble blue;
+  dawati_shade_colours (a, 1, &k, 1, b);
+}
 
-  red = (gdouble) a->red / 65535.0;
-  green = (gdouble) a->green / 65535.0;
-  blue = (gdouble) a->blue / 65535.0;
+/* Shades each of the n colours by each of the factors, converting every
+ * colour to HLS once. The shade of colors[i] by factors[j] goes to
+ * shaded[i * n_factors + j]. */
+void
+dawati_shade_colours (const GdkColor *colors,
+                      guint           n,
+                      const gdouble  *factors,
+                      guint           n_factors,
+                      GdkColor       *shaded)
+{
+  guint i, j;
+
+  for (i = 0; i < n; i++)
+    {
+      gdouble hue;
+      gdouble lightness;
+      gdouble saturation;
 
-  rgb_to_hls (&red, &green, &blue);
+      hue = (gdouble) colors[i].red / 65535.0;
+      lightness = (gdouble) colors[i].green / 65535.0;
+      saturation = (gdouble) colors[i].blue / 65535.0;
 
-  green *= k;
-  if (green > 1.0)
-    green = 1.0;
-  else if (green < 0.0)
-    green = 0.0;
+      rgb_to_hls (&hue, &lightness, &saturation);
 
-  blue *= k;
-  if (blue > 1.0)
-    blue = 1.0;
-  else if (blue < 0.0)
-    blue = 0.0;
+      for (j = 0; j < n_factors; j++)
+        {
+          GdkColor *b = &shaded[i * n_factors + j];
+          gdouble red = hue;
+          gdouble green = CLAMP (lightness * factors[j], 0.0, 1.0);
+          gdouble blue = CLAMP (saturation * factors[j], 0.0, 1.0);
 
-  hls_to_rgb (&red, &green, &blue);
+          hls_to_rgb (&red, &green, &blue);
 
-  b->red = red * 65535.0;
-  b->green = green * 65535.0;
-  b->blue = blue * 65535.0;
+          b->red = red * 65535.0;
+          b->green = green * 65535.0;
+          b->blue = blue * 65535.0;
+        }
+    }
 }
 
 static void
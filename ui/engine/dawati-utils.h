@@ -21,4 +21,9 @@
 #include <gtk/gtk.h>
 
 void dawati_shade_colour (GdkColor *a, GdkColor *b, gdouble k);
+void dawati_shade_colours (const GdkColor *colors,
+                           guint           n,
+                           const gdouble  *factors,
+                           guint           n_factors,
+                           GdkColor       *shaded);
 